@@ -8,10 +8,20 @@ typedef struct {
 typedef struct {
     int width, height;
     RGBColor *pixels;
+    unsigned char *alpha;   // 可选 alpha 通道（NULL 表示不透明图像）
 } Image;
 
+// 像素初始为黑色；尺寸不为正或内存不足时返回 NULL
 Image* create_image(int width, int height);
 void free_image(Image *img);
 void set_pixel(Image *img, int x, int y, RGBColor color);
 
-#endif
\ No newline at end of file
+// 为图像分配 alpha 通道，初始全透明；成功返回 1
+int image_enable_alpha(Image *img);
+
+// 批量填充：长区间用倍增 memcpy 复制已写好的像素，由 libc 的向量化拷贝完成
+void image_fill(Image *img, RGBColor color);
+void image_fill_rect(Image *img, int x0, int y0, int x1, int y1, RGBColor color);
+void image_fill_span(Image *img, int y, int x0, int x1, RGBColor color);
+
+#endif
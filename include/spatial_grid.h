@@ -0,0 +1,53 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+// 均匀网格空间索引：按包围盒把条目编号登记到覆盖的格子里，
+// 区域查询只访问与查询框相交的格子。编号即 z 序，查询结果按编号升序返回
+
+typedef struct {
+    float x0, y0, x1, y1;
+} GridBox;
+
+typedef struct {
+    int *ids;
+    int count, capacity;
+} GridCell;
+
+typedef struct {
+    float origin_x, origin_y;   // 网格范围左上角，范围外的条目落在边缘格子
+    float cell_w, cell_h;
+    int cols, rows;
+    GridCell *cells;
+
+    GridBox *boxes;             // 按编号索引的包围盒
+    unsigned char *live;        // 编号是否在索引中
+    int box_capacity;
+    int count;                  // 索引中的条目数
+
+    GridCell big;               // 跨越格子过多的大条目单独存放，每次查询都检查
+} SpatialGrid;
+
+// 覆盖 [x0,x1) x [y0,y1)，按预计条目数选择格子大小
+SpatialGrid *spatial_grid_create(float x0, float y0, float x1, float y1, int expected_items);
+void spatial_grid_free(SpatialGrid *grid);
+
+// 批量建立：boxes[i] 为编号 i 的包围盒，x0 > x1 的空盒不登记。
+// 先统计每格条目数再一次性分配，比逐个插入快
+SpatialGrid *spatial_grid_build(const GridBox *boxes, int count,
+                                float x0, float y0, float x1, float y1);
+
+// 登记条目，编号为非负整数，已存在时等同于移动，成功返回 1
+int spatial_grid_insert(SpatialGrid *grid, int id, const GridBox *box);
+// 删除条目，不存在时返回 0
+int spatial_grid_remove(SpatialGrid *grid, int id);
+// 更新条目的包围盒；覆盖的格子不变时只改包围盒
+int spatial_grid_move(SpatialGrid *grid, int id, const GridBox *box);
+int spatial_grid_contains(const SpatialGrid *grid, int id);
+
+// 查询与 box 相交的条目，按编号升序写入 *out（按需扩容），返回个数，内存不足返回 -1。
+// 查询只读，多个线程可以各自使用自己的 out 缓冲区并发查询
+int spatial_grid_query(const SpatialGrid *grid, const GridBox *box, int **out, int *out_capacity);
+// 包围盒包含点 (x, y) 的条目，最后一个即最上层
+int spatial_grid_query_point(const SpatialGrid *grid, float x, float y, int **out, int *out_capacity);
+
+#endif
@@ -0,0 +1,97 @@
+#ifndef SVG_DISPLAY_LIST_H
+#define SVG_DISPLAY_LIST_H
+
+#include "image.h"
+#include "svg_raster.h"
+#include "spatial_grid.h"
+
+// 显示列表：文档编译后的扁平绘制命令数组。
+// 几何已完成变换（文档坐标）、颜色已解析、包围盒已按 1:1 输出预先计算，
+// 编译一次即可在任意输出尺寸下反复回放
+typedef struct DisplayList {
+    RenderPrimitive *cmds;
+    int count, capacity;
+    float width, height;   // 文档画布尺寸
+} DisplayList;
+
+// 回放视图：输出像素坐标 = 文档坐标 * scale + offset
+typedef struct {
+    float scale_x, scale_y;
+    float offset_x, offset_y;
+} DisplayListView;
+
+// 文档坐标中的矩形窗口
+typedef struct {
+    float x, y, w, h;
+} DisplayListRect;
+
+DisplayList *display_list_create(float width, float height);
+void display_list_free(DisplayList *dl);
+void display_list_clear(DisplayList *dl);
+
+// 追加命令，成功返回 1
+int display_list_push(DisplayList *dl, const RenderPrimitive *cmd);
+int display_list_add_rect(DisplayList *dl, float x, float y, float w, float h, RGBColor color);
+int display_list_add_circle(DisplayList *dl, float cx, float cy, float r, RGBColor color);
+int display_list_add_line(DisplayList *dl, float x1, float y1, float x2, float y2, RGBColor color);
+
+DisplayListView display_list_view_identity(void);
+// 把整个文档拉伸到 out_w x out_h 的输出
+DisplayListView display_list_view_fit(const DisplayList *dl, int out_w, int out_h);
+// 把文档窗口 region 映射到整幅 out_w x out_h 输出
+DisplayListView display_list_view_region(const DisplayListRect *region, int out_w, int out_h);
+int display_list_view_is_identity(const DisplayListView *view);
+
+// 视图下可能落在 out_w x out_h 输出内的命令，按文档坐标包围盒判断（保守，不会漏掉）。
+// 视图缩放必须为正
+typedef struct {
+    float x0, y0, x1, y1;   // 文档坐标下的可见窗口
+    float rx, ry;           // 圆半径折算到各轴的系数
+} DisplayListCull;
+
+// 命令在文档坐标中的范围 [x0,y0,x1,y1]，rx/ry 为圆半径在两轴上的系数（等比视图为 1）。
+// 空命令返回 0
+int display_list_cmd_extent(const RenderPrimitive *cmd, float rx, float ry, float ext[4]);
+
+// 为编号 first 及之后的命令批量建立空间索引（文档坐标，等比视图），
+// 网格覆盖 area；查询结果是命令编号，可直接交给 display_list_render_ids
+SpatialGrid *display_list_build_index(const DisplayList *dl, int first, const DisplayListRect *area);
+
+void display_list_cull_init(DisplayListCull *cull, const DisplayListView *view, int out_w, int out_h);
+int display_list_cmd_visible(const RenderPrimitive *cmd, const DisplayListCull *cull);
+
+// 把一条命令变换到视图的输出像素空间，并重新计算包围盒
+void display_list_transform_cmd(const RenderPrimitive *cmd, const DisplayListView *view,
+                                RenderPrimitive *out);
+
+// 串行回放；view 为 NULL 时按 1:1 输出，bg 为 NULL 时为白色背景。
+// 视图不是 1:1 时先按包围盒剔除不可见命令，再变换和光栅化
+void display_list_render(const DisplayList *dl, Image *img, const DisplayListView *view,
+                         const RenderBackground *bg);
+
+// 只回放 ids 中的命令（升序，即 z 序），用于配合空间索引的查询结果
+void display_list_render_ids(const DisplayList *dl, Image *img, const DisplayListView *view,
+                             const RenderBackground *bg, const int *ids, int count);
+
+// 只重绘 img 的 area 部分（NULL 为整幅）：按 bg 清除后画 ids 中的命令（升序；
+// 为 NULL 时画全部）。ids 须包含 area 内所有可见命令，结果与整幅回放的同一区域逐像素一致
+void display_list_render_area(const DisplayList *dl, Image *img, const DisplayListView *view,
+                              const PixelRect *area, const RenderBackground *bg,
+                              const int *ids, int count);
+
+// 拾取缓冲：和输出同尺寸的图像，每像素记录最上层命令的编号。
+// 编号 + 1 编码在 RGB 的 24 位里，0 为空白；与显示共用光栅化，命中和所见逐像素一致
+#define DISPLAY_LIST_PICK_MAX 0xFFFFFE
+
+// 重绘拾取缓冲的 area 部分，参数同 display_list_render_area
+void display_list_render_pick(const DisplayList *dl, Image *pick, const DisplayListView *view,
+                              const PixelRect *area, const int *ids, int count);
+// 像素 (x, y) 处最上层命令的编号，空白或越界返回 -1
+int display_list_pick(const Image *pick, int x, int y);
+
+// 只渲染文档窗口 region，整幅 img 对应这个窗口。窗口外的命令按包围盒跳过，
+// 这一步仍是 O(命令数)；反复查询同一文档时改用 display_list_build_index + display_list_render_ids
+void display_list_render_region(const DisplayList *dl, Image *img, const DisplayListRect *region,
+                                const RenderBackground *bg);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef SVG_GUI_EXPORT_H
+#define SVG_GUI_EXPORT_H
+
+#include <SDL.h>
+#include "svg_gui_types.h"
+
+// 导出线程推送的用户事件：code 为 EXPORT_EVENT_PROGRESS 或 EXPORT_EVENT_DONE
+#define EXPORT_EVENT_PROGRESS 0
+#define EXPORT_EVENT_DONE 1
+
+// 后台导出任务：工作线程只读自己持有的文档快照，界面线程照常编辑。
+// 进度和完成都通过 SDL 用户事件通知界面线程
+typedef struct {
+    SDL_Thread* thread;
+    SvgDocument* snapshot;
+    SvgExportFormat format;
+    char filename[300];
+    Uint32 event_type;        // SDL_RegisterEvents 分配的事件类型
+    SDL_atomic_t progress;    // 0..100
+    int ok;                   // 线程结束后有效
+} ExportJob;
+
+// 事件类型在首次导出前注册一次
+int export_job_init(ExportJob* job);
+int export_job_busy(const ExportJob* job);
+// 对 doc 取快照（O(1)，与文档共享槽位块）并启动导出线程，已有导出在进行或失败时返回 0
+int export_job_start(ExportJob* job, const SvgDocument* doc, SvgExportFormat format, const char* filename);
+// 收到完成事件（或退出时）回收线程和快照，返回导出是否成功
+int export_job_finish(ExportJob* job);
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef SVG_GUI_LOAD_H
+#define SVG_GUI_LOAD_H
+
+#include <SDL.h>
+#include "svg_gui_types.h"
+
+// 载入线程推送的用户事件：有新的一批图形，或解析结束
+#define LOAD_EVENT_BATCH 0
+#define LOAD_EVENT_DONE 1
+
+// 后台载入任务：工作线程流式解析 SVG，每攒够一批图形放入共享队列；
+// 界面线程按时间预算分片取出并加入文档，画布随之逐步显示，期间界面照常响应
+typedef struct {
+    SDL_Thread* thread;
+    SDL_mutex* lock;
+    char filename[300];
+    Uint32 event_type;        // SDL_RegisterEvents 分配的事件类型
+    SDL_atomic_t cancel;      // 置位后工作线程尽快结束
+    SDL_atomic_t progress;    // 已读字节的百分比 0..100
+
+    // 以下由 lock 保护
+    SvgShape* incoming;       // 已解析、界面线程还没取走的图形
+    int incoming_count, incoming_capacity;
+    int waiting;              // 界面线程已取空，下一批到达时推送事件唤醒它
+    int finished;             // 工作线程已结束
+    double width, height;     // <svg> 的画布尺寸，没有读到时为 0，先于第一批图形写入
+
+    // 以下只由界面线程访问
+    SvgShape* draining;       // 与 incoming 交换得到，逐片取用
+    int drain_count, drain_next, drain_capacity;
+    int ok;                   // 线程结束后有效
+    long shapes;              // 已取出的图形数
+} LoadJob;
+
+// 事件类型和锁在首次载入前创建一次
+int load_job_init(LoadJob* job);
+void load_job_free(LoadJob* job);
+int load_job_busy(const LoadJob* job);
+// 启动载入线程，已有载入在进行或失败时返回 0
+int load_job_start(LoadJob* job, const char* filename);
+// 请求取消，之后调用 load_job_finish 回收
+void load_job_cancel(LoadJob* job);
+// 取出最多 max 个已解析的图形，返回个数，指针在下次调用前有效。
+// *done 为 1 表示解析已结束且全部取完。取到过图形后 width/height 可以读取
+int load_job_take(LoadJob* job, const SvgShape** shapes, int max, int* done);
+// 回收线程和缓冲，返回是否完整载入（取消或读失败为 0）
+int load_job_finish(LoadJob* job);
+
+#endif
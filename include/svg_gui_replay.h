@@ -0,0 +1,62 @@
+#ifndef SVG_GUI_REPLAY_H
+#define SVG_GUI_REPLAY_H
+
+#include <stdio.h>
+#include <SDL.h>
+#include "svg_gui_types.h"
+
+// 输入轨迹：每行一个事件，"毫秒 类型 参数"，# 开头为注释
+//   <ms> down <x> <y> <button> <mod>    <ms> up <x> <y> <button> <mod>
+//   <ms> motion <x> <y>                 <ms> wheel <dy>
+//   <ms> key <sym> <mod>
+// 鼠标按键行的 <mod> 可省略（视为 0），旧轨迹仍可回放
+typedef struct {
+    Uint32 time;            // 相对轨迹开始的毫秒数
+    SDL_Event event;
+    Uint16 mod;             // 鼠标按键时的修饰键。按键事件本身不带，回放时写回 SDL 的全局状态
+} ReplayEvent;
+
+// 录制或回放一段输入。回放时把到期的事件推入 SDL 事件队列，
+// 统计每帧耗时、事件到呈现的延迟和每帧分配次数
+typedef struct {
+    FILE* record;           // 录制输出，NULL 表示不录制
+    Uint32 record_start;
+
+    int replaying;
+    ReplayEvent* events;
+    int count, next;
+    int realtime;           // 按轨迹时间注入；否则每帧推进一个帧间隔，尽快跑完
+    Uint32 clock;           // 已注入到的轨迹时间
+    Uint32 start_ticks;
+    Uint64 start;
+
+    Uint64* pending;        // 已注入、还没呈现的事件的注入时刻
+    int pending_count, pending_capacity;
+    double* latency;        // 事件到呈现的延迟（毫秒）
+    int latency_count, latency_capacity;
+    double* frame_ms;       // 每帧绘制加呈现的耗时
+    double* frame_allocs;   // 每帧的分配次数
+    int frames, frame_capacity;
+    long allocs_mark;
+} ReplaySession;
+
+// 开始录制到 path，失败返回 0
+int replay_record_open(ReplaySession* session, const char* path);
+// 录制一个输入事件，其它类型忽略
+void replay_record_event(ReplaySession* session, const SDL_Event* event);
+
+// 读入轨迹，失败返回 0
+int replay_load(ReplaySession* session, const char* path, int realtime);
+// 把到期的事件推入事件队列，返回距下一个事件到期的毫秒数（没有了返回 -1）
+int replay_pump(ReplaySession* session);
+#define replay_done(session) ((session)->next >= (session)->count)
+// 一帧呈现之后调用，frame_ms 为这一帧的耗时
+void replay_frame(ReplaySession* session, double frame_ms);
+// 输出回放统计和文档校验和
+void replay_report(ReplaySession* session, const SvgDocument* doc);
+void replay_free(ReplaySession* session);
+
+// 进程启动以来的分配次数，构建时没有包装分配函数则返回 -1
+long replay_allocations(void);
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef SVG_GUI_TEXT_H
+#define SVG_GUI_TEXT_H
+
+#include <SDL.h>
+#include <SDL_ttf.h>
+
+#define TEXT_CACHE_SIZE 64
+#define GLYPH_ATLAS_MAX 4
+// 图集里的字符：坐标数值和十六进制颜色
+#define GLYPH_ATLAS_CHARS "0123456789.-#ABCDEFabcdef"
+
+// 一段文字的纹理，按 (字体, 文字, 颜色) 查找
+typedef struct {
+    TTF_Font* font;
+    char* text;
+    SDL_Color color;
+    SDL_Texture* texture;
+    int w, h;
+    unsigned int last_used;
+} TextEntry;
+
+// 字形图集：一组字符渲染在同一张纹理上，拼接经常变化的数值时不用新建纹理
+typedef struct {
+    TTF_Font* font;
+    SDL_Color color;
+    SDL_Texture* texture;
+    int x[sizeof(GLYPH_ATLAS_CHARS)];   // 第 i 个字符的左边界，最后一项为总宽
+    int h;
+} GlyphAtlas;
+
+// 文字纹理缓存：文字不变时纹理一直保留，稳定状态下每帧不再创建表面和纹理
+typedef struct {
+    SDL_Renderer* renderer;
+    TextEntry entries[TEXT_CACHE_SIZE];
+    int count;
+    GlyphAtlas atlases[GLYPH_ATLAS_MAX];
+    int atlas_count;
+    unsigned int clock;       // 每次查找加一，满了淘汰最久未用的条目
+    long textures_created;    // 累计创建的纹理数
+} TextCache;
+
+void text_cache_init(TextCache* cache, SDL_Renderer* renderer);
+void text_cache_free(TextCache* cache);
+
+// 取文字纹理，没有时渲染并缓存；失败返回 NULL
+const TextEntry* text_cache_get(TextCache* cache, TTF_Font* font, const char* text, SDL_Color color);
+// 左上角在 (x, y) 处绘制文字
+void text_draw(TextCache* cache, TTF_Font* font, const char* text, SDL_Color color, int x, int y);
+// 内容频繁变化的文字：字符都在图集里时逐字形拼接，否则同 text_draw
+void text_draw_dynamic(TextCache* cache, TTF_Font* font, const char* text, SDL_Color color, int x, int y);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef SVG_GUI_TILES_H
+#define SVG_GUI_TILES_H
+
+#include <SDL.h>
+#include "image.h"
+#include "svg_display_list.h"
+#include "spatial_grid.h"
+
+#define TILE_SIZE 256
+#define TILE_CACHE_SLOTS 96
+// 缩放层级：第 level 层的缩放为 2^level
+#define TILE_MIN_LEVEL -3
+#define TILE_MAX_LEVEL 4
+// 较粗层级顶替缺失瓦片时最多往上找几层
+#define TILE_FALLBACK_LEVELS 3
+
+// 一块已光栅化的画布瓦片：第 level 层像素坐标中的 [tx, ty] 格
+typedef struct {
+    int level, tx, ty;
+    int used;                 // 槽位里有内容
+    int stale;                // 文档改过，内容过期但仍可临时显示
+    unsigned int last_used;
+    Image* image;             // 背景透明，网格从下面透出
+    SDL_Texture* texture;
+} CanvasTile;
+
+// 按缩放层级缓存的画布瓦片。平移只是重新贴图，缩放先用已有层级顶替，
+// 缺的瓦片每帧在时间预算内补画
+typedef struct {
+    SDL_Renderer* renderer;
+    CanvasTile tiles[TILE_CACHE_SLOTS];
+    unsigned int clock;       // 每次绘制加一，本帧用到的瓦片不会被换出
+    int* ids;                 // 索引查询结果缓冲
+    int id_capacity;
+    long rendered;            // 累计光栅化的瓦片数
+} TileCache;
+
+void tile_cache_init(TileCache* cache, SDL_Renderer* renderer);
+void tile_cache_free(TileCache* cache);
+// 所有瓦片标记为过期（文档整体替换后）
+void tile_cache_invalidate_all(TileCache* cache);
+
+// 文档区域 area（1:1 像素）变了：level 层已缓存的瓦片立即只重绘受影响的部分并上传，
+// 其它层级的瓦片标记为过期
+void tile_cache_invalidate(TileCache* cache, const DisplayList* dl, const SpatialGrid* grid,
+                           const PixelRect* area, int level);
+
+// 把 level 层中以 (origin_x, origin_y) 为左上角的部分画到 dst。
+// 缺失或过期的瓦片在 budget_ms 内补画（每次至少一块），其余先用较粗层级放大顶替。
+// 返回还没补画的瓦片数，不为 0 时调用者应尽快再画一帧
+int tile_cache_draw(TileCache* cache, const DisplayList* dl, const SpatialGrid* grid,
+                    int level, int origin_x, int origin_y, const SDL_Rect* dst, double budget_ms);
+
+#endif
@@ -1,7 +1,9 @@
 #ifndef SVG_GUI_TYPES_H
 #define SVG_GUI_TYPES_H
 
-#define MAX_SHAPES 100
+#include <stdatomic.h>
+#include "spatial_grid.h"
+#include "svg_raster.h"
 
 typedef enum {
     SVG_SHAPE_CIRCLE,
@@ -34,15 +36,108 @@ typedef struct {
     int id;
 } SvgShape;
 
+// ID 到槽位的哈希表项，id 为 0 表示空位
+typedef struct {
+    int id;
+    int slot;
+} SvgSlotEntry;
+
+// 槽位按块存放，每块 SVG_CHUNK_SIZE 个
+#define SVG_CHUNK_BITS 8
+#define SVG_CHUNK_SIZE (1 << SVG_CHUNK_BITS)
+
+// 一块槽位，可被多个文档版本共享，引用计数归零时释放
+typedef struct {
+    atomic_int refs;
+    SvgShape shapes[SVG_CHUNK_SIZE];
+} SvgShapeChunk;
+
+// 块指针表，同样按引用共享
+typedef struct {
+    atomic_int refs;
+    int count, capacity;
+    SvgShapeChunk** chunks;
+} SvgChunkTable;
+
+// 图形存储：按槽位存放，槽位即绘制顺序，也是空间索引和显示列表的编号。
+// 图形 ID 分配后不变，按 ID 查槽位走哈希表。删除只把槽位标成墓碑（id 为 0），
+// 其它图形的槽位不动；墓碑积累到一定比例后再整体压缩。
+// 槽位块写时复制：快照共享块指针表，之后第一次修改复制指针表（每 256 个槽位一个指针），
+// 此后的修改只复制被改动的块
 typedef struct {
     double width, height;
-    SvgShape shapes[MAX_SHAPES];
-    int shape_count;
+    SvgChunkTable* table;
+    int shape_count;        // 已用槽位数，含墓碑
+    int live_count;         // 有效图形数
+    int next_id;            // 下一个新图形的 ID，只增不减
+    unsigned int version;   // 每次修改加一
+    SvgSlotEntry* slots;    // 开放寻址哈希表，容量为 2 的幂；快照中为 NULL
+    int slot_capacity;
 } SvgDocument;
 
-// 函数声明
+#define svg_shape_alive(shape) ((shape)->id != 0)
+
 SvgDocument* create_svg_document(double width, double height);
+void free_svg_document(SvgDocument* doc);
+// O(1) 快照：与 doc 共享全部槽位块，之后 doc 的修改不影响快照；
+// 代价推迟到 doc 的下一次修改，复制 O(槽位数/256) 的块指针表。
+// 快照只读且不带 ID 索引，可交给其它线程渲染或保存，用完以 free_svg_document 释放
+SvgDocument* svg_document_snapshot(const SvgDocument* doc);
+
+// 槽位上的图形，只读
+const SvgShape* svg_document_shape(const SvgDocument* doc, int slot);
+// 修改槽位上的图形前调用：所在块与快照共享时先复制该块，失败返回 NULL
+SvgShape* svg_document_edit(SvgDocument* doc, int slot);
+// 批量修改整块槽位前调用：返回第 index 块的首个图形，复制规则同上
+SvgShape* svg_document_edit_chunk(SvgDocument* doc, int index);
+
+// 删除全部图形，ID 从 1 重新分配
+void svg_document_clear(SvgDocument* doc);
+// 追加到最上层并分配新 ID（忽略 shape->id），返回槽位，内存不足返回 -1
+int svg_document_add(SvgDocument* doc, const SvgShape* shape);
+// ID 对应的槽位，不存在返回 -1
+int svg_document_find(const SvgDocument* doc, int id);
+// 按 ID 取图形准备修改，同 svg_document_edit
+SvgShape* svg_document_get(SvgDocument* doc, int id);
+// 删除图形，槽位变为墓碑，返回原槽位，不存在返回 -1
+int svg_document_remove(SvgDocument* doc, int id);
+// 把图形（保留其 ID）放回墓碑槽位，slot 等于 shape_count 时追加，返回槽位，失败返回 -1
+int svg_document_restore(SvgDocument* doc, int slot, const SvgShape* shape);
+// 回到快照时的内容（含墓碑和 next_id），O(图形数)，失败返回 0
+int svg_document_revert(SvgDocument* doc, const SvgDocument* snapshot);
+// 墓碑超过槽位的一半时压缩（force 时只要有墓碑就压缩），保持绘制顺序。
+// 返回 1 表示槽位已变，以槽位为编号的索引和显示列表需要重建
+int svg_document_compact(SvgDocument* doc, int force);
+
+// 有效图形内容（按绘制顺序，含 ID）的 64 位校验和，与槽位布局和墓碑无关
+unsigned long long svg_document_checksum(const SvgDocument* doc);
+
+typedef enum {
+    SVG_EXPORT_BMP,
+    SVG_EXPORT_JPG
+} SvgExportFormat;
+
+// 导出进度：共 total 步，已完成 done 步
+typedef void (*SvgExportProgress)(void* ctx, int done, int total);
+
+// 分条带渲染后编码写出，progress 可为 NULL。只读访问 doc，可在工作线程中对快照调用
+int export_svg_document(SvgDocument* doc, const char* filename, SvgExportFormat format,
+                        SvgExportProgress progress, void* ctx);
 int export_to_bmp(SvgDocument* doc, const char* filename);
 int export_to_jpg(SvgDocument* doc, const char* filename);
 
+// 平移图形
+void svg_shape_translate(SvgShape* shape, double dx, double dy);
+// 图形在画布坐标中的包围盒，供空间索引和绘制使用（float）
+void svg_shape_bounds(const SvgShape* shape, GridBox* box);
+// 同上，按 double 计算 [x0, y0, x1, y1]，用于要写回图形的几何运算
+void svg_shape_bounds_d(const SvgShape* shape, double box[4]);
+// 以槽位为编号建立空间索引，槽位顺序即绘制顺序，墓碑不登记
+SpatialGrid* build_shape_index(SvgDocument* doc);
+
+struct DisplayList;
+struct DisplayList* compile_svg_document(SvgDocument* doc);
+// 图形对应的显示列表命令，墓碑为空命令
+void svg_shape_command(const SvgShape* shape, RenderPrimitive* cmd);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef SVG_JOURNAL_H
+#define SVG_JOURNAL_H
+
+#include <stddef.h>
+#include "svg_gui_types.h"
+#include "svg_selection.h"
+
+// 默认内存预算
+#define JOURNAL_DEFAULT_BUDGET ((size_t)8 << 20)
+
+typedef enum {
+    JOURNAL_MOVE,       // 按 ID 平移 dx/dy
+    JOURNAL_CHANGE,     // 属性修改：改前改后的图形
+    JOURNAL_INSERT,     // 新图形及其槽位
+    JOURNAL_DELETE,     // 被删图形的 ID 和槽位，内容仍在墓碑里
+    JOURNAL_RESET,      // 清空、载入、压缩等整体操作：前后两个快照
+    JOURNAL_MOVE_MANY,  // 一批图形平移同样的 dx/dy：ID 列表
+    JOURNAL_EDIT_MANY,  // 一批图形的缩放/改色：修改前的图形，重做时重新执行修改
+    JOURNAL_DELETE_MANY // 一批删除：ID 和槽位
+} JournalOp;
+
+// 撤销或重做的结果
+typedef enum {
+    JOURNAL_NOTHING,    // 没有可撤销/重做的记录，或应用失败
+    JOURNAL_SLOTS,      // touched 中列出的槽位变了
+    JOURNAL_ALL         // 槽位整体变了，以槽位为编号的索引需要重建
+} JournalResult;
+
+// 操作日志：记录按顺序紧凑存放在一块缓冲里，撤销和重做只应用一条记录的差量。
+// 整体操作的快照是写时复制的，记录本身 O(1)，也是日志的检查点：
+// 撤销跨过压缩时回到压缩前的快照，之前以槽位记录的插入/删除仍然有效。
+// 超出内存预算时从最早的记录开始丢弃，最近一条总会保留
+typedef struct SvgJournal {
+    unsigned char* data;    // 记录内容，每条按 8 字节对齐
+    size_t size, capacity;
+    size_t* offsets;        // 每条记录在 data 中的起点
+    int count, offset_capacity;
+    int cursor;             // 前 cursor 条已应用，之后的可重做
+    int open_move;          // 最后一条移动记录还可以合并
+    size_t snapshot_bytes;  // 整体操作记录估算占用的图形内存
+    size_t budget;
+    int* touched;           // 最近一次撤销/重做改动的槽位
+    int touched_count, touched_capacity;
+} SvgJournal;
+
+void journal_init(SvgJournal* j, size_t budget);
+void journal_free(SvgJournal* j);
+// 丢弃全部记录
+void journal_clear(SvgJournal* j);
+// 结束当前的连续拖动，之后的移动另起一条记录
+void journal_seal(SvgJournal* j);
+
+// 以下在操作完成之后调用，会丢弃可重做的记录；内存不足时清空日志并返回 0，文档本身不受影响。
+// 同一图形（或同一批图形）连续的移动在 journal_seal 之前合并为一条
+int journal_move(SvgJournal* j, int id, double dx, double dy);
+int journal_move_many(SvgJournal* j, const int* ids, int count, double dx, double dy);
+int journal_edit_many(SvgJournal* j, const SvgShape* before, int count, const ShapeEdit* edit);
+int journal_delete_many(SvgJournal* j, const int* ids, const int* slots, int count);
+int journal_change(SvgJournal* j, const SvgShape* before, const SvgShape* after);
+int journal_insert(SvgJournal* j, const SvgShape* shape, int slot);
+int journal_delete(SvgJournal* j, int id, int slot);
+// before 为操作前的 svg_document_snapshot，由日志接管；操作后的状态从 doc 取快照
+int journal_reset(SvgJournal* j, SvgDocument* before, const SvgDocument* doc);
+// 按 svg_document_compact 的规则压缩，压缩了就记为整体操作，返回值同 svg_document_compact
+int journal_compact(SvgJournal* j, SvgDocument* doc, int force);
+
+#define journal_can_undo(j) ((j)->cursor > 0)
+#define journal_can_redo(j) ((j)->cursor < (j)->count)
+
+// 撤销/重做一条记录，JOURNAL_SLOTS 时 touched 为变化的槽位
+JournalResult journal_undo(SvgJournal* j, SvgDocument* doc);
+JournalResult journal_redo(SvgJournal* j, SvgDocument* doc);
+
+#endif
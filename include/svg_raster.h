@@ -0,0 +1,54 @@
+#ifndef SVG_RASTER_H
+#define SVG_RASTER_H
+
+#include "image.h"
+
+// 像素矩形，半开区间 [x0, x1) x [y0, y1)
+typedef struct {
+    int x0, y0, x1, y1;
+} PixelRect;
+
+// 图元类型
+typedef enum {
+    PRIM_NONE,
+    PRIM_RECT,
+    PRIM_CIRCLE,
+    PRIM_LINE
+} PrimitiveKind;
+
+// 变换后的绘制图元，bounds 为它可能写入的全部像素
+typedef struct {
+    PrimitiveKind kind;
+    float p[4];        // 矩形: x, y, w, h / 圆: cx, cy, r / 直线: x1, y1, x2, y2
+    RGBColor color;
+    PixelRect bounds;
+} RenderPrimitive;
+
+// 背景设置
+typedef struct {
+    RGBColor color;
+    int transparent;   // 非 0 时背景像素 alpha 为 0（图像需带 alpha 通道）
+} RenderBackground;
+
+// 覆盖掩码：记录 area 内已被不透明图元写过的像素，用于由前向后绘制
+typedef struct {
+    PixelRect area;
+    unsigned char *mask;   // 每像素一字节，行宽为 area 宽度
+    int *row_covered;      // 每行已覆盖的像素数
+    long covered;          // 已覆盖的像素总数
+} CoverageMask;
+
+// 图元光栅化：串行、分块与显示列表回放共用，保证结果逐像素一致
+void primitive_compute_bounds(RenderPrimitive *prim);
+void draw_primitive(Image *img, const RenderPrimitive *prim, const PixelRect *clip);
+// 由前向后绘制：只写入掩码中未覆盖的像素并标记，返回新写入的像素数
+long draw_primitive_front(Image *img, const RenderPrimitive *prim, CoverageMask *cov);
+long primitive_pixel_count(const RenderPrimitive *prim, const PixelRect *clip);
+
+// 背景：识别铺满画布的矩形并用其颜色清屏
+int find_background_primitive(const RenderPrimitive *prims, int count, int width, int height);
+RenderBackground resolve_background(const RenderPrimitive *prims, int count, const Image *img,
+                                    const RenderBackground *bg, int *first);
+void render_clear(Image *img, const PixelRect *area, const RenderBackground *bg);
+
+#endif
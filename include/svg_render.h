@@ -2,6 +2,9 @@
 #define SVG_RENDER_H
 
 #include "image.h"
+#include "svg_raster.h"
+#include "svg_display_list.h"
+#include "svg_tile_render.h"
 
 #include <stdint.h>
 
@@ -55,8 +58,31 @@ typedef struct {
     SVGGroup *group;  // 所属分组
 } SVGShape;
 
+// preserveAspectRatio 的对齐方式
+typedef enum {
+    ALIGN_MIN,
+    ALIGN_MID,
+    ALIGN_MAX
+} ViewportAlign;
+
+// <svg> 根元素的视口信息
+typedef struct {
+    float width, height;          // width/height 属性，未给出或为百分比时 <= 0
+    int has_viewbox;
+    float vb_x, vb_y, vb_w, vb_h; // viewBox
+    int align_none;               // preserveAspectRatio="none"，非等比拉伸
+    ViewportAlign align_x, align_y;
+    int slice;                    // slice 铺满裁切，meet（默认）完整放入
+} SVGViewport;
 
 int parse_svg(const char *filename, SVGShape **shapes, int *shape_count);
+// 同时读出 <svg> 的 width/height/viewBox/preserveAspectRatio，viewport 可为 NULL
+int parse_svg_ex(const char *filename, SVGShape **shapes, int *shape_count, SVGViewport *viewport);
+
+// 文档的固有尺寸：width/height，其次 viewBox，都没有时用 fallback
+void svg_viewport_size(const SVGViewport *vp, float fallback_w, float fallback_h, float *w, float *h);
+// 把 viewBox 映射到 out_w x out_h 输出的视图变换，doc_w/doc_h 为没有 viewBox 时的用户坐标范围
+DisplayListView svg_viewport_view(const SVGViewport *vp, float doc_w, float doc_h, int out_w, int out_h);
 
 Matrix matrix_identity();
 Matrix matrix_mul(Matrix A, Matrix B);
@@ -73,6 +99,17 @@ void draw_line(Image *img, float x1, float y1, float x2, float y2, RGBColor colo
 void draw_rectangle(Image *img, float x, float y, float width, float height, RGBColor color);
 void draw_circle(Image *img, float cx, float cy, float r, RGBColor color);
 void render_svg_to_image(Image *img, SVGShape *shapes, int shape_count);
+void render_svg_to_image_bg(Image *img, SVGShape *shapes, int shape_count, const RenderBackground *bg);
+
+// 把形状的变换落到几何上，得到可直接光栅化的图元
+int prepare_shape(SVGShape *shape, RenderPrimitive *prim);
+// 编译成显示列表（文档坐标），threads > 1 时并行计算变换
+DisplayList *display_list_compile(SVGShape *shapes, int shape_count, float width, float height,
+                                  int threads);
+// 分块并行渲染，结果与 render_svg_to_image_bg 逐字节一致
+void render_svg_to_image_tiled(Image *img, SVGShape *shapes, int shape_count,
+                               const TileRenderOptions *opts);
+int render_parse_background(const char *arg, RenderBackground *bg);
 void apply_transforms(SVGShape *shape, float *x, float *y);
 void apply_transforms_to_point(Transform *transforms, int count, float *x, float *y);
 void apply_group_transforms(SVGGroup *group, float *x, float *y);
@@ -0,0 +1,58 @@
+#ifndef SVG_SELECTION_H
+#define SVG_SELECTION_H
+
+#include "svg_gui_types.h"
+
+struct SvgJournal;
+
+// 选中集合：以槽位为编号的位图，和空间索引、显示列表的编号一致。
+// 文档压缩或整体回退后槽位会变，调用方应清空选择
+typedef struct {
+    unsigned long long* bits;
+    int words;              // 位图容量，64 位一个字
+    int count;              // 选中的槽位数
+    int lo, hi;             // 可能非零的字在 [lo, hi) 内，清空和遍历只看这一段
+} SvgSelection;
+
+// 批量修改：缩放或改颜色，撤销日志按它重做
+typedef enum {
+    SHAPE_EDIT_SCALE,       // 以 (cx, cy) 为中心缩放 factor 倍
+    SHAPE_EDIT_RECOLOR      // 填充色（直线为描边色）改为 color
+} ShapeEditKind;
+
+typedef struct {
+    ShapeEditKind kind;
+    double cx, cy, factor;
+    char color[16];
+} ShapeEdit;
+
+void shape_edit_apply(SvgShape* shape, const ShapeEdit* edit);
+
+void selection_init(SvgSelection* sel);
+void selection_free(SvgSelection* sel);
+void selection_clear(SvgSelection* sel);
+// 选中槽位，内存不足返回 0
+int selection_add(SvgSelection* sel, int slot);
+void selection_remove(SvgSelection* sel, int slot);
+int selection_has(const SvgSelection* sel, int slot);
+// slot 及之后第一个选中的槽位，没有返回 -1
+int selection_next(const SvgSelection* sel, int slot);
+// 选中一组槽位（如空间索引的查询结果），墓碑跳过，返回新选中的个数
+int selection_add_slots(SvgSelection* sel, const SvgDocument* doc, const int* slots, int count);
+// 选中全部有效图形
+int selection_select_all(SvgSelection* sel, const SvgDocument* doc);
+// 选中图形的包围盒并集，没有选中时为空盒。float 版供绘制选框，
+// 缩放基点等要写回图形的计算用 double 版 [x0, y0, x1, y1]，避免引入 float 误差
+void selection_bounds(const SvgSelection* sel, const SvgDocument* doc, GridBox* box);
+void selection_bounds_d(const SvgSelection* sel, const SvgDocument* doc, double box[4]);
+
+// 批量操作：按槽位块逐块处理，每块只做一次写时复制，只改选中的有效图形。
+// journal 非 NULL 时整批记为一步撤销；返回处理的图形数，内存不足返回 -1
+int selection_move(SvgDocument* doc, const SvgSelection* sel, double dx, double dy,
+                   struct SvgJournal* journal);
+int selection_edit(SvgDocument* doc, const SvgSelection* sel, const ShapeEdit* edit,
+                   struct SvgJournal* journal);
+// 删除选中的图形（槽位变为墓碑），选择不变，由调用方同步索引后清空
+int selection_delete(SvgDocument* doc, const SvgSelection* sel, struct SvgJournal* journal);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef SVG_TILE_PYRAMID_H
+#define SVG_TILE_PYRAMID_H
+
+#include "svg_display_list.h"
+
+#define PYRAMID_TILE_SIZE 256
+
+// 瓦片金字塔导出参数
+typedef struct {
+    const char *out_dir;    // 输出目录，瓦片写到 out_dir/z/x/y.jpg
+    int tile_size;          // 瓦片边长，<= 0 时使用 PYRAMID_TILE_SIZE
+    int levels;             // 层数；第 0 层一块瓦片容纳整个窗口，每层边长翻倍
+    int threads;            // <= 0 时使用 CPU 核数
+    int quality;            // JPEG 质量，<= 0 时为 90
+    const RenderBackground *background;  // 可选，NULL 时为白色；JPEG 不支持透明
+} PyramidOptions;
+
+typedef struct {
+    long long tiles;        // 所有层的瓦片总数
+    long long written;      // 写出的瓦片数
+    long long empty;        // 只有背景、跳过的瓦片数
+    double seconds;         // 建索引加渲染的耗时
+} PyramidStats;
+
+// 把文档窗口 window 切成 z/x/y 瓦片金字塔。先为显示列表建立空间网格索引，
+// 每块瓦片只查询、回放与它相交的命令，不分配整层画布；瓦片并行渲染。
+// 成功返回 1
+int export_tile_pyramid(const DisplayList *dl, const DisplayListRect *window,
+                        const PyramidOptions *opts, PyramidStats *stats);
+
+void print_pyramid_stats(const PyramidStats *stats);
+
+#endif
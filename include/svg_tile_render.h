@@ -0,0 +1,44 @@
+#ifndef SVG_TILE_RENDER_H
+#define SVG_TILE_RENDER_H
+
+#include "image.h"
+#include "svg_display_list.h"
+
+#define RENDER_TILE_SIZE 64
+
+// 遮挡剔除统计
+typedef struct {
+    int shapes;                    // 与画布相交的图元数
+    int shapes_occluded;           // 完全被遮挡、整体跳过的图元数
+    long long tile_pairs;          // 图元-分块对总数
+    long long tile_pairs_skipped;  // 因分块或所在行已被覆盖而跳过的对数
+    long long pixels_painted;      // 画家算法需要写入的像素数（含背景）
+    long long pixels_written;      // 实际写入的像素数（含背景）
+} OcclusionStats;
+
+// 分块渲染参数
+typedef struct {
+    int tile_size;          // 分块边长（像素），<= 0 时使用 RENDER_TILE_SIZE
+    int threads;            // 工作线程数，<= 0 时使用 CPU 核数
+    int occlusion_cull;     // 非 0 时由前向后绘制并跳过已被覆盖的像素
+    OcclusionStats *stats;  // 可选，遮挡剔除模式下输出统计
+    const RenderBackground *background;  // 可选，NULL 时为白色
+} TileRenderOptions;
+
+// 分块并行渲染：把每个图元的包围盒分到覆盖的分块中，
+// 各分块按原始顺序（z 序）独立绘制，结果与串行回放逐字节一致
+
+// 遮挡剔除模式：所有图元均为不透明色，按 z 序从后往前处理，
+// 每个分块维护覆盖掩码，分块被完全覆盖后其余图元直接跳过，输出与普通模式一致
+
+// 直接渲染已准备好的图元
+void render_primitives_tiled(Image *img, const RenderPrimitive *prims, int count,
+                             const TileRenderOptions *opts);
+
+// 分块回放显示列表，view 为 NULL 时按 1:1 输出
+void render_display_list_tiled(const DisplayList *dl, Image *img, const DisplayListView *view,
+                               const TileRenderOptions *opts);
+
+void print_occlusion_stats(const OcclusionStats *stats);
+
+#endif
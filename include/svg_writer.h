@@ -0,0 +1,35 @@
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include <stdio.h>
+#include <stddef.h>
+
+// 一个数字格式化后的最大长度（含结尾 0）
+#define SVG_NUMBER_MAX 32
+// 输出缓冲大小，写满后一次 fwrite
+#define SVG_WRITER_BUFFER (1 << 20)
+
+// 写成能被 strtod 精确读回的最短十进制串，返回长度。整数和小数位不超过 4 位的数走快速路径，
+// 其余用 Ryu，位数最少且最接近原值。很大或很小的数用指数形式，inf/nan 与 printf 相同
+int svg_format_number(char* out, double value);
+
+// 缓冲写出 SVG 文本：数字和字符串先拼进大缓冲，满了整块写入文件
+typedef struct {
+    FILE* file;
+    char* buf;
+    size_t len;
+    int error;              // 打开之后任何一次写失败都置位
+} SvgWriter;
+
+// 打开失败返回 0
+int svg_writer_open(SvgWriter* w, const char* filename);
+void svg_writer_write(SvgWriter* w, const char* data, size_t n);
+void svg_writer_str(SvgWriter* w, const char* s);
+void svg_writer_number(SvgWriter* w, double value);
+// 写出 ` name="value"`
+void svg_writer_attr(SvgWriter* w, const char* name, double value);
+void svg_writer_attr_str(SvgWriter* w, const char* name, const char* value);
+// 写出剩余内容并关闭文件，全部写成功返回 1
+int svg_writer_close(SvgWriter* w);
+
+#endif
@@ -0,0 +1,15 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// 并行任务回调：index 为任务编号，ctx 为调用者数据
+typedef void (*ParallelTask)(int index, void *ctx);
+
+// 用 threads 个线程执行 task(0..count-1)，线程从共享计数器领取任务。
+// 当前线程加上 threads - 1 个常驻工作线程，工作线程首次用到时创建，之后复用。
+// threads <= 1，或另一个 parallel_for 正在执行（包括在 task 里嵌套调用）时在当前线程顺序执行
+void parallel_for(int count, int threads, ParallelTask task, void *ctx);
+
+// 可用 CPU 核数（至少为 1）
+int cpu_count(void);
+
+#endif
@@ -0,0 +1,864 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+
+#include "../include/image.h"
+#include "../include/svg_render.h"
+#include "../include/svg_tile_render.h"
+#include "../include/thread_pool.h"
+#include "../include/spatial_grid.h"
+#include "../include/svg_gui_types.h"
+#include "../include/svg_writer.h"
+
+#define BENCH_WIDTH 800
+#define BENCH_HEIGHT 600
+
+/********************* Helpers *********************/
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Deterministic pseudo random numbers so runs are comparable
+static unsigned int bench_seed = 12345;
+
+static float bench_rand(float lo, float hi)
+{
+    bench_seed = bench_seed * 1103515245u + 12345u;
+    return lo + (hi - lo) * ((bench_seed >> 8) & 0xFFFF) / 65535.0f;
+}
+
+// Build a synthetic scene: a full-canvas background followed by random shapes
+static SVGShape *make_scene(int count, int width, int height)
+{
+    SVGShape *shapes = calloc(count, sizeof(SVGShape));
+    if (!shapes) return NULL;
+
+    for (int i = 0; i < count; i++) {
+        SVGShape *s = &shapes[i];
+        s->color.r = (unsigned char)bench_rand(0, 255);
+        s->color.g = (unsigned char)bench_rand(0, 255);
+        s->color.b = (unsigned char)bench_rand(0, 255);
+
+        if (i == 0) {
+            strcpy(s->type, "rect");
+            s->width = width;
+            s->height = height;
+            continue;
+        }
+
+        switch (i % 3) {
+        case 0:
+            strcpy(s->type, "rect");
+            s->x = bench_rand(-20, width);
+            s->y = bench_rand(-20, height);
+            s->width = bench_rand(2, 80);
+            s->height = bench_rand(2, 80);
+            break;
+        case 1:
+            strcpy(s->type, "circle");
+            s->cx = bench_rand(0, width);
+            s->cy = bench_rand(0, height);
+            s->r = bench_rand(1, 40);
+            break;
+        default:
+            strcpy(s->type, "line");
+            s->x = bench_rand(0, width);
+            s->y = bench_rand(0, height);
+            s->x2 = s->x + bench_rand(-100, 100);
+            s->y2 = s->y + bench_rand(-100, 100);
+            break;
+        }
+    }
+    return shapes;
+}
+
+static int load_scene(const char *file, int count, SVGShape **shapes, int *shape_count)
+{
+    if (file) {
+        return parse_svg(file, shapes, shape_count);
+    }
+    *shapes = make_scene(count, BENCH_WIDTH, BENCH_HEIGHT);
+    *shape_count = count;
+    return *shapes != NULL;
+}
+
+// Serial reference: same primitives, one full-image pass in document order
+static void render_serial(Image *img, SVGShape *shapes, int count)
+{
+    RGBColor white = {255, 255, 255};
+    for (int i = 0; i < img->width * img->height; i++) {
+        img->pixels[i] = white;
+    }
+    for (int i = 0; i < count; i++) {
+        RenderPrimitive prim;
+        if (prepare_shape(&shapes[i], &prim)) {
+            draw_primitive(img, &prim, NULL);
+        }
+    }
+}
+
+/********************* Benchmarks *********************/
+
+// Tiled renderer scaling from 1 to N threads against the serial renderer
+static int bench_tiles(const char *file, int count, int max_threads, int iterations)
+{
+    SVGShape *shapes;
+    int shape_count;
+    if (!load_scene(file, count, &shapes, &shape_count)) return 1;
+
+    Image *ref = create_image(BENCH_WIDTH, BENCH_HEIGHT);
+    Image *img = create_image(BENCH_WIDTH, BENCH_HEIGHT);
+    size_t bytes = (size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(RGBColor);
+
+    double t0 = now_seconds();
+    for (int it = 0; it < iterations; it++) {
+        render_serial(ref, shapes, shape_count);
+    }
+    double serial = (now_seconds() - t0) / iterations;
+
+    printf("shapes: %d, canvas: %dx%d, tile: %d, iterations: %d\n",
+           shape_count, BENCH_WIDTH, BENCH_HEIGHT, RENDER_TILE_SIZE, iterations);
+    printf("%-10s %12s %10s %10s\n", "threads", "ms/frame", "speedup", "identical");
+    printf("%-10s %12.3f %10s %10s\n", "serial", serial * 1000, "1.00", "-");
+
+    int failed = 0;
+    for (int threads = 1; threads <= max_threads; threads++) {
+        TileRenderOptions opts = {RENDER_TILE_SIZE, threads};
+
+        t0 = now_seconds();
+        for (int it = 0; it < iterations; it++) {
+            render_svg_to_image_tiled(img, shapes, shape_count, &opts);
+        }
+        double t = (now_seconds() - t0) / iterations;
+
+        int same = memcmp(ref->pixels, img->pixels, bytes) == 0;
+        failed |= !same;
+        printf("%-10d %12.3f %10.2f %10s\n", threads, t * 1000, serial / t, same ? "yes" : "NO");
+    }
+
+    free_image(ref);
+    free_image(img);
+    free(shapes);
+    return failed;
+}
+
+// Painter's order vs front-to-back occlusion culling on the tiled renderer
+static int bench_occlusion(const char *file, int count, int threads, int iterations)
+{
+    SVGShape *shapes;
+    int shape_count;
+    if (!load_scene(file, count, &shapes, &shape_count)) return 1;
+
+    Image *ref = create_image(BENCH_WIDTH, BENCH_HEIGHT);
+    Image *img = create_image(BENCH_WIDTH, BENCH_HEIGHT);
+    size_t bytes = (size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(RGBColor);
+
+    TileRenderOptions painter = {RENDER_TILE_SIZE, threads, 0, NULL};
+    TileRenderOptions culled = {RENDER_TILE_SIZE, threads, 1, NULL};
+
+    double t0 = now_seconds();
+    for (int it = 0; it < iterations; it++) {
+        render_svg_to_image_tiled(ref, shapes, shape_count, &painter);
+    }
+    double t_painter = (now_seconds() - t0) / iterations;
+
+    t0 = now_seconds();
+    for (int it = 0; it < iterations; it++) {
+        render_svg_to_image_tiled(img, shapes, shape_count, &culled);
+    }
+    double t_culled = (now_seconds() - t0) / iterations;
+
+    // Statistics pass is separate so counting does not skew the timing
+    OcclusionStats stats;
+    culled.stats = &stats;
+    render_svg_to_image_tiled(img, shapes, shape_count, &culled);
+
+    int same = memcmp(ref->pixels, img->pixels, bytes) == 0;
+
+    printf("shapes: %d, canvas: %dx%d, threads: %d, iterations: %d\n",
+           shape_count, BENCH_WIDTH, BENCH_HEIGHT, threads, iterations);
+    printf("%-12s %12.3f ms/frame\n", "painter", t_painter * 1000);
+    printf("%-12s %12.3f ms/frame (%.2fx), identical: %s\n", "occlusion",
+           t_culled * 1000, t_painter / t_culled, same ? "yes" : "NO");
+    print_occlusion_stats(&stats);
+
+    free_image(ref);
+    free_image(img);
+    free(shapes);
+    return !same;
+}
+
+// Display list: one-off compile cost vs replay at several output sizes
+static int bench_displaylist(const char *file, int count, int iterations)
+{
+    SVGShape *shapes;
+    int shape_count;
+    if (!load_scene(file, count, &shapes, &shape_count)) return 1;
+
+    Image *ref = create_image(BENCH_WIDTH, BENCH_HEIGHT);
+    Image *img = create_image(BENCH_WIDTH, BENCH_HEIGHT);
+    size_t bytes = (size_t)BENCH_WIDTH * BENCH_HEIGHT * sizeof(RGBColor);
+
+    double t0 = now_seconds();
+    for (int it = 0; it < iterations; it++) {
+        render_serial(ref, shapes, shape_count);
+    }
+    double immediate = (now_seconds() - t0) / iterations;
+
+    DisplayList *dl = NULL;
+    t0 = now_seconds();
+    for (int it = 0; it < iterations; it++) {
+        display_list_free(dl);
+        dl = display_list_compile(shapes, shape_count, BENCH_WIDTH, BENCH_HEIGHT, 1);
+    }
+    double compile = (now_seconds() - t0) / iterations;
+    if (!dl) return 1;
+
+    printf("shapes: %d, canvas: %dx%d, iterations: %d\n",
+           shape_count, BENCH_WIDTH, BENCH_HEIGHT, iterations);
+    printf("%-22s %12.3f ms\n", "immediate (per frame)", immediate * 1000);
+    printf("%-22s %12.3f ms\n", "compile (once)", compile * 1000);
+
+    static const float scales[] = {1.0f, 0.25f, 0.5f, 2.0f};
+    int failed = 0;
+    for (size_t k = 0; k < sizeof(scales) / sizeof(scales[0]); k++) {
+        Image *out = img;
+        if (scales[k] != 1.0f) {
+            out = create_image((int)(BENCH_WIDTH * scales[k]), (int)(BENCH_HEIGHT * scales[k]));
+        }
+        DisplayListView view = display_list_view_fit(dl, out->width, out->height);
+
+        t0 = now_seconds();
+        for (int it = 0; it < iterations; it++) {
+            display_list_render(dl, out, &view, NULL);
+        }
+        double t = (now_seconds() - t0) / iterations;
+
+        char label[32];
+        snprintf(label, sizeof(label), "replay %dx%d", out->width, out->height);
+        if (out == img) {
+            int same = memcmp(ref->pixels, img->pixels, bytes) == 0;
+            failed |= !same;
+            printf("%-22s %12.3f ms (%.2fx), identical: %s\n", label, t * 1000, immediate / t,
+                   same ? "yes" : "NO");
+        } else {
+            printf("%-22s %12.3f ms\n", label, t * 1000);
+            free_image(out);
+        }
+    }
+
+    display_list_free(dl);
+    free_image(ref);
+    free_image(img);
+    free(shapes);
+    return failed;
+}
+
+// Region-of-interest rendering: cost against window size at 1:1
+static int bench_region(const char *file, int count, int iterations)
+{
+    SVGShape *shapes;
+    int shape_count;
+    if (!load_scene(file, count, &shapes, &shape_count)) return 1;
+
+    DisplayList *dl = display_list_compile(shapes, shape_count, BENCH_WIDTH, BENCH_HEIGHT, 1);
+    if (!dl) return 1;
+
+    Image *full = create_image(BENCH_WIDTH, BENCH_HEIGHT);
+    display_list_render(dl, full, NULL, NULL);
+
+    printf("shapes: %d, canvas: %dx%d, iterations: %d\n",
+           shape_count, BENCH_WIDTH, BENCH_HEIGHT, iterations);
+    printf("%-12s %10s %12s %10s\n", "window", "visible", "ms/frame", "identical");
+
+    int failed = 0;
+    for (int div = 1; div <= 16; div *= 2) {
+        DisplayListRect region = {BENCH_WIDTH / 3, BENCH_HEIGHT / 3,
+                                  BENCH_WIDTH / div, BENCH_HEIGHT / div};
+        if (div == 1) region.x = region.y = 0;
+        Image *img = create_image((int)region.w, (int)region.h);
+
+        double t0 = now_seconds();
+        for (int it = 0; it < iterations; it++) {
+            display_list_render_region(dl, img, &region, NULL);
+        }
+        double t = (now_seconds() - t0) / iterations;
+
+        DisplayListView view = display_list_view_region(&region, img->width, img->height);
+        DisplayListCull cull;
+        display_list_cull_init(&cull, &view, img->width, img->height);
+        int visible = 0;
+        for (int i = 0; i < dl->count; i++) {
+            visible += display_list_cmd_visible(&dl->cmds[i], &cull);
+        }
+
+        int same = 1;
+        for (int y = 0; y < img->height && same; y++) {
+            same = memcmp(&img->pixels[y * img->width],
+                          &full->pixels[((int)region.y + y) * BENCH_WIDTH + (int)region.x],
+                          img->width * sizeof(RGBColor)) == 0;
+        }
+        failed |= !same;
+
+        char label[32];
+        snprintf(label, sizeof(label), "%dx%d", img->width, img->height);
+        printf("%-12s %10d %12.3f %10s\n", label, visible, t * 1000, same ? "yes" : "NO");
+        free_image(img);
+    }
+
+    display_list_free(dl);
+    free_image(full);
+    free(shapes);
+    return failed;
+}
+
+static int box_overlaps(const GridBox *a, const GridBox *b)
+{
+    return a->x0 <= b->x1 && b->x0 <= a->x1 && a->y0 <= b->y1 && b->y0 <= a->y1;
+}
+
+// Spatial index: bulk build vs incremental insert, point/rect queries vs a
+// linear scan over the same boxes, and move throughput
+static int bench_index(int count, int iterations)
+{
+    // Grow the canvas with the shape count so density stays near 10k shapes at 800x600
+    float grow = count > 10000 ? sqrtf(count / 10000.0f) : 1.0f;
+    int width = (int)(BENCH_WIDTH * grow), height = (int)(BENCH_HEIGHT * grow);
+
+    SVGShape *shapes = make_scene(count, width, height);
+    if (!shapes) return 1;
+    DisplayList *dl = display_list_compile(shapes, count, width, height, 1);
+    free(shapes);
+    if (!dl) return 1;
+
+    GridBox *boxes = malloc(dl->count * sizeof(GridBox));
+    if (!boxes) return 1;
+    for (int i = 0; i < dl->count; i++) {
+        float ext[4];
+        display_list_cmd_extent(&dl->cmds[i], 1.0f, 1.0f, ext);
+        boxes[i] = (GridBox){ext[0], ext[1], ext[2], ext[3]};
+    }
+
+    printf("shapes: %d, canvas: %dx%d\n", dl->count, width, height);
+
+    double t0 = now_seconds();
+    SpatialGrid *grid = spatial_grid_build(boxes, dl->count, 0, 0, width, height);
+    double t_build = now_seconds() - t0;
+
+    t0 = now_seconds();
+    SpatialGrid *incremental = spatial_grid_create(0, 0, width, height, dl->count);
+    for (int i = 0; i < dl->count; i++) {
+        spatial_grid_insert(incremental, i, &boxes[i]);
+    }
+    double t_insert = now_seconds() - t0;
+    spatial_grid_free(incremental);
+
+    printf("%-14s %10.1f ms\n", "bulk build", t_build * 1000);
+    printf("%-14s %10.1f ms\n", "insert each", t_insert * 1000);
+    printf("%-14s %12s %12s %10s %8s\n", "query", "index us/q", "scan us/q", "speedup", "match");
+
+    int queries = iterations * 200;
+    int *hits = NULL, capacity = 0;
+    int failed = 0;
+    float sizes[3] = {0.0f, 50.0f, 400.0f};
+    const char *names[3] = {"point", "rect 50", "rect 400"};
+
+    for (int k = 0; k < 3; k++) {
+        GridBox *windows = malloc(queries * sizeof(GridBox));
+        for (int q = 0; q < queries; q++) {
+            float x = bench_rand(0, width), y = bench_rand(0, height);
+            windows[q] = (GridBox){x, y, x + sizes[k], y + sizes[k]};
+        }
+
+        long found_index = 0, found_scan = 0;
+        t0 = now_seconds();
+        for (int q = 0; q < queries; q++) {
+            found_index += k == 0
+                ? spatial_grid_query_point(grid, windows[q].x0, windows[q].y0, &hits, &capacity)
+                : spatial_grid_query(grid, &windows[q], &hits, &capacity);
+        }
+        double t_index = now_seconds() - t0;
+
+        t0 = now_seconds();
+        for (int q = 0; q < queries; q++) {
+            for (int i = 0; i < dl->count; i++) {
+                found_scan += box_overlaps(&boxes[i], &windows[q]);
+            }
+        }
+        double t_scan = now_seconds() - t0;
+
+        failed |= found_index != found_scan;
+        printf("%-14s %12.2f %12.2f %9.1fx %8s\n", names[k],
+               t_index / queries * 1e6, t_scan / queries * 1e6, t_scan / t_index,
+               found_index == found_scan ? "yes" : "NO");
+        free(windows);
+    }
+
+    // Drag-style edits: nudge every shape by a few units
+    t0 = now_seconds();
+    for (int i = 0; i < dl->count; i++) {
+        float dx = bench_rand(-4, 4), dy = bench_rand(-4, 4);
+        GridBox box = {boxes[i].x0 + dx, boxes[i].y0 + dy, boxes[i].x1 + dx, boxes[i].y1 + dy};
+        spatial_grid_move(grid, i, &box);
+    }
+    double t_move = now_seconds() - t0;
+
+    t0 = now_seconds();
+    for (int i = 0; i < dl->count; i += 2) {
+        spatial_grid_remove(grid, i);
+    }
+    double t_remove = now_seconds() - t0;
+
+    printf("%-14s %10.1f ns/op\n", "move", t_move / dl->count * 1e9);
+    printf("%-14s %10.1f ns/op\n", "remove", t_remove / ((dl->count + 1) / 2) * 1e9);
+
+    free(hits);
+    spatial_grid_free(grid);
+    free(boxes);
+    display_list_free(dl);
+    return failed;
+}
+
+// Editor shape store: add, lookup by ID against a linear scan, move,
+// copy-on-write snapshots, and delete by ID with tombstones and compaction
+static int bench_store(int count, int iterations)
+{
+    SvgDocument *doc = create_svg_document(BENCH_WIDTH, BENCH_HEIGHT);
+    if (!doc) return 1;
+
+    double t0 = now_seconds();
+    for (int i = 0; i < count; i++) {
+        SvgShape shape = {0};
+        shape.type = SVG_SHAPE_RECT;
+        shape.data.rect.x = bench_rand(0, BENCH_WIDTH);
+        shape.data.rect.y = bench_rand(0, BENCH_HEIGHT);
+        shape.data.rect.width = bench_rand(1, 50);
+        shape.data.rect.height = bench_rand(1, 50);
+        if (svg_document_add(doc, &shape) < 0) {
+            free_svg_document(doc);
+            return 1;
+        }
+    }
+    double t_add = now_seconds() - t0;
+
+    int lookups = iterations * 100000;
+    int *ids = malloc(lookups * sizeof(int));
+    if (!ids) return 1;
+    for (int q = 0; q < lookups; q++) {
+        ids[q] = 1 + (int)bench_rand(0, count - 1);
+    }
+
+    long found = 0;
+    t0 = now_seconds();
+    for (int q = 0; q < lookups; q++) {
+        found += svg_document_find(doc, ids[q]) >= 0;
+    }
+    double t_find = now_seconds() - t0;
+
+    // The old store scanned shapes[] for the ID
+    int scans = lookups / 1000 > 0 ? lookups / 1000 : 1;
+    long scanned = 0;
+    t0 = now_seconds();
+    for (int q = 0; q < scans; q++) {
+        for (int i = 0; i < doc->shape_count; i++) {
+            if (svg_document_shape(doc, i)->id == ids[q]) {
+                scanned++;
+                break;
+            }
+        }
+    }
+    double t_scan = now_seconds() - t0;
+
+    t0 = now_seconds();
+    for (int q = 0; q < lookups; q++) {
+        SvgShape *shape = svg_document_get(doc, ids[q]);
+        shape->data.rect.x += 1;
+        shape->data.rect.y -= 1;
+    }
+    double t_move = now_seconds() - t0;
+
+    // Copy-on-write snapshot: keep editing and check the snapshot did not change
+    double before = 0, after = 0;
+    for (int i = 0; i < doc->shape_count; i++) before += svg_document_shape(doc, i)->data.rect.x;
+    t0 = now_seconds();
+    SvgDocument *snap = svg_document_snapshot(doc);
+    double t_snapshot = now_seconds() - t0;
+    int edits = lookups / 100 > 0 ? lookups / 100 : 1;
+    // The first edit also copies the chunk pointer table, one pointer per 256 slots
+    t0 = now_seconds();
+    svg_document_get(doc, ids[0])->data.rect.x += 1;
+    double t_first = now_seconds() - t0;
+    t0 = now_seconds();
+    for (int q = 1; q < edits; q++) {
+        svg_document_get(doc, ids[q])->data.rect.x += 1;
+    }
+    double t_cow = now_seconds() - t0;
+    int snapshot_ok = snap != NULL;
+    if (snap) {
+        for (int i = 0; i < snap->shape_count; i++) after += svg_document_shape(snap, i)->data.rect.x;
+        snapshot_ok = before == after;
+    }
+    free_svg_document(snap);
+
+    // Delete every other ID in a scattered order
+    int deletes = 0, compactions = 0;
+    t0 = now_seconds();
+    for (int k = 0; k < 2; k++) {
+        for (int id = 1 + k * 2; id <= count; id += 4) {
+            deletes += svg_document_remove(doc, id) >= 0;
+            compactions += svg_document_compact(doc, 0);
+        }
+    }
+    double t_delete = now_seconds() - t0;
+
+    t0 = now_seconds();
+    compactions += svg_document_compact(doc, 1);
+    double t_compact = now_seconds() - t0;
+
+    // Survivors must still resolve to a slot holding their ID
+    int failed = found != lookups || doc->live_count != count - deletes || !snapshot_ok;
+    for (int id = 1; id <= count; id++) {
+        int slot = svg_document_find(doc, id);
+        int alive = (id & 1) == 0;
+        if (alive ? slot < 0 || svg_document_shape(doc, slot)->id != id : slot >= 0) failed = 1;
+    }
+
+    printf("shapes: %d, lookups: %d\n", count, lookups);
+    printf("%-14s %10.1f ns/op\n", "add", t_add / count * 1e9);
+    printf("%-14s %10.1f ns/op\n", "find by id", t_find / lookups * 1e9);
+    printf("%-14s %10.1f ns/op\n", "linear scan", scanned ? t_scan / scans * 1e9 : 0.0);
+    printf("%-14s %10.1f ns/op\n", "move", t_move / lookups * 1e9);
+    printf("%-14s %10.1f us\n", "snapshot", t_snapshot * 1e6);
+    printf("%-14s %10.1f us (copies the chunk table)\n", "first edit", t_first * 1e6);
+    printf("%-14s %10.1f ns/op (%d edits after snapshot)\n", "cow edit", t_cow / (edits > 1 ? edits - 1 : 1) * 1e9, edits - 1);
+    printf("%-14s %10.1f ns/op (%d deleted, %d compaction(s))\n", "delete",
+           t_delete / (deletes ? deletes : 1) * 1e9, deletes, compactions);
+    printf("%-14s %10.1f ms\n", "compact", t_compact * 1000);
+    printf("snapshot unchanged: %s\n", snapshot_ok ? "yes" : "NO");
+    printf("ids stable: %s\n", failed ? "NO" : "yes");
+
+    free(ids);
+    free_svg_document(doc);
+    return failed;
+}
+
+// SVG save: the old per-shape fprintf("%.1f") writer against the buffered
+// shortest round-trip writer, on hundredth-rounded and full-precision coordinates.
+// Each is timed into a real file and into /dev/null; the second leaves out the
+// kernel's cost of storing the bytes, which no serialiser can avoid
+#define BENCH_SAVE_FILE "svg_bench_save.svg"
+#define BENCH_SAVE_NULL "/dev/null"
+
+static void save_fprintf(const SvgDocument *doc, const char *format, const char *path)
+{
+    FILE *file = fopen(path, "w");
+    if (!file) return;
+    char line[512];
+    for (int i = 0; i < doc->shape_count; i++) {
+        const SvgShape *shape = svg_document_shape(doc, i);
+        switch (shape->type) {
+            case SVG_SHAPE_CIRCLE:
+                snprintf(line, sizeof(line), "  <circle cx=\"%s\" cy=\"%s\" r=\"%s\" fill=\"%%s\"/>\n", format, format, format);
+                fprintf(file, line, shape->data.circle.cx, shape->data.circle.cy, shape->data.circle.r,
+                        shape->data.circle.fill);
+                break;
+            case SVG_SHAPE_RECT:
+                snprintf(line, sizeof(line), "  <rect x=\"%s\" y=\"%s\" width=\"%s\" height=\"%s\" fill=\"%%s\"/>\n",
+                         format, format, format, format);
+                fprintf(file, line, shape->data.rect.x, shape->data.rect.y, shape->data.rect.width,
+                        shape->data.rect.height, shape->data.rect.fill);
+                break;
+            case SVG_SHAPE_LINE:
+                snprintf(line, sizeof(line), "  <line x1=\"%s\" y1=\"%s\" x2=\"%s\" y2=\"%s\" stroke=\"%%s\"/>\n",
+                         format, format, format, format);
+                fprintf(file, line, shape->data.line.x1, shape->data.line.y1, shape->data.line.x2,
+                        shape->data.line.y2, shape->data.line.stroke);
+                break;
+        }
+    }
+    fclose(file);
+}
+
+static void save_writer(const SvgDocument *doc, const char *path)
+{
+    SvgWriter w;
+    if (!svg_writer_open(&w, path)) return;
+    for (int i = 0; i < doc->shape_count; i++) {
+        const SvgShape *shape = svg_document_shape(doc, i);
+        switch (shape->type) {
+            case SVG_SHAPE_CIRCLE:
+                svg_writer_str(&w, "  <circle");
+                svg_writer_attr(&w, "cx", shape->data.circle.cx);
+                svg_writer_attr(&w, "cy", shape->data.circle.cy);
+                svg_writer_attr(&w, "r", shape->data.circle.r);
+                svg_writer_attr_str(&w, "fill", shape->data.circle.fill);
+                break;
+            case SVG_SHAPE_RECT:
+                svg_writer_str(&w, "  <rect");
+                svg_writer_attr(&w, "x", shape->data.rect.x);
+                svg_writer_attr(&w, "y", shape->data.rect.y);
+                svg_writer_attr(&w, "width", shape->data.rect.width);
+                svg_writer_attr(&w, "height", shape->data.rect.height);
+                svg_writer_attr_str(&w, "fill", shape->data.rect.fill);
+                break;
+            case SVG_SHAPE_LINE:
+                svg_writer_str(&w, "  <line");
+                svg_writer_attr(&w, "x1", shape->data.line.x1);
+                svg_writer_attr(&w, "y1", shape->data.line.y1);
+                svg_writer_attr(&w, "x2", shape->data.line.x2);
+                svg_writer_attr(&w, "y2", shape->data.line.y2);
+                svg_writer_attr_str(&w, "stroke", shape->data.line.stroke);
+                break;
+        }
+        svg_writer_str(&w, "/>\n");
+    }
+    svg_writer_close(&w);
+}
+
+// Coordinates of a shape in attribute order, returns how many
+static int shape_numbers(const SvgShape *shape, double *v)
+{
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE:
+            v[0] = shape->data.circle.cx; v[1] = shape->data.circle.cy; v[2] = shape->data.circle.r;
+            return 3;
+        case SVG_SHAPE_RECT:
+            v[0] = shape->data.rect.x; v[1] = shape->data.rect.y;
+            v[2] = shape->data.rect.width; v[3] = shape->data.rect.height;
+            return 4;
+        case SVG_SHAPE_LINE:
+            v[0] = shape->data.line.x1; v[1] = shape->data.line.y1;
+            v[2] = shape->data.line.x2; v[3] = shape->data.line.y2;
+            return 4;
+    }
+    return 0;
+}
+
+// Every coordinate must read back bit for bit
+static long count_lossy(const SvgDocument *doc)
+{
+    char text[SVG_NUMBER_MAX];
+    long lossy = 0;
+    for (int i = 0; i < doc->shape_count; i++) {
+        double v[4];
+        int n = shape_numbers(svg_document_shape(doc, i), v);
+        for (int k = 0; k < n; k++) {
+            svg_format_number(text, v[k]);
+            lossy += strtod(text, NULL) != v[k];
+        }
+    }
+    return lossy;
+}
+
+static long file_size(const char *path)
+{
+    FILE *file = fopen(path, "rb");
+    if (!file) return 0;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+static int bench_save(int count, int iterations)
+{
+    const char *names[2] = {"rounded", "full"};
+    int failed = 0;
+
+    printf("shapes: %d, iterations: %d\n", count, iterations);
+    for (int mode = 0; mode < 2; mode++) {
+        SvgDocument *doc = create_svg_document(BENCH_WIDTH, BENCH_HEIGHT);
+        if (!doc) return 1;
+        for (int i = 0; i < count; i++) {
+            double v[4];
+            for (int k = 0; k < 4; k++) {
+                double x = bench_rand(0, BENCH_WIDTH);
+                // Hundredths as written by hand or by tools, or the output of a transform
+                v[k] = mode == 0 ? round(x * 100) / 100 : x / 3 + 0.1;
+            }
+            SvgShape shape = {0};
+            switch (i % 3) {
+                case 0:
+                    shape.type = SVG_SHAPE_CIRCLE;
+                    shape.data.circle = (SvgCircle){v[0], v[1], v[2], "#4A90E2"};
+                    break;
+                case 1:
+                    shape.type = SVG_SHAPE_RECT;
+                    shape.data.rect = (SvgRect){v[0], v[1], v[2], v[3], "red"};
+                    break;
+                default:
+                    shape.type = SVG_SHAPE_LINE;
+                    shape.data.line = (SvgLine){v[0], v[1], v[2], v[3], "#333"};
+                    break;
+            }
+            if (svg_document_add(doc, &shape) < 0) {
+                free_svg_document(doc);
+                return 1;
+            }
+        }
+
+        // Per method: time into the file, time into /dev/null, size written
+        const char *methods[3] = {"fprintf %.1f", "fprintf %.17g", "buffered shortest"};
+        double t_file[3], t_null[3];
+        long size[3];
+        for (int m = 0; m < 3; m++) {
+            for (int target = 0; target < 2; target++) {
+                const char *path = target == 0 ? BENCH_SAVE_FILE : BENCH_SAVE_NULL;
+                double t0 = now_seconds();
+                for (int it = 0; it < iterations; it++) {
+                    if (m == 2) save_writer(doc, path);
+                    else save_fprintf(doc, m == 0 ? "%.1f" : "%.17g", path);
+                }
+                double t = (now_seconds() - t0) / iterations;
+                if (target == 0) t_file[m] = t;
+                else t_null[m] = t;
+            }
+            size[m] = file_size(BENCH_SAVE_FILE);
+        }
+
+        long lossy = count_lossy(doc);
+        failed |= lossy != 0 || size[2] == 0;
+
+        printf("%s coordinates:\n", names[mode]);
+        printf("  %-22s %12s %12s %10s\n", "", "to file", "to /dev/null", "size");
+        for (int m = 0; m < 3; m++) {
+            printf("  %-22s %9.1f ms %9.1f ms %7.1f MB%s\n", methods[m], t_file[m] * 1000,
+                   t_null[m] * 1000, size[m] / 1e6, m == 0 ? " (lossy)" : "");
+        }
+        for (int m = 0; m < 2; m++) {
+            printf("  %-22s %11.1fx %11.1fx\n", m == 0 ? "speedup vs %.1f" : "speedup vs %.17g",
+                   t_file[m] / t_file[2], t_null[m] / t_null[2]);
+        }
+        printf("  round trip: %s\n", lossy ? "LOSSY" : "exact");
+        free_svg_document(doc);
+    }
+    remove(BENCH_SAVE_FILE);
+    return failed;
+}
+
+// Background clear: per-pixel struct stores vs image_fill
+static int bench_clear(int iterations)
+{
+    Image *img = create_image(BENCH_WIDTH * 4, BENCH_HEIGHT * 4);
+    RGBColor colors[2] = {{255, 255, 255}, {240, 128, 16}};
+    const char *names[2] = {"white", "coloured"};
+
+    printf("canvas: %dx%d, iterations: %d\n", img->width, img->height, iterations * 10);
+    for (int c = 0; c < 2; c++) {
+        double t0 = now_seconds();
+        for (int it = 0; it < iterations * 10; it++) {
+            for (int i = 0; i < img->width * img->height; i++) {
+                img->pixels[i] = colors[c];
+            }
+        }
+        double t_loop = (now_seconds() - t0) / (iterations * 10);
+
+        t0 = now_seconds();
+        for (int it = 0; it < iterations * 10; it++) {
+            image_fill(img, colors[c]);
+        }
+        double t_fill = (now_seconds() - t0) / (iterations * 10);
+
+        printf("%-9s per-pixel %8.3f ms, image_fill %8.3f ms (%.1fx)\n",
+               names[c], t_loop * 1000, t_fill * 1000, t_loop / t_fill);
+    }
+
+    free_image(img);
+    return 0;
+}
+
+/********************* Usage *********************/
+static void print_usage(void)
+{
+    printf("Usage:\n");
+    printf("  ./svg_bench tiles [input.svg] [--shapes N] [--threads N] [--iterations N]\n");
+    printf("  ./svg_bench occlusion [input.svg] [--shapes N] [--threads N] [--iterations N]\n");
+    printf("  ./svg_bench clear [--iterations N]\n");
+    printf("  ./svg_bench displaylist [input.svg] [--shapes N] [--iterations N]\n");
+    printf("  ./svg_bench region [input.svg] [--shapes N] [--iterations N]\n");
+    printf("  ./svg_bench index [--shapes N] [--iterations N]\n");
+    printf("  ./svg_bench store [--shapes N] [--iterations N]\n");
+    printf("  ./svg_bench save [--shapes N] [--iterations N]\n");
+    printf("\n");
+    printf("Without an input file a synthetic %dx%d scene of --shapes shapes is used.\n",
+           BENCH_WIDTH, BENCH_HEIGHT);
+}
+
+/********************* Main *********************/
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        print_usage();
+        return 1;
+    }
+
+    const char *input_file = NULL;
+    int shapes = 100000;
+    int threads = cpu_count();
+    int iterations = 5;
+
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--shapes") == 0 && i + 1 < argc)
+        {
+            shapes = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = atoi(argv[++i]);
+        }
+        else
+        {
+            input_file = argv[i];
+        }
+    }
+    if (shapes < 1) shapes = 1;
+    if (threads < 1) threads = 1;
+    if (iterations < 1) iterations = 1;
+
+    if (strcmp(argv[1], "tiles") == 0)
+    {
+        return bench_tiles(input_file, shapes, threads, iterations);
+    }
+    if (strcmp(argv[1], "occlusion") == 0)
+    {
+        return bench_occlusion(input_file, shapes, threads, iterations);
+    }
+    if (strcmp(argv[1], "displaylist") == 0)
+    {
+        return bench_displaylist(input_file, shapes, iterations);
+    }
+    if (strcmp(argv[1], "region") == 0)
+    {
+        return bench_region(input_file, shapes, iterations);
+    }
+    if (strcmp(argv[1], "index") == 0)
+    {
+        return bench_index(shapes, iterations);
+    }
+    if (strcmp(argv[1], "store") == 0)
+    {
+        return bench_store(shapes, iterations);
+    }
+    if (strcmp(argv[1], "save") == 0)
+    {
+        return bench_save(shapes, iterations);
+    }
+    if (strcmp(argv[1], "clear") == 0)
+    {
+        return bench_clear(iterations);
+    }
+
+    print_usage();
+    return 1;
+}
@@ -1,6 +1,8 @@
 #include "../include/bmp_writer.h"
 #include <stdio.h>
+#include <stdlib.h>
 
+// 带 alpha 通道时写 32 位 BGRA（BITMAPV4HEADER + BI_BITFIELDS），否则写 24 位 BGR
 void write_bmp(const char *filename, Image *img) {
     FILE *file = fopen(filename, "wb");
     if (!file) {
@@ -10,46 +12,63 @@ void write_bmp(const char *filename, Image *img) {
     
     int width = img->width;
     int height = img->height;
-    int padding = (4 - (width * 3) % 4) % 4;
-    int image_size = (width * 3 + padding) * height;
-    int file_size = 54 + image_size;
+    int has_alpha = img->alpha != NULL;
+    int bytes_per_pixel = has_alpha ? 4 : 3;
+    int info_size = has_alpha ? 108 : 40;
+    int header_size = 14 + info_size;
+    int row_size = (width * bytes_per_pixel + 3) & ~3;
+    int image_size = row_size * height;
+    int file_size = header_size + image_size;
     
     // BMP文件头
     unsigned char file_header[14] = {
         'B', 'M',           // 签名
         file_size, file_size >> 8, file_size >> 16, file_size >> 24, // 文件大小
         0, 0, 0, 0,         // 保留
-        54, 0, 0, 0         // 像素数据偏移
+        header_size, 0, 0, 0 // 像素数据偏移
     };
     
-    // BMP信息头
-    unsigned char info_header[40] = {
-        40, 0, 0, 0,        // 信息头大小
+    // BMP信息头（V4 头的前 40 字节与 BITMAPINFOHEADER 相同）
+    unsigned char info_header[108] = {
+        info_size, 0, 0, 0, // 信息头大小
         width, width >> 8, width >> 16, width >> 24,      // 宽度
         height, height >> 8, height >> 16, height >> 24,  // 高度
         1, 0,               // 颜色平面数
-        24, 0,              // 每像素位数
-        0, 0, 0, 0,         // 压缩方式
+        bytes_per_pixel * 8, 0, // 每像素位数
+        has_alpha ? 3 : 0, 0, 0, 0, // 压缩方式 (BI_RGB / BI_BITFIELDS)
         image_size, image_size >> 8, image_size >> 16, image_size >> 24, // 图像数据大小
         0, 0, 0, 0,         // 水平分辨率
         0, 0, 0, 0,         // 垂直分辨率
         0, 0, 0, 0,         // 调色板颜色数
-        0, 0, 0, 0          // 重要颜色数
+        0, 0, 0, 0,         // 重要颜色数
+        0, 0, 0xFF, 0,      // 红色掩码
+        0, 0xFF, 0, 0,      // 绿色掩码
+        0xFF, 0, 0, 0,      // 蓝色掩码
+        0, 0, 0, 0xFF,      // alpha 掩码
+        'B', 'G', 'R', 's'  // 色彩空间 LCS_sRGB
     };
     
     fwrite(file_header, 1, 14, file);
-    fwrite(info_header, 1, 40, file);
+    fwrite(info_header, 1, info_size, file);
     
-    // 像素数据 (BGR格式，从下到上)
-    unsigned char padding_data[3] = {0, 0, 0};
+    // 像素数据 (BGR/BGRA格式，从下到上)，整行写入
+    unsigned char *row = calloc(row_size, 1);
+    if (!row) {
+        fclose(file);
+        return;
+    }
     for (int y = height - 1; y >= 0; y--) {
+        const RGBColor *src = img->pixels + (size_t)y * width;
+        unsigned char *dst = row;
         for (int x = 0; x < width; x++) {
-            RGBColor pixel = img->pixels[y * width + x];
-            unsigned char color[3] = {pixel.b, pixel.g, pixel.r};
-            fwrite(color, 1, 3, file);
+            *dst++ = src[x].b;
+            *dst++ = src[x].g;
+            *dst++ = src[x].r;
+            if (has_alpha) *dst++ = img->alpha[(size_t)y * width + x];
         }
-        fwrite(padding_data, 1, padding, file);
+        fwrite(row, 1, row_size, file);
     }
     
+    free(row);
     fclose(file);
-}
\ No newline at end of file
+}
@@ -1,18 +1,34 @@
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
 
 #include "../include/image.h"
 
+// 短于此长度的区间直接逐像素写入
+#define FILL_COPY_THRESHOLD 32
+
 Image* create_image(int width, int height) {
+    if (width <= 0 || height <= 0) return NULL;
+    // 像素数按 size_t 计算，超出可分配范围时直接失败
+    if ((size_t)width > SIZE_MAX / sizeof(RGBColor) / (size_t)height) return NULL;
+
     Image *img = malloc(sizeof(Image));
+    if (!img) return NULL;
     img->width = width;
     img->height = height;
-    img->pixels = calloc(width * height, sizeof(RGBColor));
+    img->pixels = calloc((size_t)width * height, sizeof(RGBColor));
+    img->alpha = NULL;
+    if (!img->pixels) {
+        free(img);
+        return NULL;
+    }
     return img;
 }
 
 void free_image(Image *img) {
     if (img) {
         free(img->pixels);
+        free(img->alpha);
         free(img);
     }
 }
@@ -20,5 +36,67 @@ void free_image(Image *img) {
 void set_pixel(Image *img, int x, int y, RGBColor color) {
     if (x >= 0 && x < img->width && y >= 0 && y < img->height) {
         img->pixels[y * img->width + x] = color;
+        if (img->alpha) img->alpha[y * img->width + x] = 255;
+    }
+}
+
+int image_enable_alpha(Image *img) {
+    if (!img->alpha) {
+        img->alpha = calloc((size_t)img->width * img->height, 1);
+    }
+    return img->alpha != NULL;
+}
+
+// 连续填充 n 个像素
+static void fill_pixels(RGBColor *dst, size_t n, RGBColor color) {
+    if (color.r == color.g && color.g == color.b) {
+        memset(dst, color.r, n * sizeof(RGBColor));
+        return;
+    }
+    if (n < FILL_COPY_THRESHOLD) {
+        for (size_t i = 0; i < n; i++) dst[i] = color;
+        return;
+    }
+
+    dst[0] = color;
+    size_t done = 1;
+    while (done < n) {
+        size_t k = done < n - done ? done : n - done;
+        memcpy(dst + done, dst, k * sizeof(RGBColor));
+        done += k;
+    }
+}
+
+void image_fill(Image *img, RGBColor color) {
+    size_t n = (size_t)img->width * img->height;
+    fill_pixels(img->pixels, n, color);
+    if (img->alpha) memset(img->alpha, 255, n);
+}
+
+void image_fill_span(Image *img, int y, int x0, int x1, RGBColor color) {
+    size_t offset = (size_t)y * img->width + x0;
+    fill_pixels(img->pixels + offset, x1 - x0, color);
+    if (img->alpha) memset(img->alpha + offset, 255, x1 - x0);
+}
+
+// 只生成第一行，其余行直接拷贝
+void image_fill_rect(Image *img, int x0, int y0, int x1, int y1, RGBColor color) {
+    if (x0 < 0) x0 = 0;
+    if (y0 < 0) y0 = 0;
+    if (x1 > img->width) x1 = img->width;
+    if (y1 > img->height) y1 = img->height;
+    if (x0 >= x1 || y0 >= y1) return;
+
+    RGBColor *first = img->pixels + (size_t)y0 * img->width + x0;
+    size_t bytes = (size_t)(x1 - x0) * sizeof(RGBColor);
+    fill_pixels(first, x1 - x0, color);
+    for (int y = y0 + 1; y < y1; y++) {
+        memcpy(img->pixels + (size_t)y * img->width + x0, first, bytes);
     }
-}
\ No newline at end of file
+
+    if (img->alpha) {
+        for (int y = y0; y < y1; y++) {
+            memset(img->alpha + (size_t)y * img->width + x0, 255, x1 - x0);
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#include <stdio.h>
+#include <stdarg.h>
+
+#include "../include/log.h"
+
+int log_level = LOG_LEVEL_WARN;
+
+static const char *level_prefix[] = {"错误: ", "警告: ", "", "", ""};
+
+void log_set_level(int level)
+{
+    if (level < LOG_LEVEL_ERROR) level = LOG_LEVEL_ERROR;
+    if (level > LOG_LEVEL_TRACE) level = LOG_LEVEL_TRACE;
+    log_level = level;
+}
+
+// 日志统一写到 stderr，stdout 只留给命令本身的输出
+void log_write(int level, const char *fmt, ...)
+{
+    va_list args;
+
+    fputs(level_prefix[level], stderr);
+    va_start(args, fmt);
+    vfprintf(stderr, fmt, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 #include "../include/svg_types.h"
 #include "../include/svg_parser.h"
@@ -8,8 +9,22 @@
 #include "../include/jpg_writer.h"
 #include "../include/image.h"
 #include "../include/bmp_writer.h"
+#include "../include/svg_tile_render.h"
+#include "../include/log.h"
+#include "../include/thread_pool.h"
+#include "../include/svg_tile_pyramid.h"
 
 
+// 文档没有给出尺寸时的画布大小
+#define DEFAULT_WIDTH 800
+#define DEFAULT_HEIGHT 600
+// 输出边长上限，避免参数写错时申请巨大内存
+#define MAX_OUTPUT_SIZE 32768
+// 金字塔层数上限
+#define MAX_PYRAMID_LEVELS 20
+// CSS 像素的 DPI
+#define CSS_DPI 96.0f
+
 /********************* Usage *********************/
 void print_usage()
 {
@@ -20,7 +35,94 @@ void print_usage()
     printf("  ./svg_processor -eb input.svg output.bmp\n");
     printf("  ./svg_processor --export_jpg input.svg output.jpg\n");
     printf("  ./svg_processor -ej input.svg output.jpg\n");
-    
+    printf("  ./svg_processor --tiles out_dir input.svg [--tile-size N] [--levels N]\n");
+    printf("\nRender options (export only):\n");
+    printf("  --tiled             render in %dx%d tiles on a thread pool\n", RENDER_TILE_SIZE, RENDER_TILE_SIZE);
+    printf("  --threads N         worker threads for --tiled (default: all cores)\n");
+    printf("  --occlusion         tiled, front-to-back with occlusion culling; prints overdraw stats\n");
+    printf("  --background C      background colour (name, #RGB, #RRGGBB, rgb()) or none/transparent\n");
+    printf("                      (transparent is kept in BMP output as 32-bit alpha)\n");
+    printf("  --width W           output width in pixels (height follows the aspect ratio)\n");
+    printf("  --height H          output height in pixels (width follows the aspect ratio)\n");
+    printf("  --scale S           output size = document size * S\n");
+    printf("  --dpi D             same as --scale D/96\n");
+    printf("                      (default: document width/height, else viewBox, else %dx%d)\n", DEFAULT_WIDTH, DEFAULT_HEIGHT);
+    printf("  --crop X,Y,W,H      render only this window (document units); size options apply to the crop\n");
+    printf("\nTile pyramid (--tiles):\n");
+    printf("  --tile-size N       tile edge in pixels (default: %d)\n", PYRAMID_TILE_SIZE);
+    printf("  --levels N          zoom levels 0..N-1, level 0 fits the document in one tile (default: 1)\n");
+    printf("                      tiles go to out_dir/z/x/y.jpg; background-only tiles are skipped;\n");
+    printf("                      --threads, --background and --crop also apply\n");
+    printf("\nLogging (to stderr, quiet by default):\n");
+    printf("  -v                  info: input size and render time\n");
+    printf("  -vv                 debug: parser and display list summaries\n");
+    printf("  -vvv                trace: one line per shape (build with make LOG_LEVEL=4)\n");
+}
+
+// -v / -vv / -vvv 设置日志级别，可以出现在任意位置
+static int parse_verbosity(const char *arg)
+{
+    if (strcmp(arg, "-v") == 0) return LOG_LEVEL_INFO;
+    if (strcmp(arg, "-vv") == 0) return LOG_LEVEL_DEBUG;
+    if (strcmp(arg, "-vvv") == 0) return LOG_LEVEL_TRACE;
+    return -1;
+}
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+// 瓦片金字塔：解析和编译一次，按窗口（viewBox 或 --crop）切瓦片
+static int export_pyramid(const char *input_file, const DisplayListRect *crop, const PyramidOptions *opts)
+{
+    SVGShape *shapes;
+    int shape_count;
+    SVGViewport viewport;
+    if (!parse_svg_ex(input_file, &shapes, &shape_count, &viewport))
+    {
+        return 1;
+    }
+
+    float doc_w, doc_h;
+    svg_viewport_size(&viewport, DEFAULT_WIDTH, DEFAULT_HEIGHT, &doc_w, &doc_h);
+
+    DisplayListRect window = {0, 0, doc_w, doc_h};
+    if (crop->w > 0)
+    {
+        window = *crop;
+    }
+    else if (viewport.has_viewbox)
+    {
+        window.x = viewport.vb_x;
+        window.y = viewport.vb_y;
+        window.w = viewport.vb_w;
+        window.h = viewport.vb_h;
+    }
+
+    DisplayList *dl = display_list_compile(shapes, shape_count, doc_w, doc_h,
+                                           opts->threads > 0 ? opts->threads : cpu_count());
+    free(shapes);
+    if (!dl)
+    {
+        LOG_ERROR("渲染内存不足");
+        return 1;
+    }
+
+    PyramidStats stats;
+    int ok = export_tile_pyramid(dl, &window, opts, &stats);
+    display_list_free(dl);
+
+    print_pyramid_stats(&stats);
+    if (!ok)
+    {
+        printf("error: tile export failed\n");
+        return 1;
+    }
+    printf("已生成瓦片: %s\n", opts->out_dir);
+    return 0;
 }
 
 /********************* Main *********************/
@@ -32,19 +134,30 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    for (int i = 1; i < argc; i++)
+    {
+        int level = parse_verbosity(argv[i]);
+        if (level >= 0)
+        {
+            log_set_level(level);
+        }
+    }
+
     char *input_file = NULL;
     char *output_file = NULL;
     int export_jpg = 0;
     int export_bmp = 0;
+    int tiled = 0;
+    OcclusionStats occlusion_stats;
+    RenderBackground background = {{255, 255, 255}, 0};
+    int out_width = 0, out_height = 0;
+    float scale = 0;
+    DisplayListRect crop = {0, 0, 0, 0};
+    PyramidOptions pyramid = {NULL, 0, 1, 0, 90, &background};
+    TileRenderOptions tile_opts = {0, 0, 0, NULL, &background};
 
-    if (strcmp(argv[1], "--export_jpg") == 0 || strcmp(argv[1], "-ej") == 0 || strcmp(argv[1], "--export_bmp") == 0 || strcmp(argv[1], "-eb") == 0)
+    if (strcmp(argv[1], "--export_jpg") == 0 || strcmp(argv[1], "-ej") == 0 || strcmp(argv[1], "--export_bmp") == 0 || strcmp(argv[1], "-eb") == 0 || strcmp(argv[1], "--tiles") == 0)
     {
-        if (argc != 4)
-        {
-            print_usage();
-            return 1;
-        }
-
         // 解析命令行参数
         for (int i = 1; i < argc; i++)
         {
@@ -56,14 +169,120 @@ int main(int argc, char *argv[])
             {
                 export_bmp = 1;
             }
+            else if (parse_verbosity(argv[i]) >= 0)
+            {
+                continue;
+            }
+            else if (strcmp(argv[i], "--tiled") == 0)
+            {
+                tiled = 1;
+            }
+            else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            {
+                tile_opts.threads = atoi(argv[++i]);
+                pyramid.threads = tile_opts.threads;
+                tiled = 1;
+            }
+            else if (strcmp(argv[i], "--tiles") == 0 && i + 1 < argc)
+            {
+                pyramid.out_dir = argv[++i];
+            }
+            else if (strcmp(argv[i], "--tile-size") == 0 && i + 1 < argc)
+            {
+                pyramid.tile_size = atoi(argv[++i]);
+                if (pyramid.tile_size <= 0 || pyramid.tile_size > MAX_OUTPUT_SIZE)
+                {
+                    printf("error: invalid tile size: %s\n", argv[i]);
+                    return 1;
+                }
+            }
+            else if (strcmp(argv[i], "--levels") == 0 && i + 1 < argc)
+            {
+                pyramid.levels = atoi(argv[++i]);
+                if (pyramid.levels <= 0 || pyramid.levels > MAX_PYRAMID_LEVELS)
+                {
+                    printf("error: levels must be 1..%d: %s\n", MAX_PYRAMID_LEVELS, argv[i]);
+                    return 1;
+                }
+            }
+            else if (strcmp(argv[i], "--occlusion") == 0)
+            {
+                tile_opts.occlusion_cull = 1;
+                tile_opts.stats = &occlusion_stats;
+                tiled = 1;
+            }
+            else if (strcmp(argv[i], "--width") == 0 && i + 1 < argc)
+            {
+                out_width = atoi(argv[++i]);
+                if (out_width <= 0 || out_width > MAX_OUTPUT_SIZE)
+                {
+                    printf("error: invalid width: %s\n", argv[i]);
+                    return 1;
+                }
+            }
+            else if (strcmp(argv[i], "--height") == 0 && i + 1 < argc)
+            {
+                out_height = atoi(argv[++i]);
+                if (out_height <= 0 || out_height > MAX_OUTPUT_SIZE)
+                {
+                    printf("error: invalid height: %s\n", argv[i]);
+                    return 1;
+                }
+            }
+            else if ((strcmp(argv[i], "--scale") == 0 || strcmp(argv[i], "--dpi") == 0) && i + 1 < argc)
+            {
+                int dpi = strcmp(argv[i], "--dpi") == 0;
+                scale = (float)atof(argv[++i]);
+                if (scale <= 0)
+                {
+                    printf("error: invalid %s: %s\n", dpi ? "dpi" : "scale", argv[i]);
+                    return 1;
+                }
+                if (dpi)
+                {
+                    scale /= CSS_DPI;
+                }
+            }
+            else if (strcmp(argv[i], "--crop") == 0 && i + 1 < argc)
+            {
+                if (sscanf(argv[++i], "%f,%f,%f,%f", &crop.x, &crop.y, &crop.w, &crop.h) != 4 || crop.w <= 0 || crop.h <= 0)
+                {
+                    printf("error: invalid crop (expected X,Y,W,H): %s\n", argv[i]);
+                    return 1;
+                }
+            }
+            else if (strcmp(argv[i], "--background") == 0 && i + 1 < argc)
+            {
+                if (!render_parse_background(argv[++i], &background))
+                {
+                    printf("error: invalid background colour: %s\n", argv[i]);
+                    return 1;
+                }
+            }
             else if (!input_file)
             {
                 input_file = argv[i];
             }
-            else
+            else if (!output_file)
             {
                 output_file = argv[i];
             }
+            else
+            {
+                print_usage();
+                return 1;
+            }
+        }
+
+        if (pyramid.out_dir)
+        {
+            if (!input_file || output_file)
+            {
+                printf("error: --tiles takes exactly one input file\n");
+                print_usage();
+                return 1;
+            }
+            return export_pyramid(input_file, &crop, &pyramid);
         }
 
         if (!input_file || !output_file)
@@ -83,16 +302,90 @@ int main(int argc, char *argv[])
         // 解析SVG文件
         SVGShape *shapes;
         int shape_count;
-        if (!parse_svg(input_file, &shapes, &shape_count))
+        SVGViewport viewport;
+        if (!parse_svg_ex(input_file, &shapes, &shape_count, &viewport))
         {
             return 1;
         }
 
-        // 创建图像 (假设固定尺寸，实际应该从SVG中获取)
-        Image *img = create_image(800, 600);
+        // 输出尺寸：--width/--height 优先，其次文档（或裁切窗口）尺寸乘以 --scale/--dpi
+        float doc_w, doc_h;
+        svg_viewport_size(&viewport, DEFAULT_WIDTH, DEFAULT_HEIGHT, &doc_w, &doc_h);
+        DisplayListView base = svg_viewport_view(&viewport, doc_w, doc_h, (int)(doc_w + 0.5f), (int)(doc_h + 0.5f));
+        float src_w = doc_w, src_h = doc_h;
+        if (crop.w > 0)
+        {
+            // 裁切窗口是文档坐标（viewBox 单位），按文档的固有缩放换算成像素
+            src_w = crop.w * base.scale_x;
+            src_h = crop.h * base.scale_y;
+        }
+        if (!out_width && !out_height)
+        {
+            float s = scale > 0 ? scale : 1.0f;
+            out_width = (int)(src_w * s + 0.5f);
+            out_height = (int)(src_h * s + 0.5f);
+        }
+        else if (!out_height)
+        {
+            out_height = (int)(out_width * src_h / src_w + 0.5f);
+        }
+        else if (!out_width)
+        {
+            out_width = (int)(out_height * src_w / src_h + 0.5f);
+        }
+        if (out_width < 1) out_width = 1;
+        if (out_height < 1) out_height = 1;
+        if (out_width > MAX_OUTPUT_SIZE || out_height > MAX_OUTPUT_SIZE)
+        {
+            printf("error: output size %dx%d is too large\n", out_width, out_height);
+            free(shapes);
+            return 1;
+        }
+
+        Image *img = create_image(out_width, out_height);
+        if (!img)
+        {
+            printf("error: out of memory for %dx%d output\n", out_width, out_height);
+            free(shapes);
+            return 1;
+        }
+        if (background.transparent && export_bmp)
+        {
+            image_enable_alpha(img);
+        }
 
-        // 渲染SVG到图像
-        render_svg_to_image(img, shapes, shape_count);
+        LOG_INFO("%s: %d 个形状, 文档 %.0fx%.0f, 输出 %dx%d", input_file, shape_count, doc_w, doc_h, img->width, img->height);
+
+        // 编译一次，视口变换在回放时作用到每条命令上，光栅化只涉及输出像素
+        double t0 = now_ms();
+        DisplayList *dl = display_list_compile(shapes, shape_count, doc_w, doc_h, tiled ? (tile_opts.threads > 0 ? tile_opts.threads : cpu_count()) : 1);
+        if (!dl)
+        {
+            LOG_ERROR("渲染内存不足");
+            free(shapes);
+            free_image(img);
+            return 1;
+        }
+        // --crop 的回放对每条命令做一次包围盒比较（O(N)，每条只比四个数），光栅化只涉及窗口内的命令。
+        // 单次渲染不建空间索引：建索引本身也要遍历全部命令，只有同一文档反复取窗口
+        // （瓦片金字塔）时 display_list_build_index 才划算
+        DisplayListView view = crop.w > 0 ? display_list_view_region(&crop, img->width, img->height)
+                                          : svg_viewport_view(&viewport, doc_w, doc_h, img->width, img->height);
+
+        if (tiled)
+        {
+            render_display_list_tiled(dl, img, &view, &tile_opts);
+            if (tile_opts.occlusion_cull)
+            {
+                print_occlusion_stats(&occlusion_stats);
+            }
+        }
+        else
+        {
+            display_list_render(dl, img, &view, &background);
+        }
+        LOG_INFO("渲染耗时 %.2f ms", now_ms() - t0);
+        display_list_free(dl);
 
         // 输出文件
         if (export_jpg)
@@ -114,7 +407,19 @@ int main(int argc, char *argv[])
     }
     else if ((strcmp(argv[1], "--parser") == 0) || strcmp(argv[1], "-p") == 0)
     {
-        const char *input = argv[2];
+        const char *input = NULL;
+        for (int i = 2; i < argc && !input; i++)
+        {
+            if (parse_verbosity(argv[i]) < 0)
+            {
+                input = argv[i];
+            }
+        }
+        if (!input)
+        {
+            print_usage();
+            return 1;
+        }
 
         SvgDocument *doc = NULL;
         if (svg_load_from_file(input, &doc) != 0)
@@ -0,0 +1,337 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../include/spatial_grid.h"
+
+// 平均每格条目数
+#define GRID_ITEMS_PER_CELL 8
+// 每边格子数上限
+#define GRID_MAX_DIM 1024
+// 跨越超过这么多格子的条目放进大条目表
+#define GRID_BIG_CELLS 256
+
+SpatialGrid *spatial_grid_create(float x0, float y0, float x1, float y1, int expected_items)
+{
+    SpatialGrid *grid = calloc(1, sizeof(SpatialGrid));
+    if (!grid) return NULL;
+
+    float w = x1 > x0 ? x1 - x0 : 1.0f;
+    float h = y1 > y0 ? y1 - y0 : 1.0f;
+
+    // 格子接近正方形，总数约为 expected_items / GRID_ITEMS_PER_CELL
+    int cells = expected_items / GRID_ITEMS_PER_CELL;
+    if (cells < 1) cells = 1;
+    float side = sqrtf(w * h / cells);
+    int cols = (int)ceilf(w / side), rows = (int)ceilf(h / side);
+    if (cols < 1) cols = 1;
+    if (rows < 1) rows = 1;
+    if (cols > GRID_MAX_DIM) cols = GRID_MAX_DIM;
+    if (rows > GRID_MAX_DIM) rows = GRID_MAX_DIM;
+
+    grid->origin_x = x0;
+    grid->origin_y = y0;
+    grid->cols = cols;
+    grid->rows = rows;
+    grid->cell_w = w / cols;
+    grid->cell_h = h / rows;
+    grid->cells = calloc((size_t)cols * rows, sizeof(GridCell));
+    if (!grid->cells) {
+        free(grid);
+        return NULL;
+    }
+    return grid;
+}
+
+void spatial_grid_free(SpatialGrid *grid)
+{
+    if (!grid) return;
+    for (int i = 0; i < grid->cols * grid->rows; i++) {
+        free(grid->cells[i].ids);
+    }
+    free(grid->cells);
+    free(grid->boxes);
+    free(grid->live);
+    free(grid->big.ids);
+    free(grid);
+}
+
+static int cell_push(GridCell *cell, int id)
+{
+    if (cell->count >= cell->capacity) {
+        int capacity = cell->capacity ? cell->capacity * 2 : 4;
+        int *ids = realloc(cell->ids, capacity * sizeof(int));
+        if (!ids) return 0;
+        cell->ids = ids;
+        cell->capacity = capacity;
+    }
+    cell->ids[cell->count++] = id;
+    return 1;
+}
+
+static int clamp_index(int v, int n)
+{
+    return v < 0 ? 0 : (v >= n ? n - 1 : v);
+}
+
+// 包围盒覆盖的格子范围（闭区间），范围外的部分归到边缘格子
+static void cell_span(const SpatialGrid *grid, const GridBox *box,
+                      int *cx0, int *cy0, int *cx1, int *cy1)
+{
+    *cx0 = clamp_index((int)floorf((box->x0 - grid->origin_x) / grid->cell_w), grid->cols);
+    *cy0 = clamp_index((int)floorf((box->y0 - grid->origin_y) / grid->cell_h), grid->rows);
+    *cx1 = clamp_index((int)floorf((box->x1 - grid->origin_x) / grid->cell_w), grid->cols);
+    *cy1 = clamp_index((int)floorf((box->y1 - grid->origin_y) / grid->cell_h), grid->rows);
+}
+
+static int box_is_empty(const GridBox *box)
+{
+    return !(box->x0 <= box->x1 && box->y0 <= box->y1);
+}
+
+static int span_is_big(int cx0, int cy0, int cx1, int cy1)
+{
+    return (long)(cx1 - cx0 + 1) * (cy1 - cy0 + 1) > GRID_BIG_CELLS;
+}
+
+static int reserve_ids(SpatialGrid *grid, int id)
+{
+    if (id < grid->box_capacity) return 1;
+
+    int capacity = grid->box_capacity ? grid->box_capacity : 64;
+    while (capacity <= id) capacity *= 2;
+    GridBox *boxes = realloc(grid->boxes, capacity * sizeof(GridBox));
+    if (!boxes) return 0;
+    grid->boxes = boxes;
+    unsigned char *live = realloc(grid->live, capacity);
+    if (!live) return 0;
+    memset(live + grid->box_capacity, 0, capacity - grid->box_capacity);
+    grid->live = live;
+    grid->box_capacity = capacity;
+    return 1;
+}
+
+// 从格子里摘掉编号，格子内不要求有序
+static void cell_remove(GridCell *cell, int id)
+{
+    for (int k = 0; k < cell->count; k++) {
+        if (cell->ids[k] == id) {
+            cell->ids[k] = cell->ids[--cell->count];
+            return;
+        }
+    }
+}
+
+static void unlink_item(SpatialGrid *grid, int id)
+{
+    int cx0, cy0, cx1, cy1;
+    cell_span(grid, &grid->boxes[id], &cx0, &cy0, &cx1, &cy1);
+
+    if (span_is_big(cx0, cy0, cx1, cy1)) {
+        cell_remove(&grid->big, id);
+        return;
+    }
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            cell_remove(&grid->cells[cy * grid->cols + cx], id);
+        }
+    }
+}
+
+static int link_item(SpatialGrid *grid, int id)
+{
+    int cx0, cy0, cx1, cy1;
+    cell_span(grid, &grid->boxes[id], &cx0, &cy0, &cx1, &cy1);
+
+    if (span_is_big(cx0, cy0, cx1, cy1)) {
+        return cell_push(&grid->big, id);
+    }
+    for (int cy = cy0; cy <= cy1; cy++) {
+        for (int cx = cx0; cx <= cx1; cx++) {
+            if (!cell_push(&grid->cells[cy * grid->cols + cx], id)) {
+                // 回滚已登记的格子，保持索引一致
+                unlink_item(grid, id);
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
+
+int spatial_grid_insert(SpatialGrid *grid, int id, const GridBox *box)
+{
+    if (id < 0 || box_is_empty(box)) return 0;
+    if (id < grid->box_capacity && grid->live[id]) return spatial_grid_move(grid, id, box);
+    if (!reserve_ids(grid, id)) return 0;
+
+    grid->boxes[id] = *box;
+    if (!link_item(grid, id)) return 0;
+    grid->live[id] = 1;
+    grid->count++;
+    return 1;
+}
+
+int spatial_grid_remove(SpatialGrid *grid, int id)
+{
+    if (!spatial_grid_contains(grid, id)) return 0;
+
+    unlink_item(grid, id);
+    grid->live[id] = 0;
+    grid->count--;
+    return 1;
+}
+
+int spatial_grid_move(SpatialGrid *grid, int id, const GridBox *box)
+{
+    if (!spatial_grid_contains(grid, id)) return spatial_grid_insert(grid, id, box);
+    if (box_is_empty(box)) return spatial_grid_remove(grid, id);
+
+    int a[4], b[4];
+    cell_span(grid, &grid->boxes[id], &a[0], &a[1], &a[2], &a[3]);
+    cell_span(grid, box, &b[0], &b[1], &b[2], &b[3]);
+
+    // 拖动中的小幅移动通常不跨格子
+    if (memcmp(a, b, sizeof(a)) == 0) {
+        grid->boxes[id] = *box;
+        return 1;
+    }
+
+    unlink_item(grid, id);
+    grid->boxes[id] = *box;
+    if (!link_item(grid, id)) {
+        grid->live[id] = 0;
+        grid->count--;
+        return 0;
+    }
+    return 1;
+}
+
+int spatial_grid_contains(const SpatialGrid *grid, int id)
+{
+    return id >= 0 && id < grid->box_capacity && grid->live[id];
+}
+
+SpatialGrid *spatial_grid_build(const GridBox *boxes, int count,
+                                float x0, float y0, float x1, float y1)
+{
+    SpatialGrid *grid = spatial_grid_create(x0, y0, x1, y1, count);
+    if (!grid) return NULL;
+    if (count <= 0) return grid;
+    if (!reserve_ids(grid, count - 1)) {
+        spatial_grid_free(grid);
+        return NULL;
+    }
+
+    // 第一遍统计每格条目数
+    int cx0, cy0, cx1, cy1;
+    for (int i = 0; i < count; i++) {
+        if (box_is_empty(&boxes[i])) continue;
+
+        cell_span(grid, &boxes[i], &cx0, &cy0, &cx1, &cy1);
+        if (span_is_big(cx0, cy0, cx1, cy1)) {
+            grid->big.capacity++;
+            continue;
+        }
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                grid->cells[cy * grid->cols + cx].capacity++;
+            }
+        }
+    }
+
+    int cells = grid->cols * grid->rows;
+    for (int c = 0; c <= cells; c++) {
+        GridCell *cell = c < cells ? &grid->cells[c] : &grid->big;
+        if (cell->capacity && !(cell->ids = malloc(cell->capacity * sizeof(int)))) {
+            cell->capacity = 0;
+            spatial_grid_free(grid);
+            return NULL;
+        }
+    }
+
+    // 第二遍按编号顺序填入，容量已经足够
+    for (int i = 0; i < count; i++) {
+        if (box_is_empty(&boxes[i])) continue;
+
+        grid->boxes[i] = boxes[i];
+        grid->live[i] = 1;
+        grid->count++;
+
+        cell_span(grid, &boxes[i], &cx0, &cy0, &cx1, &cy1);
+        if (span_is_big(cx0, cy0, cx1, cy1)) {
+            grid->big.ids[grid->big.count++] = i;
+            continue;
+        }
+        for (int cy = cy0; cy <= cy1; cy++) {
+            for (int cx = cx0; cx <= cx1; cx++) {
+                GridCell *cell = &grid->cells[cy * grid->cols + cx];
+                cell->ids[cell->count++] = i;
+            }
+        }
+    }
+    return grid;
+}
+
+static int box_overlaps(const GridBox *a, const GridBox *b)
+{
+    return a->x1 >= b->x0 && a->x0 <= b->x1 && a->y1 >= b->y0 && a->y0 <= b->y1;
+}
+
+static int out_push(int **out, int *capacity, int *count, int id)
+{
+    if (*count >= *capacity) {
+        int cap = *capacity ? *capacity * 2 : 256;
+        int *ids = realloc(*out, cap * sizeof(int));
+        if (!ids) return 0;
+        *out = ids;
+        *capacity = cap;
+    }
+    (*out)[(*count)++] = id;
+    return 1;
+}
+
+static int compare_ids(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+int spatial_grid_query(const SpatialGrid *grid, const GridBox *box, int **out, int *out_capacity)
+{
+    int count = 0;
+    int qx0, qy0, qx1, qy1;
+    cell_span(grid, box, &qx0, &qy0, &qx1, &qy1);
+
+    for (int cy = qy0; cy <= qy1; cy++) {
+        for (int cx = qx0; cx <= qx1; cx++) {
+            const GridCell *cell = &grid->cells[cy * grid->cols + cx];
+
+            for (int k = 0; k < cell->count; k++) {
+                int id = cell->ids[k];
+                const GridBox *b = &grid->boxes[id];
+                if (!box_overlaps(b, box)) continue;
+
+                // 条目跨多个格子时，只在它与查询范围重叠部分的左上角格子里报告一次
+                int ix0, iy0, ix1, iy1;
+                cell_span(grid, b, &ix0, &iy0, &ix1, &iy1);
+                if (cx != (ix0 > qx0 ? ix0 : qx0) || cy != (iy0 > qy0 ? iy0 : qy0)) continue;
+
+                if (!out_push(out, out_capacity, &count, id)) return -1;
+            }
+        }
+    }
+
+    for (int k = 0; k < grid->big.count; k++) {
+        int id = grid->big.ids[k];
+        if (box_overlaps(&grid->boxes[id], box) && !out_push(out, out_capacity, &count, id)) return -1;
+    }
+
+    qsort(*out, count, sizeof(int), compare_ids);
+    return count;
+}
+
+int spatial_grid_query_point(const SpatialGrid *grid, float x, float y, int **out, int *out_capacity)
+{
+    GridBox box = {x, y, x, y};
+    return spatial_grid_query(grid, &box, out, out_capacity);
+}
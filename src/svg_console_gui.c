@@ -5,6 +5,7 @@
 #include <ctype.h>
 #include <windows.h>
 #include <conio.h>
+#include "../include/svg_writer.h"
 
 #define MAX_SHAPES 100
 #define CANVAS_WIDTH 60
@@ -431,43 +432,57 @@ void add_line(ConsoleGUI* gui, double x1, double y1, double x2, double y2, const
 
 // 保存SVG文件
 void save_svg(ConsoleGUI* gui, const char* filename) {
-    FILE* file = fopen(filename, "w");
-    if (!file) {
+    SvgWriter w;
+    if (!svg_writer_open(&w, filename)) {
         gotoxy(5, 48);
         set_color(COLOR_RED);
         printf("无法保存文件: %s", filename);
         return;
     }
 
-    fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-    fprintf(file, "<svg width=\"180\" height=\"25\" xmlns=\"http://www.w3.org/2000/svg\">\n");
+    svg_writer_str(&w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+    svg_writer_str(&w, "<svg width=\"180\" height=\"25\" xmlns=\"http://www.w3.org/2000/svg\">\n");
 
+    // 字符画布的横坐标按 3 倍换算回 SVG
     for (int i = 0; i < gui->shape_count; i++) {
         SvgShape* shape = &gui->shapes[i];
 
         switch (shape->type) {
             case SVG_SHAPE_CIRCLE:
-                fprintf(file, "  <circle cx=\"%.1f\" cy=\"%.1f\" r=\"%.1f\" fill=\"%s\"/>\n",
-                        shape->data.circle.cx * 3, shape->data.circle.cy, shape->data.circle.r * 3,
-                        shape->data.circle.color_str);
+                svg_writer_str(&w, "  <circle");
+                svg_writer_attr(&w, "cx", shape->data.circle.cx * 3);
+                svg_writer_attr(&w, "cy", shape->data.circle.cy);
+                svg_writer_attr(&w, "r", shape->data.circle.r * 3);
+                svg_writer_attr_str(&w, "fill", shape->data.circle.color_str);
                 break;
             case SVG_SHAPE_RECT:
-                fprintf(file, "  <rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\" height=\"%.1f\" fill=\"%s\"/>\n",
-                        shape->data.rect.x * 3, shape->data.rect.y,
-                        shape->data.rect.width * 3, shape->data.rect.height,
-                        shape->data.rect.color_str);
+                svg_writer_str(&w, "  <rect");
+                svg_writer_attr(&w, "x", shape->data.rect.x * 3);
+                svg_writer_attr(&w, "y", shape->data.rect.y);
+                svg_writer_attr(&w, "width", shape->data.rect.width * 3);
+                svg_writer_attr(&w, "height", shape->data.rect.height);
+                svg_writer_attr_str(&w, "fill", shape->data.rect.color_str);
                 break;
             case SVG_SHAPE_LINE:
-                fprintf(file, "  <line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"%s\" stroke-width=\"2\"/>\n",
-                        shape->data.line.x1 * 3, shape->data.line.y1,
-                        shape->data.line.x2 * 3, shape->data.line.y2,
-                        shape->data.line.color_str);
+                svg_writer_str(&w, "  <line");
+                svg_writer_attr(&w, "x1", shape->data.line.x1 * 3);
+                svg_writer_attr(&w, "y1", shape->data.line.y1);
+                svg_writer_attr(&w, "x2", shape->data.line.x2 * 3);
+                svg_writer_attr(&w, "y2", shape->data.line.y2);
+                svg_writer_attr_str(&w, "stroke", shape->data.line.color_str);
+                svg_writer_str(&w, " stroke-width=\"2\"");
                 break;
         }
+        svg_writer_str(&w, "/>\n");
     }
 
-    fprintf(file, "</svg>\n");
-    fclose(file);
+    svg_writer_str(&w, "</svg>\n");
+    if (!svg_writer_close(&w)) {
+        gotoxy(5, 48);
+        set_color(COLOR_RED);
+        printf("写入文件失败: %s", filename);
+        return;
+    }
 
     gotoxy(5, 48);
     set_color(COLOR_GREEN);
@@ -0,0 +1,388 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../include/svg_display_list.h"
+
+#define DISPLAY_LIST_INITIAL_CAPACITY 64
+
+DisplayList *display_list_create(float width, float height)
+{
+    DisplayList *dl = malloc(sizeof(DisplayList));
+    if (!dl) return NULL;
+
+    dl->cmds = NULL;
+    dl->count = 0;
+    dl->capacity = 0;
+    dl->width = width;
+    dl->height = height;
+    return dl;
+}
+
+void display_list_free(DisplayList *dl)
+{
+    if (!dl) return;
+    free(dl->cmds);
+    free(dl);
+}
+
+void display_list_clear(DisplayList *dl)
+{
+    dl->count = 0;
+}
+
+int display_list_push(DisplayList *dl, const RenderPrimitive *cmd)
+{
+    if (dl->count >= dl->capacity) {
+        int capacity = dl->capacity ? dl->capacity * 2 : DISPLAY_LIST_INITIAL_CAPACITY;
+        RenderPrimitive *cmds = realloc(dl->cmds, capacity * sizeof(RenderPrimitive));
+        if (!cmds) return 0;
+        dl->cmds = cmds;
+        dl->capacity = capacity;
+    }
+
+    dl->cmds[dl->count++] = *cmd;
+    return 1;
+}
+
+static int push_shape(DisplayList *dl, PrimitiveKind kind, float a, float b, float c, float d,
+                      RGBColor color)
+{
+    RenderPrimitive cmd;
+    cmd.kind = kind;
+    cmd.p[0] = a;
+    cmd.p[1] = b;
+    cmd.p[2] = c;
+    cmd.p[3] = d;
+    cmd.color = color;
+    primitive_compute_bounds(&cmd);
+    return display_list_push(dl, &cmd);
+}
+
+int display_list_add_rect(DisplayList *dl, float x, float y, float w, float h, RGBColor color)
+{
+    return push_shape(dl, PRIM_RECT, x, y, w, h, color);
+}
+
+int display_list_add_circle(DisplayList *dl, float cx, float cy, float r, RGBColor color)
+{
+    return push_shape(dl, PRIM_CIRCLE, cx, cy, r, 0, color);
+}
+
+int display_list_add_line(DisplayList *dl, float x1, float y1, float x2, float y2, RGBColor color)
+{
+    return push_shape(dl, PRIM_LINE, x1, y1, x2, y2, color);
+}
+
+//-------- 视图 --------//
+
+DisplayListView display_list_view_identity(void)
+{
+    DisplayListView view = {1.0f, 1.0f, 0.0f, 0.0f};
+    return view;
+}
+
+DisplayListView display_list_view_fit(const DisplayList *dl, int out_w, int out_h)
+{
+    DisplayListView view = display_list_view_identity();
+    if (dl->width > 0) view.scale_x = out_w / dl->width;
+    if (dl->height > 0) view.scale_y = out_h / dl->height;
+    return view;
+}
+
+DisplayListView display_list_view_region(const DisplayListRect *region, int out_w, int out_h)
+{
+    DisplayListView view = display_list_view_identity();
+    if (region->w > 0) view.scale_x = out_w / region->w;
+    if (region->h > 0) view.scale_y = out_h / region->h;
+    view.offset_x = -region->x * view.scale_x;
+    view.offset_y = -region->y * view.scale_y;
+    return view;
+}
+
+int display_list_view_is_identity(const DisplayListView *view)
+{
+    return !view || (view->scale_x == 1.0f && view->scale_y == 1.0f &&
+                     view->offset_x == 0.0f && view->offset_y == 0.0f);
+}
+
+void display_list_transform_cmd(const RenderPrimitive *cmd, const DisplayListView *view,
+                                RenderPrimitive *out)
+{
+    *out = *cmd;
+    if (display_list_view_is_identity(view)) return;
+
+    float sx = view->scale_x, sy = view->scale_y;
+    switch (cmd->kind) {
+        case PRIM_RECT:
+            out->p[0] = cmd->p[0] * sx + view->offset_x;
+            out->p[1] = cmd->p[1] * sy + view->offset_y;
+            out->p[2] = cmd->p[2] * sx;
+            out->p[3] = cmd->p[3] * sy;
+            break;
+        case PRIM_CIRCLE:
+            out->p[0] = cmd->p[0] * sx + view->offset_x;
+            out->p[1] = cmd->p[1] * sy + view->offset_y;
+            out->p[2] = cmd->p[2] * (sx + sy) / 2.0f; // 非等比缩放时取平均
+            break;
+        case PRIM_LINE:
+            out->p[0] = cmd->p[0] * sx + view->offset_x;
+            out->p[1] = cmd->p[1] * sy + view->offset_y;
+            out->p[2] = cmd->p[2] * sx + view->offset_x;
+            out->p[3] = cmd->p[3] * sy + view->offset_y;
+            break;
+        default:
+            break;
+    }
+    primitive_compute_bounds(out);
+}
+
+//-------- 剔除 --------//
+
+// 命令的文档坐标包围盒批量建网格，first 之前的和空命令不登记
+SpatialGrid *display_list_build_index(const DisplayList *dl, int first, const DisplayListRect *area)
+{
+    GridBox *boxes = malloc((dl->count > 0 ? dl->count : 1) * sizeof(GridBox));
+    if (!boxes) return NULL;
+
+    for (int i = 0; i < dl->count; i++) {
+        float ext[4];
+        if (i < first || !display_list_cmd_extent(&dl->cmds[i], 1.0f, 1.0f, ext)) {
+            boxes[i].x0 = 1;
+            boxes[i].x1 = 0;   // 空盒，不登记
+            boxes[i].y0 = boxes[i].y1 = 0;
+            continue;
+        }
+        boxes[i].x0 = ext[0];
+        boxes[i].y0 = ext[1];
+        boxes[i].x1 = ext[2];
+        boxes[i].y1 = ext[3];
+    }
+
+    SpatialGrid *grid = spatial_grid_build(boxes, dl->count, area->x, area->y,
+                                           area->x + area->w, area->y + area->h);
+    free(boxes);
+    return grid;
+}
+
+// 输出像素反算回文档坐标。光栅化对坐标向下取整，最多向左上多出一个像素，
+// 窗口各边再放宽一个输出像素
+void display_list_cull_init(DisplayListCull *cull, const DisplayListView *view, int out_w, int out_h)
+{
+    DisplayListView id = display_list_view_identity();
+    if (!view) view = &id;
+
+    cull->x0 = (-1.0f - view->offset_x) / view->scale_x;
+    cull->y0 = (-1.0f - view->offset_y) / view->scale_y;
+    cull->x1 = (out_w + 1.0f - view->offset_x) / view->scale_x;
+    cull->y1 = (out_h + 1.0f - view->offset_y) / view->scale_y;
+
+    // 圆半径按两轴平均缩放，见 display_list_transform_cmd
+    float avg = (view->scale_x + view->scale_y) / 2.0f;
+    cull->rx = avg / view->scale_x;
+    cull->ry = avg / view->scale_y;
+}
+
+int display_list_cmd_extent(const RenderPrimitive *cmd, float rx, float ry, float ext[4])
+{
+    switch (cmd->kind) {
+        case PRIM_RECT:
+            ext[0] = cmd->p[0];
+            ext[1] = cmd->p[1];
+            ext[2] = cmd->p[0] + cmd->p[2];
+            ext[3] = cmd->p[1] + cmd->p[3];
+            return 1;
+        case PRIM_CIRCLE:
+            ext[0] = cmd->p[0] - cmd->p[2] * rx;
+            ext[1] = cmd->p[1] - cmd->p[2] * ry;
+            ext[2] = cmd->p[0] + cmd->p[2] * rx;
+            ext[3] = cmd->p[1] + cmd->p[2] * ry;
+            return 1;
+        case PRIM_LINE:
+            ext[0] = fminf(cmd->p[0], cmd->p[2]);
+            ext[1] = fminf(cmd->p[1], cmd->p[3]);
+            ext[2] = fmaxf(cmd->p[0], cmd->p[2]);
+            ext[3] = fmaxf(cmd->p[1], cmd->p[3]);
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+int display_list_cmd_visible(const RenderPrimitive *cmd, const DisplayListCull *cull)
+{
+    float ext[4];
+    if (!display_list_cmd_extent(cmd, cull->rx, cull->ry, ext)) return 0;
+
+    return ext[2] >= cull->x0 && ext[0] <= cull->x1 && ext[3] >= cull->y0 && ext[1] <= cull->y1;
+}
+
+//-------- 回放 --------//
+
+// 最后一个在输出中铺满画布的矩形，它之前的命令都不可见
+static int find_background_cmd(const DisplayList *dl, const DisplayListView *view, const Image *img)
+{
+    if (display_list_view_is_identity(view)) {
+        return find_background_primitive(dl->cmds, dl->count, img->width, img->height);
+    }
+
+    DisplayListCull cull;
+    display_list_cull_init(&cull, view, img->width, img->height);
+
+    for (int i = dl->count - 1; i >= 0; i--) {
+        if (dl->cmds[i].kind != PRIM_RECT || !display_list_cmd_visible(&dl->cmds[i], &cull)) continue;
+
+        RenderPrimitive cmd;
+        display_list_transform_cmd(&dl->cmds[i], view, &cmd);
+        if (find_background_primitive(&cmd, 1, img->width, img->height) == 0) return i;
+    }
+    return -1;
+}
+
+void display_list_render(const DisplayList *dl, Image *img, const DisplayListView *view,
+                         const RenderBackground *bg)
+{
+    RenderBackground back = {{255, 255, 255}, 0};
+    if (bg) back = *bg;
+
+    int k = find_background_cmd(dl, view, img);
+    if (k >= 0) {
+        back.color = dl->cmds[k].color;
+        back.transparent = 0;
+    }
+
+    PixelRect full = {0, 0, img->width, img->height};
+    render_clear(img, &full, &back);
+
+    if (display_list_view_is_identity(view)) {
+        for (int i = k + 1; i < dl->count; i++) {
+            draw_primitive(img, &dl->cmds[i], NULL);
+        }
+        return;
+    }
+
+    DisplayListCull cull;
+    display_list_cull_init(&cull, view, img->width, img->height);
+
+    for (int i = k + 1; i < dl->count; i++) {
+        if (!display_list_cmd_visible(&dl->cmds[i], &cull)) continue;
+
+        RenderPrimitive cmd;
+        display_list_transform_cmd(&dl->cmds[i], view, &cmd);
+        draw_primitive(img, &cmd, NULL);
+    }
+}
+
+void display_list_render_ids(const DisplayList *dl, Image *img, const DisplayListView *view,
+                             const RenderBackground *bg, const int *ids, int count)
+{
+    RenderBackground back = {{255, 255, 255}, 0};
+    if (bg) back = *bg;
+
+    DisplayListCull cull;
+    display_list_cull_init(&cull, view, img->width, img->height);
+
+    // 从后往前找铺满输出的矩形
+    int k = -1;
+    for (int j = count - 1; j >= 0; j--) {
+        const RenderPrimitive *c = &dl->cmds[ids[j]];
+        if (c->kind != PRIM_RECT || !display_list_cmd_visible(c, &cull)) continue;
+
+        RenderPrimitive cmd;
+        display_list_transform_cmd(c, view, &cmd);
+        if (find_background_primitive(&cmd, 1, img->width, img->height) == 0) {
+            back.color = cmd.color;
+            back.transparent = 0;
+            k = j;
+            break;
+        }
+    }
+
+    PixelRect full = {0, 0, img->width, img->height};
+    render_clear(img, &full, &back);
+
+    for (int j = k + 1; j < count; j++) {
+        const RenderPrimitive *c = &dl->cmds[ids[j]];
+        if (!display_list_cmd_visible(c, &cull)) continue;
+
+        RenderPrimitive cmd;
+        display_list_transform_cmd(c, view, &cmd);
+        draw_primitive(img, &cmd, NULL);
+    }
+}
+
+//-------- 局部重绘与拾取 --------//
+
+static RGBColor pick_color(int id)
+{
+    unsigned int v = (unsigned int)id + 1;
+    RGBColor c = {(unsigned char)(v >> 16), (unsigned char)(v >> 8), (unsigned char)v};
+    return c;
+}
+
+static void draw_area_cmd(const DisplayList *dl, Image *img, const DisplayListView *view,
+                          const DisplayListCull *cull, const PixelRect *area, int id, int pick)
+{
+    const RenderPrimitive *c = &dl->cmds[id];
+    if ((pick && id > DISPLAY_LIST_PICK_MAX) || !display_list_cmd_visible(c, cull)) return;
+
+    RenderPrimitive cmd;
+    display_list_transform_cmd(c, view, &cmd);
+    if (pick) cmd.color = pick_color(id);
+    draw_primitive(img, &cmd, area);
+}
+
+// 清除 area 后按 z 序画命令，只写 area 内的像素
+static void render_area(const DisplayList *dl, Image *img, const DisplayListView *view,
+                        const PixelRect *area, const RenderBackground *bg,
+                        const int *ids, int count, int pick)
+{
+    PixelRect full = {0, 0, img->width, img->height};
+    PixelRect r = area ? *area : full;
+    if (r.x0 < 0) r.x0 = 0;
+    if (r.y0 < 0) r.y0 = 0;
+    if (r.x1 > img->width) r.x1 = img->width;
+    if (r.y1 > img->height) r.y1 = img->height;
+    if (r.x0 >= r.x1 || r.y0 >= r.y1) return;
+
+    render_clear(img, &r, bg);
+
+    DisplayListCull cull;
+    display_list_cull_init(&cull, view, img->width, img->height);
+
+    int n = ids ? count : dl->count;
+    for (int j = 0; j < n; j++) {
+        draw_area_cmd(dl, img, view, &cull, &r, ids ? ids[j] : j, pick);
+    }
+}
+
+void display_list_render_area(const DisplayList *dl, Image *img, const DisplayListView *view,
+                              const PixelRect *area, const RenderBackground *bg,
+                              const int *ids, int count)
+{
+    RenderBackground back = {{255, 255, 255}, 0};
+    if (bg) back = *bg;
+    render_area(dl, img, view, area, &back, ids, count, 0);
+}
+
+void display_list_render_pick(const DisplayList *dl, Image *pick, const DisplayListView *view,
+                              const PixelRect *area, const int *ids, int count)
+{
+    RenderBackground none = {{0, 0, 0}, 0};
+    render_area(dl, pick, view, area, &none, ids, count, 1);
+}
+
+int display_list_pick(const Image *pick, int x, int y)
+{
+    if (x < 0 || y < 0 || x >= pick->width || y >= pick->height) return -1;
+
+    RGBColor c = pick->pixels[(size_t)y * pick->width + x];
+    return (int)(((unsigned int)c.r << 16) | ((unsigned int)c.g << 8) | c.b) - 1;
+}
+
+void display_list_render_region(const DisplayList *dl, Image *img, const DisplayListRect *region,
+                                const RenderBackground *bg)
+{
+    DisplayListView view = display_list_view_region(region, img->width, img->height);
+    display_list_render(dl, img, &view, bg);
+}
@@ -0,0 +1,436 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/svg_gui_types.h"
+
+#define DOC_INITIAL_CAPACITY 64
+
+/* ---------- 写时复制的槽位块 ---------- */
+
+static void chunk_release(SvgShapeChunk* chunk) {
+    if (chunk && atomic_fetch_sub(&chunk->refs, 1) == 1) free(chunk);
+}
+
+static SvgChunkTable* table_create(int capacity) {
+    SvgChunkTable* table = (SvgChunkTable*)malloc(sizeof(SvgChunkTable));
+    if (!table) return NULL;
+    table->chunks = (SvgShapeChunk**)malloc(capacity * sizeof(SvgShapeChunk*));
+    if (!table->chunks) {
+        free(table);
+        return NULL;
+    }
+    atomic_init(&table->refs, 1);
+    table->count = 0;
+    table->capacity = capacity;
+    return table;
+}
+
+static void table_release(SvgChunkTable* table) {
+    if (!table || atomic_fetch_sub(&table->refs, 1) != 1) return;
+    for (int i = 0; i < table->count; i++) {
+        chunk_release(table->chunks[i]);
+    }
+    free(table->chunks);
+    free(table);
+}
+
+// 保证块指针表归 doc 独占且至少能放 chunks 块：共享时复制指针表（块本身仍共享）。
+// 快照之后的第一次修改因此是 O(块数) = O(槽位数/256)，要逐块增加引用计数，
+// 100 万个图形约 4000 个指针；之后的修改不再复制指针表
+static int own_table(SvgDocument* doc, int chunks) {
+    SvgChunkTable* table = doc->table;
+    if (table && atomic_load(&table->refs) == 1) {
+        if (chunks <= table->capacity) return 1;
+        int capacity = table->capacity * 2;
+        while (capacity < chunks) capacity *= 2;
+        SvgShapeChunk** grown = (SvgShapeChunk**)realloc(table->chunks, capacity * sizeof(SvgShapeChunk*));
+        if (!grown) return 0;
+        table->chunks = grown;
+        table->capacity = capacity;
+        return 1;
+    }
+
+    int capacity = table && table->capacity > 0 ? table->capacity : 4;
+    while (capacity < chunks) capacity *= 2;
+    SvgChunkTable* copy = table_create(capacity);
+    if (!copy) return 0;
+    if (table) {
+        for (int i = 0; i < table->count; i++) {
+            copy->chunks[i] = table->chunks[i];
+            atomic_fetch_add(&copy->chunks[i]->refs, 1);
+        }
+        copy->count = table->count;
+        table_release(table);
+    }
+    doc->table = copy;
+    return 1;
+}
+
+// 保证第 index 块归 doc 独占：与快照共享时复制这一块
+static SvgShapeChunk* own_chunk(SvgDocument* doc, int index) {
+    if (!own_table(doc, index + 1)) return NULL;
+
+    SvgChunkTable* table = doc->table;
+    SvgShapeChunk* chunk = table->chunks[index];
+    if (atomic_load(&chunk->refs) == 1) return chunk;
+
+    SvgShapeChunk* copy = (SvgShapeChunk*)malloc(sizeof(SvgShapeChunk));
+    if (!copy) return NULL;
+    memcpy(copy->shapes, chunk->shapes, sizeof(copy->shapes));
+    atomic_init(&copy->refs, 1);
+    table->chunks[index] = copy;
+    chunk_release(chunk);
+    return copy;
+}
+
+/* ---------- 文档 ---------- */
+
+SvgDocument* create_svg_document(double width, double height) {
+    SvgDocument* doc = (SvgDocument*)calloc(1, sizeof(SvgDocument));
+    if (!doc) return NULL;
+
+    doc->width = width;
+    doc->height = height;
+    doc->next_id = 1;
+    return doc;
+}
+
+void free_svg_document(SvgDocument* doc) {
+    if (!doc) return;
+    table_release(doc->table);
+    free(doc->slots);
+    free(doc);
+}
+
+SvgDocument* svg_document_snapshot(const SvgDocument* doc) {
+    SvgDocument* snap = (SvgDocument*)malloc(sizeof(SvgDocument));
+    if (!snap) return NULL;
+
+    *snap = *doc;
+    snap->slots = NULL;
+    snap->slot_capacity = 0;
+    if (doc->table) atomic_fetch_add(&doc->table->refs, 1);
+    return snap;
+}
+
+const SvgShape* svg_document_shape(const SvgDocument* doc, int slot) {
+    return &doc->table->chunks[slot >> SVG_CHUNK_BITS]->shapes[slot & (SVG_CHUNK_SIZE - 1)];
+}
+
+SvgShape* svg_document_edit(SvgDocument* doc, int slot) {
+    SvgShapeChunk* chunk = own_chunk(doc, slot >> SVG_CHUNK_BITS);
+    if (!chunk) return NULL;
+    doc->version++;
+    return &chunk->shapes[slot & (SVG_CHUNK_SIZE - 1)];
+}
+
+SvgShape* svg_document_edit_chunk(SvgDocument* doc, int index) {
+    SvgShapeChunk* chunk = own_chunk(doc, index);
+    if (!chunk) return NULL;
+    doc->version++;
+    return chunk->shapes;
+}
+
+void svg_document_clear(SvgDocument* doc) {
+    table_release(doc->table);
+    doc->table = NULL;
+    doc->shape_count = 0;
+    doc->live_count = 0;
+    doc->next_id = 1;
+    doc->version++;
+    if (doc->slots) {
+        memset(doc->slots, 0, doc->slot_capacity * sizeof(SvgSlotEntry));
+    }
+}
+
+static unsigned int hash_id(int id, int capacity) {
+    return ((unsigned int)id * 2654435761u) & (unsigned int)(capacity - 1);
+}
+
+// 线性探测：返回 id 所在的表项，或它应当放入的空位
+static SvgSlotEntry* probe(const SvgDocument* doc, int id) {
+    unsigned int mask = (unsigned int)doc->slot_capacity - 1;
+    unsigned int i = hash_id(id, doc->slot_capacity);
+    while (doc->slots[i].id != 0 && doc->slots[i].id != id) {
+        i = (i + 1) & mask;
+    }
+    return &doc->slots[i];
+}
+
+// 装载率保持在一半以下
+static int reserve_slots(SvgDocument* doc, int count) {
+    if (count * 2 <= doc->slot_capacity) return 1;
+
+    int capacity = doc->slot_capacity ? doc->slot_capacity : DOC_INITIAL_CAPACITY;
+    while (count * 2 > capacity) capacity *= 2;
+    SvgSlotEntry* slots = (SvgSlotEntry*)calloc(capacity, sizeof(SvgSlotEntry));
+    if (!slots) return 0;
+
+    SvgSlotEntry* old = doc->slots;
+    int old_capacity = doc->slot_capacity;
+    doc->slots = slots;
+    doc->slot_capacity = capacity;
+    for (int i = 0; i < old_capacity; i++) {
+        if (old[i].id != 0) *probe(doc, old[i].id) = old[i];
+    }
+    free(old);
+    return 1;
+}
+
+// 删除表项后把后面同一探测链上的项往前挪，表里不需要删除标记
+static void erase_slot(SvgDocument* doc, SvgSlotEntry* entry) {
+    unsigned int mask = (unsigned int)doc->slot_capacity - 1;
+    unsigned int hole = (unsigned int)(entry - doc->slots);
+    unsigned int i = hole;
+
+    doc->slots[hole].id = 0;
+    for (;;) {
+        i = (i + 1) & mask;
+        if (doc->slots[i].id == 0) return;
+        unsigned int home = hash_id(doc->slots[i].id, doc->slot_capacity);
+        // home 不在 (hole, i] 之间时，这一项可以挪进空位
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            doc->slots[hole] = doc->slots[i];
+            doc->slots[i].id = 0;
+            hole = i;
+        }
+    }
+}
+
+// 在不超过 shape_count 的槽位放入图形并登记它的 ID
+static int place_shape(SvgDocument* doc, int slot, const SvgShape* shape) {
+    int index = slot >> SVG_CHUNK_BITS;
+
+    if (!reserve_slots(doc, doc->live_count + 1) || !own_table(doc, index + 1)) return -1;
+    if (index == doc->table->count) {
+        SvgShapeChunk* chunk = (SvgShapeChunk*)malloc(sizeof(SvgShapeChunk));
+        if (!chunk) return -1;
+        atomic_init(&chunk->refs, 1);
+        doc->table->chunks[doc->table->count++] = chunk;
+    }
+
+    SvgShape* placed = svg_document_edit(doc, slot);
+    if (!placed) return -1;
+    *placed = *shape;
+    if (slot == doc->shape_count) doc->shape_count++;
+    if (shape->id >= doc->next_id) doc->next_id = shape->id + 1;
+    doc->live_count++;
+
+    SvgSlotEntry* entry = probe(doc, shape->id);
+    entry->id = shape->id;
+    entry->slot = slot;
+    return slot;
+}
+
+int svg_document_add(SvgDocument* doc, const SvgShape* shape) {
+    SvgShape added = *shape;
+    added.id = doc->next_id;
+    return place_shape(doc, doc->shape_count, &added);
+}
+
+int svg_document_find(const SvgDocument* doc, int id) {
+    if (id <= 0 || doc->slot_capacity == 0) return -1;
+    const SvgSlotEntry* entry = probe(doc, id);
+    return entry->id == id ? entry->slot : -1;
+}
+
+SvgShape* svg_document_get(SvgDocument* doc, int id) {
+    int slot = svg_document_find(doc, id);
+    return slot < 0 ? NULL : svg_document_edit(doc, slot);
+}
+
+int svg_document_remove(SvgDocument* doc, int id) {
+    if (id <= 0 || doc->slot_capacity == 0) return -1;
+    SvgSlotEntry* entry = probe(doc, id);
+    if (entry->id != id) return -1;
+
+    int slot = entry->slot;
+    SvgShape* shape = svg_document_edit(doc, slot);
+    if (!shape) return -1;
+    erase_slot(doc, entry);
+    shape->id = 0;
+    doc->live_count--;
+    return slot;
+}
+
+int svg_document_restore(SvgDocument* doc, int slot, const SvgShape* shape) {
+    if (slot < 0 || slot > doc->shape_count || shape->id <= 0) return -1;
+    if (slot < doc->shape_count && svg_shape_alive(svg_document_shape(doc, slot))) return -1;
+    if (svg_document_find(doc, shape->id) >= 0) return -1;
+    return place_shape(doc, slot, shape);
+}
+
+// 共享快照的块指针表，ID 索引按快照中的有效图形重建
+int svg_document_revert(SvgDocument* doc, const SvgDocument* snapshot) {
+    if (!reserve_slots(doc, snapshot->live_count)) return 0;
+
+    if (snapshot->table) atomic_fetch_add(&snapshot->table->refs, 1);
+    table_release(doc->table);
+    doc->table = snapshot->table;
+    doc->width = snapshot->width;
+    doc->height = snapshot->height;
+    doc->shape_count = snapshot->shape_count;
+    doc->live_count = snapshot->live_count;
+    doc->next_id = snapshot->next_id;
+    doc->version++;
+
+    if (doc->slots) {
+        memset(doc->slots, 0, doc->slot_capacity * sizeof(SvgSlotEntry));
+    }
+    for (int i = 0; i < doc->shape_count; i++) {
+        const SvgShape* shape = svg_document_shape(doc, i);
+        if (!svg_shape_alive(shape)) continue;
+        SvgSlotEntry* entry = probe(doc, shape->id);
+        entry->id = shape->id;
+        entry->slot = i;
+    }
+    return 1;
+}
+
+// 压缩时整体写入新块，旧块留给仍在使用它们的快照
+int svg_document_compact(SvgDocument* doc, int force) {
+    int dead = doc->shape_count - doc->live_count;
+    if (dead == 0 || (!force && dead * 2 <= doc->shape_count)) return 0;
+
+    int chunks = (doc->live_count + SVG_CHUNK_SIZE - 1) >> SVG_CHUNK_BITS;
+    SvgChunkTable* table = table_create(chunks > 0 ? chunks : 1);
+    if (!table) return 0;
+    for (; table->count < chunks; table->count++) {
+        SvgShapeChunk* chunk = (SvgShapeChunk*)malloc(sizeof(SvgShapeChunk));
+        if (!chunk) {
+            table_release(table);
+            return 0;
+        }
+        atomic_init(&chunk->refs, 1);
+        table->chunks[table->count] = chunk;
+    }
+
+    int n = 0;
+    for (int i = 0; i < doc->shape_count; i++) {
+        const SvgShape* shape = svg_document_shape(doc, i);
+        if (!svg_shape_alive(shape)) continue;
+        table->chunks[n >> SVG_CHUNK_BITS]->shapes[n & (SVG_CHUNK_SIZE - 1)] = *shape;
+        probe(doc, shape->id)->slot = n;
+        n++;
+    }
+    table_release(doc->table);
+    doc->table = table;
+    doc->shape_count = n;
+    doc->version++;
+    return 1;
+}
+
+void svg_shape_translate(SvgShape* shape, double dx, double dy) {
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE:
+            shape->data.circle.cx += dx;
+            shape->data.circle.cy += dy;
+            break;
+        case SVG_SHAPE_RECT:
+            shape->data.rect.x += dx;
+            shape->data.rect.y += dy;
+            break;
+        case SVG_SHAPE_LINE:
+            shape->data.line.x1 += dx;
+            shape->data.line.y1 += dy;
+            shape->data.line.x2 += dx;
+            shape->data.line.y2 += dy;
+            break;
+    }
+}
+
+void svg_shape_bounds_d(const SvgShape* shape, double box[4]) {
+    if (!svg_shape_alive(shape)) {
+        box[0] = box[1] = 0;
+        box[2] = box[3] = -1;
+        return;
+    }
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE:
+            box[0] = shape->data.circle.cx - shape->data.circle.r;
+            box[1] = shape->data.circle.cy - shape->data.circle.r;
+            box[2] = shape->data.circle.cx + shape->data.circle.r;
+            box[3] = shape->data.circle.cy + shape->data.circle.r;
+            break;
+        case SVG_SHAPE_RECT:
+            box[0] = shape->data.rect.x;
+            box[1] = shape->data.rect.y;
+            box[2] = shape->data.rect.x + shape->data.rect.width;
+            box[3] = shape->data.rect.y + shape->data.rect.height;
+            break;
+        case SVG_SHAPE_LINE:
+            box[0] = fmin(shape->data.line.x1, shape->data.line.x2);
+            box[1] = fmin(shape->data.line.y1, shape->data.line.y2);
+            box[2] = fmax(shape->data.line.x1, shape->data.line.x2);
+            box[3] = fmax(shape->data.line.y1, shape->data.line.y2);
+            break;
+    }
+}
+
+void svg_shape_bounds(const SvgShape* shape, GridBox* box) {
+    double b[4];
+    svg_shape_bounds_d(shape, b);
+    box->x0 = (float)b[0];
+    box->y0 = (float)b[1];
+    box->x1 = (float)b[2];
+    box->y1 = (float)b[3];
+}
+
+SpatialGrid* build_shape_index(SvgDocument* doc) {
+    GridBox* boxes = (GridBox*)malloc((doc->shape_count > 0 ? doc->shape_count : 1) * sizeof(GridBox));
+    if (!boxes) return NULL;
+
+    for (int i = 0; i < doc->shape_count; i++) {
+        svg_shape_bounds(svg_document_shape(doc, i), &boxes[i]);
+    }
+    SpatialGrid* grid = spatial_grid_build(boxes, doc->shape_count, 0, 0, doc->width, doc->height);
+    free(boxes);
+    return grid;
+}
+
+static unsigned long long fnv_add(unsigned long long h, const void* data, size_t size) {
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++) {
+        h = (h ^ p[i]) * 1099511628211ULL;
+    }
+    return h;
+}
+
+// 逐字段计算，结构体里的填充字节和颜色串结尾之后的内容不参与
+unsigned long long svg_document_checksum(const SvgDocument* doc) {
+    unsigned long long h = 14695981039346656037ULL;
+    for (int i = 0; i < doc->shape_count; i++) {
+        const SvgShape* shape = svg_document_shape(doc, i);
+        if (!svg_shape_alive(shape)) continue;
+
+        double v[4] = { 0, 0, 0, 0 };
+        const char* color = shape->data.line.stroke;
+        switch (shape->type) {
+            case SVG_SHAPE_CIRCLE:
+                v[0] = shape->data.circle.cx;
+                v[1] = shape->data.circle.cy;
+                v[2] = shape->data.circle.r;
+                color = shape->data.circle.fill;
+                break;
+            case SVG_SHAPE_RECT:
+                v[0] = shape->data.rect.x;
+                v[1] = shape->data.rect.y;
+                v[2] = shape->data.rect.width;
+                v[3] = shape->data.rect.height;
+                color = shape->data.rect.fill;
+                break;
+            case SVG_SHAPE_LINE:
+                v[0] = shape->data.line.x1;
+                v[1] = shape->data.line.y1;
+                v[2] = shape->data.line.x2;
+                v[3] = shape->data.line.y2;
+                break;
+        }
+        int type = shape->type;
+        h = fnv_add(h, &shape->id, sizeof(shape->id));
+        h = fnv_add(h, &type, sizeof(type));
+        h = fnv_add(h, v, sizeof(v));
+        h = fnv_add(h, color, strnlen(color, sizeof(shape->data.line.stroke)));
+    }
+    return h;
+}
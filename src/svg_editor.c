@@ -1,48 +1,89 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <ctype.h>
+#include <math.h>
+#include <time.h>
+#ifdef _WIN32
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#else
+#include <unistd.h>
+#endif
 
-#define MAX_SHAPES 100
-#define MAX_LINE_LENGTH 256
+#include "../include/spatial_grid.h"
+#include "../include/svg_gui_types.h"
+#include "../include/svg_journal.h"
+#include "../include/svg_selection.h"
+#include "../include/svg_writer.h"
 
-typedef enum {
-    SVG_SHAPE_CIRCLE,
-    SVG_SHAPE_RECT,
-    SVG_SHAPE_LINE
-} SvgShapeType;
+#define MAX_LINE_LENGTH 256
+// Command name plus at most this many arguments
+#define MAX_ARGS 6
+// Script errors beyond this many are counted but not printed
+#define MAX_REPORTED_ERRORS 20
+// Script input is read in blocks of this size
+#define SCRIPT_BLOCK (1 << 20)
 
+// The document store is shared with the SDL GUI: shapes keep their ID for
+// life, lookups by ID go through a hash map, and deletes leave tombstones
 typedef struct {
-    double cx, cy, r;
-    char fill[16];
-} SvgCircle;
+    SvgDocument* doc;
+    SvgSelection selection; // selected slots; edits apply to all of them
+    SpatialGrid* index;   // keyed by document slot
+    SvgJournal journal;   // undo/redo history, one record per command
 
-typedef struct {
-    double x, y, width, height;
-    char fill[16];
-} SvgRect;
+    // Script mode: confirmations are suppressed and errors carry the line number
+    const char* script;   // script name for messages, NULL when interactive
+    long line;            // current script line
+    long errors;          // failed commands so far
+    int quit;
+} Editor;
 
-typedef struct {
-    double x1, y1, x2, y2;
-    char stroke[16];
-} SvgLine;
+// Confirmation messages, shown only interactively. A function rather than a
+// macro so the arguments are evaluated in script mode too
+static void say(Editor* ed, const char* fmt, ...) {
+    va_list args;
 
-typedef struct {
-    SvgShapeType type;
-    union {
-        SvgCircle circle;
-        SvgRect rect;
-        SvgLine line;
-    } data;
-    int id;
-} SvgShape;
+    if (ed->script) return;
+    va_start(args, fmt);
+    vprintf(fmt, args);
+    va_end(args);
+}
 
-typedef struct {
-    double width, height;
-    SvgShape shapes[MAX_SHAPES];
-    int shape_count;
-    int selected_shape;
-} SvgDocument;
+// A command failed. In a script the line number is prefixed and only the
+// first few errors are printed, so one bad pattern cannot flood the output
+static void report_error(Editor* ed, const char* fmt, ...) {
+    va_list args;
+    FILE* out = ed->script ? stderr : stdout;
+
+    ed->errors++;
+    if (ed->script && ed->errors > MAX_REPORTED_ERRORS) return;
+    if (ed->script) fprintf(out, "%s:%ld: ", ed->script, ed->line);
+    fprintf(out, "Error: ");
+    va_start(args, fmt);
+    vfprintf(out, fmt, args);
+    va_end(args);
+}
+
+// Bulk-load the index from scratch (after load, or when slots are compacted)
+static void rebuild_index(Editor* ed) {
+    spatial_grid_free(ed->index);
+    ed->index = build_shape_index(ed->doc);
+}
+
+// Insert, move or drop (tombstone) a single shape in the index
+static void update_index(Editor* ed, int slot) {
+    GridBox box;
+    if (!ed->index) {
+        rebuild_index(ed);
+        return;
+    }
+    svg_shape_bounds(svg_document_shape(ed->doc, slot), &box);
+    spatial_grid_move(ed->index, slot, &box);
+}
 
 static void read_full_tag(FILE *fp, const char *first_line, char *out_tag)
 {
@@ -87,7 +128,7 @@ int parse_svg_file(const char* filename, SvgDocument* doc) {
     }
 
     char line[MAX_LINE_LENGTH];
-    doc->shape_count = 0;
+    svg_document_clear(doc);
     doc->width = 800; // default
     doc->height = 600; // default
 
@@ -110,11 +151,9 @@ int parse_svg_file(const char* filename, SvgDocument* doc) {
 
         // Parse circle
         else if (strstr(trimmed, "<circle")) {
-            if (doc->shape_count >= MAX_SHAPES) break;
-            
-            SvgShape* shape = &doc->shapes[doc->shape_count];
+            SvgShape parsed = {0};
+            SvgShape* shape = &parsed;
             shape->type = SVG_SHAPE_CIRCLE;
-            shape->id = doc->shape_count + 1;
             
             sscanf(trimmed, "<circle cx=\"%lf\" cy=\"%lf\" r=\"%lf\"", 
                    &shape->data.circle.cx, &shape->data.circle.cy, &shape->data.circle.r);
@@ -128,16 +167,14 @@ int parse_svg_file(const char* filename, SvgDocument* doc) {
                 strcpy(shape->data.circle.fill, "#000000");
             }
             
-            doc->shape_count++;
+            if (svg_document_add(doc, shape) < 0) break;
         }
 
         // Parse rectangle
         else if (strstr(trimmed, "<rect")) {
-            if (doc->shape_count >= MAX_SHAPES) break;
-            
-            SvgShape* shape = &doc->shapes[doc->shape_count];
+            SvgShape parsed = {0};
+            SvgShape* shape = &parsed;
             shape->type = SVG_SHAPE_RECT;
-            shape->id = doc->shape_count + 1;
             
             sscanf(trimmed, "<rect x=\"%lf\" y=\"%lf\" width=\"%lf\" height=\"%lf\"", 
                    &shape->data.rect.x, &shape->data.rect.y, 
@@ -152,16 +189,14 @@ int parse_svg_file(const char* filename, SvgDocument* doc) {
                 strcpy(shape->data.rect.fill, "#000000");
             }
             
-            doc->shape_count++;
+            if (svg_document_add(doc, shape) < 0) break;
         }
 
         // Parse line
         else if (strstr(trimmed, "<line")) {
-            if (doc->shape_count >= MAX_SHAPES) break;
-            
-            SvgShape* shape = &doc->shapes[doc->shape_count];
+            SvgShape parsed = {0};
+            SvgShape* shape = &parsed;
             shape->type = SVG_SHAPE_LINE;
-            shape->id = doc->shape_count + 1;
             
             sscanf(trimmed, "<line x1=\"%lf\" y1=\"%lf\" x2=\"%lf\" y2=\"%lf\"", 
                    &shape->data.line.x1, &shape->data.line.y1,
@@ -176,7 +211,7 @@ int parse_svg_file(const char* filename, SvgDocument* doc) {
                 strcpy(shape->data.line.stroke, "#000000");
             }
             
-            doc->shape_count++;
+            if (svg_document_add(doc, shape) < 0) break;
         }
     }
 
@@ -188,14 +223,15 @@ int parse_svg_file(const char* filename, SvgDocument* doc) {
 void display_summary(SvgDocument* doc) {
     printf("\n=== SVG Document Summary ===\n");
     printf("Canvas: %.1f x %.1f\n", doc->width, doc->height);
-    printf("Total shapes: %d\n\n", doc->shape_count);
+    printf("Total shapes: %d\n\n", doc->live_count);
 }
 
 // Display all shapes
 void display_shapes(SvgDocument* doc) {
     printf("=== Shapes ===\n");
     for (int i = 0; i < doc->shape_count; i++) {
-        SvgShape* shape = &doc->shapes[i];
+        const SvgShape* shape = svg_document_shape(doc, i);
+        if (!svg_shape_alive(shape)) continue;
         printf("[%d] ", shape->id);
         
         switch (shape->type) {
@@ -223,103 +259,204 @@ void display_shapes(SvgDocument* doc) {
     printf("\n");
 }
 
-// Add a new circle
-void add_circle(SvgDocument* doc, double cx, double cy, double r, const char* fill) {
-    if (doc->shape_count >= MAX_SHAPES) {
-        printf("Error: Maximum shapes reached!\n");
+// Append a shape on top and index it
+static void add_shape(Editor* ed, const SvgShape* shape, const char* name) {
+    int slot = svg_document_add(ed->doc, shape);
+    if (slot < 0) {
+        report_error(ed, "Out of memory!\n");
         return;
     }
-    
-    SvgShape* shape = &doc->shapes[doc->shape_count];
-    shape->type = SVG_SHAPE_CIRCLE;
-    shape->id = doc->shape_count + 1;
-    shape->data.circle.cx = cx;
-    shape->data.circle.cy = cy;
-    shape->data.circle.r = r;
-    gui_parse_color(fill, shape->data.circle.fill);
-    doc->shape_count++;
-    printf("Circle added with ID %d\n", shape->id);
+    update_index(ed, slot);
+    journal_insert(&ed->journal, svg_document_shape(ed->doc, slot), slot);
+    say(ed, "%s added with ID %d\n", name, svg_document_shape(ed->doc, slot)->id);
+}
+
+// Add a new circle
+void add_circle(Editor* ed, double cx, double cy, double r, const char* fill) {
+    SvgShape shape = {0};
+    shape.type = SVG_SHAPE_CIRCLE;
+    shape.data.circle.cx = cx;
+    shape.data.circle.cy = cy;
+    shape.data.circle.r = r;
+    gui_parse_color(fill, shape.data.circle.fill);
+    add_shape(ed, &shape, "Circle");
 }
 
 // Add a new rectangle
-void add_rect(SvgDocument* doc, double x, double y, double w, double h, const char* fill) {
-    if (doc->shape_count >= MAX_SHAPES) {
-        printf("Error: Maximum shapes reached!\n");
+void add_rect(Editor* ed, double x, double y, double w, double h, const char* fill) {
+    SvgShape shape = {0};
+    shape.type = SVG_SHAPE_RECT;
+    shape.data.rect.x = x;
+    shape.data.rect.y = y;
+    shape.data.rect.width = w;
+    shape.data.rect.height = h;
+    gui_parse_color(fill, shape.data.rect.fill);
+    add_shape(ed, &shape, "Rectangle");
+}
+
+// Select a single shape for editing
+void select_shape(Editor* ed, int id) {
+    int slot = svg_document_find(ed->doc, id);
+    if (slot < 0) {
+        report_error(ed, "Invalid shape ID\n");
         return;
     }
     
-    SvgShape* shape = &doc->shapes[doc->shape_count];
-    shape->type = SVG_SHAPE_RECT;
-    shape->id = doc->shape_count + 1;
-    
-    shape->data.rect.x = x;
-    shape->data.rect.y = y;
-    shape->data.rect.width = w;
-    shape->data.rect.height = h;
-    gui_parse_color(fill, shape->data.rect.fill);
-    
-    doc->shape_count++;
-    printf("Rectangle added with ID %d\n", shape->id);
+    selection_clear(&ed->selection);
+    selection_add(&ed->selection, slot);
+    say(ed, "Selected shape [%d]\n", id);
+}
+
+// Select every shape whose bounds touch a rectangle, replacing the selection
+void select_box(Editor* ed, double x, double y, double w, double h) {
+    GridBox box = { x, y, x + w, y + h };
+    int* hits = NULL;
+    int capacity = 0;
+    int count = ed->index ? spatial_grid_query(ed->index, &box, &hits, &capacity) : 0;
+
+    selection_clear(&ed->selection);
+    if (count > 0) selection_add_slots(&ed->selection, ed->doc, hits, count);
+    free(hits);
+    say(ed, "Selected %d shape(s)\n", ed->selection.count);
+}
+
+void select_all(Editor* ed) {
+    int selected = selection_select_all(&ed->selection, ed->doc);
+    say(ed, "Selected %d shape(s)\n", selected);
+}
+
+static int require_selection(Editor* ed) {
+    if (ed->selection.count > 0) return 1;
+    report_error(ed, "No shape selected. Use 'select <id>' first.\n");
+    return 0;
+}
+
+// Reindex every selected slot after a bulk edit
+static void update_selection(Editor* ed) {
+    for (int slot = selection_next(&ed->selection, 0); slot >= 0 && slot < ed->doc->shape_count;
+         slot = selection_next(&ed->selection, slot + 1)) {
+        update_index(ed, slot);
+    }
 }
 
-// Select a shape for editing
-void select_shape(SvgDocument* doc, int id) {
-    if (id < 1 || id > doc->shape_count) {
-        printf("Error: Invalid shape ID\n");
+// Move the selected shapes
+void move_shape(Editor* ed, double dx, double dy) {
+    if (!require_selection(ed)) return;
+
+    int moved = selection_move(ed->doc, &ed->selection, dx, dy, &ed->journal);
+    if (moved < 0) {
+        report_error(ed, "Out of memory!\n");
         return;
     }
+    update_selection(ed);
+    // Each move command is its own undo step
+    journal_seal(&ed->journal);
     
-    doc->selected_shape = id - 1;
-    printf("Selected shape [%d]\n", id);
+    say(ed, "Moved %d shape(s) by (%.1f, %.1f)\n", moved, dx, dy);
 }
 
-// Move selected shape
-void move_shape(SvgDocument* doc, double dx, double dy) {
-    if (doc->selected_shape == -1) {
-        printf("Error: No shape selected. Use 'select <id>' first.\n");
+// Delete the selected shapes. Other shapes keep their IDs and slots; the index
+// is only rebuilt when enough tombstones pile up to compact the store
+void delete_shape(Editor* ed) {
+    if (!require_selection(ed)) return;
+
+    int deleted = selection_delete(ed->doc, &ed->selection, &ed->journal);
+    if (deleted < 0) {
+        report_error(ed, "Out of memory!\n");
         return;
     }
-    
-    SvgShape* shape = &doc->shapes[doc->selected_shape];
-    
-    switch (shape->type) {
-        case SVG_SHAPE_CIRCLE:
-            shape->data.circle.cx += dx;
-            shape->data.circle.cy += dy;
-            break;
-        case SVG_SHAPE_RECT:
-            shape->data.rect.x += dx;
-            shape->data.rect.y += dy;
-            break;
-        case SVG_SHAPE_LINE:
-            shape->data.line.x1 += dx;
-            shape->data.line.y1 += dy;
-            shape->data.line.x2 += dx;
-            shape->data.line.y2 += dy;
-            break;
+    update_selection(ed);
+    selection_clear(&ed->selection);
+    say(ed, "Deleted %d shape(s)\n", deleted);
+    if (journal_compact(&ed->journal, ed->doc, 0)) rebuild_index(ed);
+}
+
+// Apply a scale or recolor to the whole selection as one undo step
+static int edit_selection(Editor* ed, ShapeEdit* edit) {
+    if (!require_selection(ed)) return -1;
+
+    double box[4];
+    selection_bounds_d(&ed->selection, ed->doc, box);
+    edit->cx = (box[0] + box[2]) / 2;
+    edit->cy = (box[1] + box[3]) / 2;
+    int edited = selection_edit(ed->doc, &ed->selection, edit, &ed->journal);
+    if (edited < 0) {
+        report_error(ed, "Out of memory!\n");
+        return -1;
     }
-    
-    printf("Moved shape [%d] by (%.1f, %.1f)\n", doc->selected_shape + 1, dx, dy);
+    update_selection(ed);
+    return edited;
 }
 
-// Delete selected shape
-void delete_shape(SvgDocument* doc) {
-    if (doc->selected_shape == -1) {
-        printf("Error: No shape selected.\n");
+// Change the fill (stroke for lines) of the selected shapes
+void recolor_shape(Editor* ed, const char* color) {
+    ShapeEdit edit = { SHAPE_EDIT_RECOLOR, 0, 0, 1, "" };
+    gui_parse_color(color, edit.color);
+    int edited = edit_selection(ed, &edit);
+    if (edited >= 0) say(ed, "%d shape(s) color set to %s\n", edited, edit.color);
+}
+
+// Scale the selected shapes about the center of their combined bounds
+void scale_shape(Editor* ed, double factor) {
+    if (factor <= 0) {
+        report_error(ed, "Scale factor must be positive\n");
         return;
     }
-    
-    int index = doc->selected_shape;
-    printf("Deleted shape [%d]\n", index + 1);
-    
-    // Shift all shapes after the deleted one
-    for (int i = index; i < doc->shape_count - 1; i++) {
-        doc->shapes[i] = doc->shapes[i + 1];
-        doc->shapes[i].id = i + 1;
+    ShapeEdit edit = { SHAPE_EDIT_SCALE, 0, 0, factor, "" };
+    int edited = edit_selection(ed, &edit);
+    if (edited >= 0) say(ed, "Scaled %d shape(s) by %g\n", edited, factor);
+}
+
+// Step back or forward through the journal and resync the index
+void undo_redo(Editor* ed, int redo) {
+    JournalResult result = redo ? journal_redo(&ed->journal, ed->doc)
+                                : journal_undo(&ed->journal, ed->doc);
+    if (result == JOURNAL_NOTHING) {
+        report_error(ed, "Nothing to %s\n", redo ? "redo" : "undo");
+        return;
     }
-    
-    doc->shape_count--;
-    doc->selected_shape = -1;
+
+    if (result == JOURNAL_ALL) {
+        // Slots were renumbered, so the selection no longer means anything
+        rebuild_index(ed);
+        selection_clear(&ed->selection);
+    } else {
+        for (int i = 0; i < ed->journal.touched_count; i++) {
+            int slot = ed->journal.touched[i];
+            update_index(ed, slot);
+            if (!svg_shape_alive(svg_document_shape(ed->doc, slot))) selection_remove(&ed->selection, slot);
+        }
+    }
+    say(ed, "%s (%d shapes)\n", redo ? "Redone" : "Undone", ed->doc->live_count);
+}
+
+// List shapes whose bounds contain a point, topmost first
+void pick_shapes(Editor* ed, double x, double y) {
+    int* hits = NULL;
+    int capacity = 0;
+    int count = ed->index ? spatial_grid_query_point(ed->index, x, y, &hits, &capacity) : 0;
+
+    if (count <= 0) {
+        printf("No shape at (%.1f, %.1f)\n", x, y);
+    }
+    for (int k = count - 1; k >= 0; k--) {
+        printf("[%d]\n", svg_document_shape(ed->doc, hits[k])->id);
+    }
+    free(hits);
+}
+
+// List shapes whose bounds intersect a rectangle, in document order
+void query_shapes(Editor* ed, double x, double y, double w, double h) {
+    GridBox box = { x, y, x + w, y + h };
+    int* hits = NULL;
+    int capacity = 0;
+    int count = ed->index ? spatial_grid_query(ed->index, &box, &hits, &capacity) : 0;
+
+    printf("%d shape(s) in (%.1f,%.1f) %.1fx%.1f\n", count > 0 ? count : 0, x, y, w, h);
+    for (int k = 0; k < count; k++) {
+        printf("[%d]\n", svg_document_shape(ed->doc, hits[k])->id);
+    }
+    free(hits);
 }
 
 // Show help
@@ -330,148 +467,392 @@ void show_help() {
     printf("list                 - Show all shapes\n");
     printf("summary              - Show document summary\n");
     printf("select <id>          - Select shape for editing\n");
-    printf("move <dx> <dy>       - Move selected shape\n");
-    printf("delete               - Delete selected shape\n");
+    printf("select_box <x> <y> <w> <h> - Select shapes touching a rectangle\n");
+    printf("select_all           - Select every shape\n");
+    printf("move <dx> <dy>       - Move selected shapes\n");
+    printf("scale <factor>       - Scale selected shapes about their center\n");
+    printf("delete               - Delete selected shapes\n");
+    printf("color <color>        - Recolor selected shapes\n");
+    printf("undo / redo          - Step back / forward through edits\n");
+    printf("pick <x> <y>         - List shapes under a point\n");
+    printf("query <x> <y> <w> <h> - List shapes touching a rectangle\n");
     printf("add_circle <cx> <cy> <r> [color] - Add circle\n");
     printf("add_rect <x> <y> <w> <h> [color] - Add rectangle\n");
     printf("help                 - Show this help\n");
     printf("quit                 - Exit program\n\n");
 }
 
-// Save svg
+// Save svg; numbers are written in their shortest form that reads back exactly.
+// Prints nothing: the caller reports success or failure, returns 0 if the file
+// could not be created or written
 int save_svg_file(const char* filename, SvgDocument* doc) {
-    FILE* file = fopen(filename, "w");
-    if (!file) {
-        printf("Error: Cannot create file %s\n", filename);
-        return 0;
-    }
+    SvgWriter w;
+    if (!svg_writer_open(&w, filename)) return 0;
 
     // Write SVG header
-    fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-    fprintf(file, "<svg width=\"%.1f\" height=\"%.1f\" xmlns=\"http://www.w3.org/2000/svg\">\n", 
-            doc->width, doc->height);
+    svg_writer_str(&w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg");
+    svg_writer_attr(&w, "width", doc->width);
+    svg_writer_attr(&w, "height", doc->height);
+    svg_writer_str(&w, " xmlns=\"http://www.w3.org/2000/svg\">\n");
 
     // Write shapes
     for (int i = 0; i < doc->shape_count; i++) {
-        SvgShape* shape = &doc->shapes[i];
-        
+        const SvgShape* shape = svg_document_shape(doc, i);
+        if (!svg_shape_alive(shape)) continue;
+
         switch (shape->type) {
             case SVG_SHAPE_CIRCLE: {
-                SvgCircle* circle = &shape->data.circle;
-                fprintf(file, "  <circle cx=\"%.1f\" cy=\"%.1f\" r=\"%.1f\" fill=\"%s\"/>\n",
-                        circle->cx, circle->cy, circle->r, circle->fill);
+                const SvgCircle* circle = &shape->data.circle;
+                svg_writer_str(&w, "  <circle");
+                svg_writer_attr(&w, "cx", circle->cx);
+                svg_writer_attr(&w, "cy", circle->cy);
+                svg_writer_attr(&w, "r", circle->r);
+                svg_writer_attr_str(&w, "fill", circle->fill);
                 break;
             }
-                
+
             case SVG_SHAPE_RECT: {
-                SvgRect* rect = &shape->data.rect;
-                fprintf(file, "  <rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\" height=\"%.1f\" fill=\"%s\"/>\n",
-                        rect->x, rect->y, rect->width, rect->height, rect->fill);
+                const SvgRect* rect = &shape->data.rect;
+                svg_writer_str(&w, "  <rect");
+                svg_writer_attr(&w, "x", rect->x);
+                svg_writer_attr(&w, "y", rect->y);
+                svg_writer_attr(&w, "width", rect->width);
+                svg_writer_attr(&w, "height", rect->height);
+                svg_writer_attr_str(&w, "fill", rect->fill);
                 break;
             }
-                
+
             case SVG_SHAPE_LINE: {
-                SvgLine* line = &shape->data.line;
-                fprintf(file, "  <line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"%s\"/>\n",
-                        line->x1, line->y1, line->x2, line->y2, line->stroke);
+                const SvgLine* line = &shape->data.line;
+                svg_writer_str(&w, "  <line");
+                svg_writer_attr(&w, "x1", line->x1);
+                svg_writer_attr(&w, "y1", line->y1);
+                svg_writer_attr(&w, "x2", line->x2);
+                svg_writer_attr(&w, "y2", line->y2);
+                svg_writer_attr_str(&w, "stroke", line->stroke);
                 break;
             }
         }
+        svg_writer_str(&w, "/>\n");
     }
 
     // Write SVG footer
-    fprintf(file, "</svg>\n");
-    fclose(file);
-    
-    printf("Saved %d shapes to %s\n", doc->shape_count, filename);
+    svg_writer_str(&w, "</svg>\n");
+    if (!svg_writer_close(&w)) return 0;
+
     return 1;
 }
 
-// Main interactive loop
-int main() {
-    SvgDocument doc = {0};
-    doc.selected_shape = -1;
-    
-    printf("=== Simple SVG Editor ===\n");
-    printf("Type 'help' for commands\n\n");
-    
-    char command[64];
-    char filename[256];
-    
-    while (1) {
-        printf("> ");
-        if (scanf("%63s", command) != 1) break;
-        
-        if (strcmp(command, "load") == 0) {
-            scanf("%255s", filename);
-            if (parse_svg_file(filename, &doc)) {
-                printf("Loaded %s successfully\n", filename);
-                display_summary(&doc);
-            }
-            
-        } else if (strcmp(command, "list") == 0) {
-            display_shapes(&doc);
-            
-        } else if (strcmp(command, "summary") == 0) {
-            display_summary(&doc);
-            
-        } else if (strcmp(command, "select") == 0) {
-            int id;
-            scanf("%d", &id);
-            select_shape(&doc, id);
-            
-        } else if (strcmp(command, "move") == 0) {
-            double dx, dy;
-            scanf("%lf %lf", &dx, &dy);
-            move_shape(&doc, dx, dy);
-            
-        } else if (strcmp(command, "delete") == 0) {
-            delete_shape(&doc);
-            
-        } else if (strcmp(command, "add_circle") == 0) {
-            double cx, cy, r;
-            char color[16] = "#000000";
-            scanf("%lf %lf %lf", &cx, &cy, &r);
-            // Optional color
-            if (scanf("%15s", color) == 1) {
-                add_circle(&doc, cx, cy, r, color);
-            } else {
-                add_circle(&doc, cx, cy, r, "#000000");
-            }
-            
-        } else if (strcmp(command, "add_rect") == 0) {
-            double x, y, w, h;
-            char color[16] = "#000000";
-            scanf("%lf %lf %lf %lf", &x, &y, &w, &h);
-            // Optional color
-            if (scanf("%15s", color) == 1) {
-                add_rect(&doc, x, y, w, h, color);
-            } else {
-                add_rect(&doc, x, y, w, h, "#000000");
-            }
-            
-        } else if (strcmp(command, "help") == 0) {
-            show_help();
-            
-        } else if (strcmp(command, "quit") == 0) {
-            printf("Goodbye!\n");
+// Replace the document with a file; the old one stays undoable
+static void load_file(Editor* ed, const char* filename) {
+    SvgDocument* before = svg_document_snapshot(ed->doc);
+    if (!before || !parse_svg_file(filename, ed->doc)) {
+        free_svg_document(before);
+        report_error(ed, "Cannot load %s\n", filename);
+        return;
+    }
+    journal_reset(&ed->journal, before, ed->doc);
+    selection_clear(&ed->selection);
+    rebuild_index(ed);
+    say(ed, "Loaded %s successfully\n", filename);
+    if (!ed->script) display_summary(ed->doc);
+}
+
+/* ---------- Command dispatch ---------- */
+
+// args excludes the command name; num holds the leading numeric arguments
+typedef void (*CommandFn)(Editor* ed, char** args, int count, const double* num);
+
+static void cmd_load(Editor* ed, char** args, int count, const double* num) {
+    load_file(ed, args[0]);
+}
+
+static void cmd_save(Editor* ed, char** args, int count, const double* num) {
+    if (save_svg_file(args[0], ed->doc)) {
+        say(ed, "Saved %d shapes to %s\n", ed->doc->live_count, args[0]);
+    } else {
+        report_error(ed, "Cannot save to %s\n", args[0]);
+    }
+}
+
+static void cmd_list(Editor* ed, char** args, int count, const double* num) {
+    display_shapes(ed->doc);
+}
+
+static void cmd_summary(Editor* ed, char** args, int count, const double* num) {
+    display_summary(ed->doc);
+}
+
+static void cmd_select(Editor* ed, char** args, int count, const double* num) {
+    if (num[0] != floor(num[0])) {
+        report_error(ed, "Invalid shape ID\n");
+        return;
+    }
+    select_shape(ed, (int)num[0]);
+}
+
+static void cmd_select_box(Editor* ed, char** args, int count, const double* num) {
+    select_box(ed, num[0], num[1], num[2], num[3]);
+}
+
+static void cmd_select_all(Editor* ed, char** args, int count, const double* num) {
+    select_all(ed);
+}
+
+static void cmd_move(Editor* ed, char** args, int count, const double* num) {
+    move_shape(ed, num[0], num[1]);
+}
+
+static void cmd_scale(Editor* ed, char** args, int count, const double* num) {
+    scale_shape(ed, num[0]);
+}
+
+static void cmd_delete(Editor* ed, char** args, int count, const double* num) {
+    delete_shape(ed);
+}
+
+static void cmd_color(Editor* ed, char** args, int count, const double* num) {
+    recolor_shape(ed, args[0]);
+}
+
+static void cmd_undo(Editor* ed, char** args, int count, const double* num) {
+    undo_redo(ed, 0);
+}
+
+static void cmd_redo(Editor* ed, char** args, int count, const double* num) {
+    undo_redo(ed, 1);
+}
+
+static void cmd_pick(Editor* ed, char** args, int count, const double* num) {
+    pick_shapes(ed, num[0], num[1]);
+}
+
+static void cmd_query(Editor* ed, char** args, int count, const double* num) {
+    query_shapes(ed, num[0], num[1], num[2], num[3]);
+}
+
+static void cmd_add_circle(Editor* ed, char** args, int count, const double* num) {
+    add_circle(ed, num[0], num[1], num[2], count > 3 ? args[3] : "#000000");
+}
+
+static void cmd_add_rect(Editor* ed, char** args, int count, const double* num) {
+    add_rect(ed, num[0], num[1], num[2], num[3], count > 4 ? args[4] : "#000000");
+}
+
+static void cmd_help(Editor* ed, char** args, int count, const double* num) {
+    show_help();
+}
+
+static void cmd_quit(Editor* ed, char** args, int count, const double* num) {
+    ed->quit = 1;
+}
+
+typedef struct {
+    const char* name;
+    int min_args, max_args;   // arguments after the command name
+    int numbers;              // how many leading arguments must be numbers
+    CommandFn run;
+    const char* usage;
+} Command;
+
+static const Command commands[] = {
+    { "load",       1, 1, 0, cmd_load,       "load <file.svg>" },
+    { "save",       1, 1, 0, cmd_save,       "save <file.svg>" },
+    { "list",       0, 0, 0, cmd_list,       "list" },
+    { "summary",    0, 0, 0, cmd_summary,    "summary" },
+    { "select",     1, 1, 1, cmd_select,     "select <id>" },
+    { "select_box", 4, 4, 4, cmd_select_box, "select_box <x> <y> <w> <h>" },
+    { "select_all", 0, 0, 0, cmd_select_all, "select_all" },
+    { "move",       2, 2, 2, cmd_move,       "move <dx> <dy>" },
+    { "scale",      1, 1, 1, cmd_scale,      "scale <factor>" },
+    { "delete",     0, 0, 0, cmd_delete,     "delete" },
+    { "color",      1, 1, 0, cmd_color,      "color <color>" },
+    { "undo",       0, 0, 0, cmd_undo,       "undo" },
+    { "redo",       0, 0, 0, cmd_redo,       "redo" },
+    { "pick",       2, 2, 2, cmd_pick,       "pick <x> <y>" },
+    { "query",      4, 4, 4, cmd_query,      "query <x> <y> <w> <h>" },
+    { "add_circle", 3, 4, 3, cmd_add_circle, "add_circle <cx> <cy> <r> [color]" },
+    { "add_rect",   4, 5, 4, cmd_add_rect,   "add_rect <x> <y> <w> <h> [color]" },
+    { "help",       0, 0, 0, cmd_help,       "help" },
+    { "quit",       0, 0, 0, cmd_quit,       "quit" },
+};
+
+// Parse and run one command line (modified in place). Blank lines and
+// lines starting with '#' are ignored; returns 0 when nothing was run
+static int run_line(Editor* ed, char* line) {
+    char* tokens[MAX_ARGS + 2];
+    int count = 0;
+
+    for (char* p = line; *p && count < MAX_ARGS + 2; ) {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+        tokens[count++] = p;
+        while (*p && !isspace((unsigned char)*p)) p++;
+        if (*p) *p++ = '\0';
+    }
+    if (count == 0 || tokens[0][0] == '#') return 0;
+
+    const Command* cmd = NULL;
+    for (size_t i = 0; i < sizeof(commands) / sizeof(commands[0]); i++) {
+        if (strcmp(tokens[0], commands[i].name) == 0) {
+            cmd = &commands[i];
             break;
-        
-        } else if (strcmp(command, "save") == 0) {
-            scanf("%255s", filename);
-            if (save_svg_file(filename, &doc)) {
-                printf("Saved to %s successfully\n", filename);
-            } else {
-                printf("Error saving to %s\n", filename);
+        }
+    }
+    if (!cmd) {
+        report_error(ed, "Unknown command '%s'. Type 'help' for available commands.\n", tokens[0]);
+        return 1;
+    }
+
+    int argc = count - 1;
+    if (argc < cmd->min_args || argc > cmd->max_args) {
+        report_error(ed, "Usage: %s\n", cmd->usage);
+        return 1;
+    }
+    double num[MAX_ARGS];
+    for (int i = 0; i < cmd->numbers; i++) {
+        char* end;
+        num[i] = strtod(tokens[i + 1], &end);
+        if (end == tokens[i + 1] || *end || !isfinite(num[i])) {
+            report_error(ed, "'%s' is not a number. Usage: %s\n", tokens[i + 1], cmd->usage);
+            return 1;
+        }
+    }
+    cmd->run(ed, tokens + 1, argc, num);
+    return 1;
+}
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Run every line of a script, continuing past bad lines. Input is read in
+// large blocks and split in place, so no per-token stdio calls are made
+static void run_script(Editor* ed, FILE* in) {
+    size_t capacity = SCRIPT_BLOCK, len = 0;
+    char* buf = (char*)malloc(capacity + 1);
+    long commands_run = 0;
+    double start = now_seconds();
+
+    if (!buf) {
+        printf("Error: Out of memory!\n");
+        return;
+    }
+    ed->line = 0;
+    while (!ed->quit) {
+        // A line longer than the buffer: grow so it can be read whole
+        if (len == capacity) {
+            char* grown = (char*)realloc(buf, capacity * 2 + 1);
+            if (!grown) break;
+            buf = grown;
+            capacity *= 2;
+        }
+        size_t n = fread(buf + len, 1, capacity - len, in);
+        len += n;
+        int at_end = n == 0;
+        buf[len] = '\0';
+
+        char* p = buf;
+        char* end = buf + len;
+        while (!ed->quit) {
+            char* newline = (char*)memchr(p, '\n', end - p);
+            if (!newline) {
+                if (!at_end || p == end) break;
+                newline = end;   // last line without a newline
             }
+            *newline = '\0';
+            ed->line++;
+            commands_run += run_line(ed, p);
+            p = newline < end ? newline + 1 : end;
+        }
+        len = end - p;
+        memmove(buf, p, len);
+        if (at_end) break;
+    }
+    free(buf);
+
+    double seconds = now_seconds() - start;
+    fflush(stdout);   // keep list/query output ahead of the summary
+    if (ed->errors > MAX_REPORTED_ERRORS) {
+        fprintf(stderr, "%s: %ld more errors not shown\n", ed->script, ed->errors - MAX_REPORTED_ERRORS);
+    }
+    fprintf(stderr, "%s: %ld lines, %ld commands (%ld failed) in %.3f s, %.0f commands/s\n",
+            ed->script, ed->line, commands_run, ed->errors, seconds,
+            seconds > 0 ? commands_run / seconds : 0.0);
+}
+
+static void usage(const char* program) {
+    printf("Usage: %s                                   interactive session\n", program);
+    printf("       %s --script <edits.txt|-> [in.svg [out.svg]]\n", program);
+    printf("       ... | %s                             commands from a pipe\n", program);
+}
+
+int main(int argc, char* argv[]) {
+    Editor ed = {0};
+    const char* script = NULL;
+    const char* input = NULL;
+    const char* output = NULL;
+
+    if (argc > 1) {
+        if (strcmp(argv[1], "--script") != 0 || argc < 3 || argc > 5) {
+            usage(argv[0]);
+            return 1;
+        }
+        script = argv[2];
+        input = argc > 3 ? argv[3] : NULL;
+        output = argc > 4 ? argv[4] : NULL;
+    } else if (!isatty(fileno(stdin))) {
+        script = "-";   // commands piped in: same fast path as --script -
+    }
+
+    ed.doc = create_svg_document(800, 600);
+    if (!ed.doc) return 1;
+    journal_init(&ed.journal, JOURNAL_DEFAULT_BUDGET);
+    selection_init(&ed.selection);
+    int status = 0;
+
+    if (script) {
+        FILE* in = strcmp(script, "-") == 0 ? stdin : fopen(script, "rb");
+        ed.script = in == stdin ? "<stdin>" : script;
+        if (!in) {
+            printf("Error: Cannot open script %s\n", script);
+            status = 1;
+        } else if (input && !parse_svg_file(input, ed.doc)) {
+            status = 1;
         } else {
-            printf("Unknown command. Type 'help' for available commands.\n");
+            rebuild_index(&ed);
+            run_script(&ed, in);
+            if (output && !save_svg_file(output, ed.doc)) {
+                printf("Error: Cannot save to %s\n", output);
+                status = 1;
+            }
+            if (ed.errors > 0 && status == 0) status = 2;
         }
-        
-        // Clear input buffer
-        int c;
-        while ((c = getchar()) != '\n' && c != EOF);
+        if (in && in != stdin) fclose(in);
+    } else {
+        printf("=== Simple SVG Editor ===\n");
+        printf("Type 'help' for commands\n\n");
+
+        char line[MAX_LINE_LENGTH];
+        while (!ed.quit) {
+            printf("> ");
+            fflush(stdout);
+            if (!fgets(line, sizeof(line), stdin)) break;
+            // Drop the rest of an over-long line instead of running it as a command
+            if (!strchr(line, '\n') && !feof(stdin)) {
+                int c;
+                while ((c = getchar()) != '\n' && c != EOF);
+            }
+            run_line(&ed, line);
+        }
+        printf("Goodbye!\n");
     }
-    
-    return 0;
-}
\ No newline at end of file
+
+    journal_free(&ed.journal);
+    selection_free(&ed.selection);
+    spatial_grid_free(ed.index);
+    free_svg_document(ed.doc);
+    return status;
+}
@@ -4,9 +4,17 @@
 #include <math.h>
 #include <SDL.h>
 #include <SDL_ttf.h>
-#include "../include/svg_types.h"
-#include "../include/svg_parser.h"
-#include "../include/svg_render.h"
+#include "../include/svg_gui_types.h"
+#include "../include/image.h"
+#include "../include/spatial_grid.h"
+#include "../include/svg_display_list.h"
+#include "../include/svg_gui_text.h"
+#include "../include/svg_gui_tiles.h"
+#include "../include/svg_gui_export.h"
+#include "../include/svg_gui_load.h"
+#include "../include/svg_journal.h"
+#include "../include/svg_selection.h"
+#include "../include/svg_gui_replay.h"
 #include "../include/bmp_writer.h"
 #include "../include/jpg_writer.h"
 
@@ -27,6 +35,36 @@
 #define COLOR_BUTTON_HOVER 160, 160, 160
 #define COLOR_SELECTED 255, 0, 0
 #define COLOR_GRID 230, 230, 230
+#define COLOR_BAND 0, 120, 215
+
+// 选中的图形超过这个数时只画它们的总包围盒
+#define SELECTION_OUTLINE_LIMIT 256
+// [ 和 ] 缩放选中图形的倍数
+#define SELECTION_SCALE_STEP 1.25
+
+// 网格间距（文档单位）和屏幕上的最小线距
+#define GRID_SIZE 20
+#define GRID_MIN_PX 8
+
+// 方向键每次平移的屏幕像素，以及每帧补画瓦片的时间预算
+#define PAN_STEP 50
+#define TILE_BUDGET_MS 6.0
+// 每帧把载入的图形加入文档的时间预算，以及每次从队列取出的个数
+#define LOAD_BUDGET_MS 4.0
+#define LOAD_SLICE 256
+
+// 空闲时等待事件的最长时间，到时检查是否需要输出帧统计
+#define IDLE_WAIT_MS 500
+#define FRAME_STATS_SAMPLES 256
+#define FRAME_REPORT_MS 2000
+
+// 最近若干帧的绘制耗时
+typedef struct {
+    double samples[FRAME_STATS_SAMPLES];
+    int count, next;
+    long frames, reported;
+    Uint32 last_report;
+} FrameStats;
 
 // UI元素定义
 typedef struct {
@@ -55,16 +93,36 @@ typedef struct {
     SDL_Renderer* renderer;
     TTF_Font* font;
     TTF_Font* small_font;
+    TextCache text_cache;   // 标签和数值的文字纹理
 
     // SVG文档
     SvgDocument* doc;
+    SpatialGrid* index;     // 图形空间索引，编号为文档槽位
+    int* hits;              // 索引查询结果缓冲
+    int hit_capacity;
+    DisplayList* scene;     // 绘制命令，编号与文档槽位一致
+    Image* pick;            // 拾取缓冲，文档坐标 1:1
+    int indexed_count;      // 上次整体建索引时的槽位数，网格的格子数按它确定
+    TileCache tiles;        // 各缩放层级的画布瓦片，背景透明，网格从下面透出
+    PixelRect dirty;        // 待重绘区域（文档坐标，各次修改的并集），空时 x0 >= x1
     char current_file[256];
+    ExportJob export_job;   // 后台导出，进行中时在工具栏显示进度
+    LoadJob load_job;       // 后台载入，进行中时文档只读，可以浏览和取消
+    SvgDocument* load_before;            // 载入前的文档快照，取消时回退，完成时交给撤销日志
+    Uint64 load_start;
+    SDL_Rect cancel_button; // 载入进度条下的取消按钮
+    SvgJournal journal;     // 撤销/重做，一次拖动记为一条
 
     // UI状态
     ToolType current_tool;
-    int selected_shape_id;
+    SvgSelection selection; // 选中的槽位，拖动、删除、缩放和改色作用于全部
+    int selected_shape_id;  // 最近点选的图形，属性面板显示它
+    int selected_index;     // 该图形在文档中的槽位
     int is_dragging;
-    int drag_start_x, drag_start_y;
+    double drag_start_x, drag_start_y;   // 文档坐标
+    int is_banding;         // 在空白处拖出选框
+    double band_x1, band_y1;             // 选框另一角，起点为 drag_start
+    int recolor_next;       // 下一次改色用调色板里的第几个
     int shape_start_x, shape_start_y;
 
     // 按钮和输入框
@@ -77,14 +135,264 @@ typedef struct {
     int show_file_menu;
     int show_help;
 
-    // 画布偏移和缩放
+    // 画布在窗口中的位置和视图：缩放为 2^zoom_step，
+    // (view_x, view_y) 是画布左上角在该层级像素坐标中的位置，取整数使瓦片对齐屏幕像素
     int canvas_offset_x, canvas_offset_y;
+    int zoom_step;
     float zoom_level;
+    int view_x, view_y;
+    int is_panning;
+    int pan_last_x, pan_last_y;
+    int mouse_x, mouse_y;   // 最近的鼠标位置，滚轮缩放以它为锚点（回放时没有真实鼠标）
+
+    // 只在状态变化后重绘
+    int needs_redraw;
+    FrameStats frame_stats;
+
+    // 网格纹理，按当前间距缓存
+    SDL_Texture* grid_texture;
+    int grid_spacing;
 
 } GUIState;
 
-// 初始化SDL
-int init_sdl(GUIState* gui) {
+void update_property_inputs(GUIState* gui, const SvgShape* shape);
+
+// 记录需要重绘的画布区域，多次修改取并集
+static void mark_dirty(GUIState* gui, const PixelRect* area) {
+    PixelRect* d = &gui->dirty;
+    if (area->x0 >= area->x1 || area->y0 >= area->y1) return;
+    if (d->x0 >= d->x1) {
+        *d = *area;
+        return;
+    }
+    if (area->x0 < d->x0) d->x0 = area->x0;
+    if (area->y0 < d->y0) d->y0 = area->y0;
+    if (area->x1 > d->x1) d->x1 = area->x1;
+    if (area->y1 > d->y1) d->y1 = area->y1;
+}
+
+// 处理待重绘区域：更新拾取缓冲，当前层级已缓存的瓦片只重绘受影响的部分，
+// 其它层级的瓦片等用到时再重绘
+static void redraw_dirty(GUIState* gui) {
+    PixelRect area = gui->dirty;
+    gui->dirty.x0 = gui->dirty.x1 = 0;
+    if (area.x0 >= area.x1 || area.y0 >= area.y1) return;
+
+    tile_cache_invalidate(&gui->tiles, gui->scene, gui->index, &area, gui->zoom_step);
+    if (!gui->pick) return;
+
+    if (area.x0 < 0) area.x0 = 0;
+    if (area.y0 < 0) area.y0 = 0;
+    if (area.x1 > gui->pick->width) area.x1 = gui->pick->width;
+    if (area.y1 > gui->pick->height) area.y1 = gui->pick->height;
+    if (area.x0 >= area.x1 || area.y0 >= area.y1) return;
+
+    GridBox box = { area.x0, area.y0, area.x1, area.y1 };
+    int count = spatial_grid_query(gui->index, &box, &gui->hits, &gui->hit_capacity);
+    display_list_render_pick(gui->scene, gui->pick, NULL, &area, count < 0 ? NULL : gui->hits, count);
+}
+
+// 按当前图形数重新建空间索引。逐个插入不会调整格子数，图形数大幅增加后要重建
+static void rebuild_index(GUIState* gui) {
+    spatial_grid_free(gui->index);
+    gui->index = build_shape_index(gui->doc);
+    gui->indexed_count = gui->doc->shape_count;
+}
+
+// 文档整体变化后重建索引、绘制命令和拾取缓冲
+static void rebuild_scene(GUIState* gui) {
+    display_list_free(gui->scene);
+    rebuild_index(gui);
+    gui->scene = compile_svg_document(gui->doc);
+
+    // 载入或撤销载入可能改变画布尺寸。拾取缓冲按文档 1:1 分配，
+    // 文档过大分配失败时为 NULL，此时画布照常显示，只是点选不到图形
+    int width = (int)gui->doc->width, height = (int)gui->doc->height;
+    if (!gui->pick || gui->pick->width != width || gui->pick->height != height) {
+        free_image(gui->pick);
+        gui->pick = create_image(width, height);
+        if (!gui->pick) printf("拾取缓冲内存不足: %dx%d\n", width, height);
+    }
+
+    if (gui->pick) {
+        PixelRect full = { 0, 0, gui->pick->width, gui->pick->height };
+        mark_dirty(gui, &full);
+    }
+    tile_cache_invalidate_all(&gui->tiles);
+}
+
+// 窗口坐标换算到文档坐标
+static void screen_to_doc(const GUIState* gui, int x, int y, double* doc_x, double* doc_y) {
+    *doc_x = (gui->view_x + x - gui->canvas_offset_x) / (double)gui->zoom_level;
+    *doc_y = (gui->view_y + y - gui->canvas_offset_y) / (double)gui->zoom_level;
+}
+
+static int doc_to_screen_x(const GUIState* gui, double x) {
+    return gui->canvas_offset_x - gui->view_x + (int)floor(x * gui->zoom_level);
+}
+
+static int doc_to_screen_y(const GUIState* gui, double y) {
+    return gui->canvas_offset_y - gui->view_y + (int)floor(y * gui->zoom_level);
+}
+
+// 切换缩放层级，窗口点 (x, y) 下的文档位置保持不动
+static void set_zoom(GUIState* gui, int step, int x, int y) {
+    if (step < TILE_MIN_LEVEL) step = TILE_MIN_LEVEL;
+    if (step > TILE_MAX_LEVEL) step = TILE_MAX_LEVEL;
+    if (step == gui->zoom_step) return;
+
+    double doc_x, doc_y;
+    screen_to_doc(gui, x, y, &doc_x, &doc_y);
+    gui->zoom_step = step;
+    gui->zoom_level = ldexpf(1.0f, step);
+    gui->view_x = (int)floor(doc_x * gui->zoom_level + 0.5) - (x - gui->canvas_offset_x);
+    gui->view_y = (int)floor(doc_y * gui->zoom_level + 0.5) - (y - gui->canvas_offset_y);
+    gui->needs_redraw = 1;
+}
+
+// 平移视图（屏幕像素）
+static void pan_view(GUIState* gui, int dx, int dy) {
+    gui->view_x += dx;
+    gui->view_y += dy;
+    gui->needs_redraw = 1;
+}
+
+// 载入期间文档只读：编辑会和正在加入的图形交错，撤销日志也对不上
+#define editing_locked(gui) load_job_busy(&(gui)->load_job)
+
+// 追加图形（分配新 ID）并登记到空间索引和拾取缓冲，返回槽位
+static int append_shape(GUIState* gui, const SvgShape* shape) {
+    GridBox box;
+    RenderPrimitive cmd;
+    int index = svg_document_add(gui->doc, shape);
+    if (index < 0) return -1;
+
+    svg_shape_bounds(svg_document_shape(gui->doc, index), &box);
+    spatial_grid_insert(gui->index, index, &box);
+    svg_shape_command(svg_document_shape(gui->doc, index), &cmd);
+    display_list_push(gui->scene, &cmd);
+    mark_dirty(gui, &cmd.bounds);
+    return index;
+}
+
+static void add_shape(GUIState* gui, const SvgShape* shape) {
+    if (editing_locked(gui)) return;
+    int index = append_shape(gui, shape);
+    if (index < 0) return;
+
+    const SvgShape* added = svg_document_shape(gui->doc, index);
+
+    gui->selected_shape_id = added->id;
+    gui->selected_index = index;
+    selection_clear(&gui->selection);
+    selection_add(&gui->selection, index);
+    journal_insert(&gui->journal, added, index);
+}
+
+// 图形几何改变、删除或恢复后同步索引，新旧位置标记为待重绘
+static void update_shape(GUIState* gui, int index) {
+    GridBox box;
+    RenderPrimitive* cmd = &gui->scene->cmds[index];
+
+    mark_dirty(gui, &cmd->bounds);
+    svg_shape_bounds(svg_document_shape(gui->doc, index), &box);
+    spatial_grid_move(gui->index, index, &box);
+    svg_shape_command(svg_document_shape(gui->doc, index), cmd);
+    mark_dirty(gui, &cmd->bounds);
+}
+
+// 批量修改后逐个同步选中的槽位
+static void update_selection(GUIState* gui) {
+    for (int slot = selection_next(&gui->selection, 0); slot >= 0 && slot < gui->doc->shape_count;
+         slot = selection_next(&gui->selection, slot + 1)) {
+        update_shape(gui, slot);
+    }
+}
+
+static void clear_selection(GUIState* gui) {
+    selection_clear(&gui->selection);
+    gui->selected_shape_id = -1;
+    gui->selected_index = -1;
+    gui->is_dragging = 0;
+}
+
+// 删除选中的图形：槽位留作墓碑，索引和绘制命令按槽位撤掉，不移动其它图形。
+// 整批记为一步撤销；墓碑过多时压缩文档并重建以槽位为编号的索引和绘制命令
+static void delete_selected(GUIState* gui) {
+    if (editing_locked(gui)) return;
+    if (selection_delete(gui->doc, &gui->selection, &gui->journal) <= 0) return;
+
+    update_selection(gui);
+    clear_selection(gui);
+    if (journal_compact(&gui->journal, gui->doc, 0)) {
+        rebuild_scene(gui);
+    }
+    gui->needs_redraw = 1;
+}
+
+// 缩放或改色选中的图形，缩放以选中部分的包围盒中心为基点
+static void edit_selected(GUIState* gui, ShapeEdit* edit) {
+    if (editing_locked(gui)) return;
+    double box[4];
+    selection_bounds_d(&gui->selection, gui->doc, box);
+    edit->cx = (box[0] + box[2]) / 2;
+    edit->cy = (box[1] + box[3]) / 2;
+    if (selection_edit(gui->doc, &gui->selection, edit, &gui->journal) <= 0) return;
+
+    update_selection(gui);
+    if (gui->selected_index >= 0) {
+        update_property_inputs(gui, svg_document_shape(gui->doc, gui->selected_index));
+    }
+    gui->needs_redraw = 1;
+}
+
+static void scale_selected(GUIState* gui, double factor) {
+    ShapeEdit edit = { SHAPE_EDIT_SCALE, 0, 0, factor, "" };
+    edit_selected(gui, &edit);
+}
+
+// 依次换用调色板里的颜色
+static void recolor_selected(GUIState* gui) {
+    static const char* palette[] = { "#FF0000", "#00A000", "#0000FF", "#FF8000", "#800080", "#000000" };
+    ShapeEdit edit = { SHAPE_EDIT_RECOLOR, 0, 0, 1, "" };
+    int n = (int)(sizeof(palette) / sizeof(palette[0]));
+    strcpy(edit.color, palette[gui->recolor_next++ % n]);
+    edit_selected(gui, &edit);
+}
+
+// 撤销或重做一步，然后同步索引、绘制命令和选中状态
+static void undo_redo(GUIState* gui, int redo) {
+    if (editing_locked(gui)) return;
+    JournalResult result = redo ? journal_redo(&gui->journal, gui->doc)
+                                : journal_undo(&gui->journal, gui->doc);
+    if (result == JOURNAL_NOTHING) return;
+    if (result == JOURNAL_ALL) {
+        // 槽位整体变了，选择随之失效
+        rebuild_scene(gui);
+        selection_clear(&gui->selection);
+    } else {
+        for (int i = 0; i < gui->journal.touched_count; i++) {
+            update_shape(gui, gui->journal.touched[i]);
+        }
+    }
+
+    gui->selected_index = svg_document_find(gui->doc, gui->selected_shape_id);
+    if (gui->selected_index < 0) {
+        gui->selected_shape_id = -1;
+    } else {
+        selection_add(&gui->selection, gui->selected_index);
+        update_property_inputs(gui, svg_document_shape(gui->doc, gui->selected_index));
+    }
+    gui->is_dragging = 0;
+    gui->is_banding = 0;
+    gui->needs_redraw = 1;
+}
+
+// 初始化SDL；headless 时用 dummy 视频驱动和软件渲染，不等垂直同步
+int init_sdl(GUIState* gui, int headless) {
+    if (headless) {
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);   // 已设置环境变量时以它为准
+    }
     if (SDL_Init(SDL_INIT_VIDEO) < 0) {
         printf("SDL初始化失败: %s\n", SDL_GetError());
         return 0;
@@ -108,7 +416,8 @@ int init_sdl(GUIState* gui) {
         return 0;
     }
 
-    gui->renderer = SDL_CreateRenderer(gui->window, -1, SDL_RENDERER_ACCELERATED);
+    Uint32 flags = headless ? SDL_RENDERER_SOFTWARE : SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC;
+    gui->renderer = SDL_CreateRenderer(gui->window, -1, flags);
     if (!gui->renderer) {
         printf("渲染器创建失败: %s\n", SDL_GetError());
         SDL_DestroyWindow(gui->window);
@@ -126,6 +435,10 @@ int init_sdl(GUIState* gui) {
     if (!gui->small_font) {
         gui->small_font = TTF_OpenFont("arial.ttf", 12);
     }
+    text_cache_init(&gui->text_cache, gui->renderer);
+    export_job_init(&gui->export_job);
+    load_job_init(&gui->load_job);
+    tile_cache_init(&gui->tiles, gui->renderer);
 
     return 1;
 }
@@ -133,15 +446,22 @@ int init_sdl(GUIState* gui) {
 // 初始化GUI状态
 void init_gui_state(GUIState* gui) {
     gui->doc = create_svg_document(800, 600);
+    journal_init(&gui->journal, JOURNAL_DEFAULT_BUDGET);
+    selection_init(&gui->selection);
+    rebuild_scene(gui);
     gui->current_tool = TOOL_SELECT;
     gui->selected_shape_id = -1;
+    gui->selected_index = -1;
     gui->is_dragging = 0;
     gui->show_file_menu = 0;
     gui->show_help = 0;
     gui->canvas_offset_x = TOOLBAR_WIDTH;
     gui->canvas_offset_y = 50;
+    gui->zoom_step = 0;
     gui->zoom_level = 1.0f;
+    gui->view_x = gui->view_y = 0;
     gui->current_file[0] = '\0';
+    gui->needs_redraw = 1;
 
     // 创建工具栏按钮
     gui->button_count = 0;
@@ -180,19 +500,14 @@ void draw_button(GUIState* gui, Button* button) {
 
     if (gui->font && button->text) {
         SDL_Color text_color = {0, 0, 0, 255};
-        SDL_Surface* surface = TTF_RenderUTF8_Blended(gui->font, button->text, text_color);
-        if (surface) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(gui->renderer, surface);
-            if (texture) {
-                SDL_Rect text_rect = {
-                    button->rect.x + (button->rect.w - surface->w) / 2,
-                    button->rect.y + (button->rect.h - surface->h) / 2,
-                    surface->w, surface->h
-                };
-                SDL_RenderCopy(gui->renderer, texture, NULL, &text_rect);
-                SDL_DestroyTexture(texture);
-            }
-            SDL_FreeSurface(surface);
+        const TextEntry* text = text_cache_get(&gui->text_cache, gui->font, button->text, text_color);
+        if (text) {
+            SDL_Rect text_rect = {
+                button->rect.x + (button->rect.w - text->w) / 2,
+                button->rect.y + (button->rect.h - text->h) / 2,
+                text->w, text->h
+            };
+            SDL_RenderCopy(gui->renderer, text->texture, NULL, &text_rect);
         }
     }
 }
@@ -210,95 +525,114 @@ void draw_text_input(GUIState* gui, TextInput* input) {
     SDL_RenderDrawRect(gui->renderer, &input->rect);
 
     // 标签
+    SDL_Color text_color = {0, 0, 0, 255};
     if (gui->small_font && input->label) {
-        SDL_Color text_color = {0, 0, 0, 255};
-        SDL_Surface* surface = TTF_RenderUTF8_Blended(gui->small_font, input->label, text_color);
-        if (surface) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(gui->renderer, surface);
-            if (texture) {
-                SDL_Rect text_rect = {
-                    input->rect.x, input->rect.y - 20,
-                    surface->w, surface->h
-                };
-                SDL_RenderCopy(gui->renderer, texture, NULL, &text_rect);
-                SDL_DestroyTexture(texture);
-            }
-            SDL_FreeSurface(surface);
-        }
+        text_draw(&gui->text_cache, gui->small_font, input->label, text_color,
+                  input->rect.x, input->rect.y - 20);
     }
 
-    // 值
+    // 值：拖动时每帧都在变，用字形图集拼接
     if (gui->small_font && input->value[0]) {
-        SDL_Color text_color = {0, 0, 0, 255};
-        SDL_Surface* surface = TTF_RenderUTF8_Blended(gui->small_font, input->value, text_color);
-        if (surface) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(gui->renderer, surface);
-            if (texture) {
-                SDL_Rect text_rect = {
-                    input->rect.x + 5, input->rect.y + (input->rect.h - surface->h) / 2,
-                    surface->w, surface->h
-                };
-                SDL_RenderCopy(gui->renderer, texture, NULL, &text_rect);
-                SDL_DestroyTexture(texture);
-            }
-            SDL_FreeSurface(surface);
+        text_draw_dynamic(&gui->text_cache, gui->small_font, input->value, text_color,
+                          input->rect.x + 5,
+                          input->rect.y + (input->rect.h - TTF_FontHeight(gui->small_font)) / 2);
+    }
+}
+
+// 当前缩放下网格线在屏幕上的间距（像素）。缩小时间距成倍放大，
+// 画布上的网格线数量不会随缩放无限增加
+static int grid_spacing(float zoom) {
+    float spacing = GRID_SIZE * zoom;
+    while (spacing < GRID_MIN_PX) spacing *= 2;
+    return (int)(spacing + 0.5f);
+}
+
+// 预先画好画布背景和网格。纹理比画布大一个间距，平移时网格的相位
+// 只需改变贴图的源矩形；间距变化时才重画
+static void update_grid_texture(GUIState* gui) {
+    int spacing = grid_spacing(gui->zoom_level);
+    if (gui->grid_texture && spacing == gui->grid_spacing) return;
+
+    if (gui->grid_texture) {
+        SDL_DestroyTexture(gui->grid_texture);
+    }
+    int w = CANVAS_WIDTH + spacing, h = CANVAS_HEIGHT + spacing;
+    gui->grid_texture = SDL_CreateTexture(gui->renderer, SDL_PIXELFORMAT_RGBA32,
+                                          SDL_TEXTUREACCESS_STREAMING, w, h);
+    gui->grid_spacing = spacing;
+    if (!gui->grid_texture) return;
+
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(gui->grid_texture, NULL, &pixels, &pitch) != 0) return;
+
+    Uint8 line[3] = {COLOR_GRID}, paper[3] = {COLOR_CANVAS};
+    for (int y = 0; y < h; y++) {
+        Uint8* row = (Uint8*)pixels + (size_t)y * pitch;
+        for (int x = 0; x < w; x++) {
+            const Uint8* c = (x % spacing == 0 || y % spacing == 0) ? line : paper;
+            row[4 * x + 0] = c[0];
+            row[4 * x + 1] = c[1];
+            row[4 * x + 2] = c[2];
+            row[4 * x + 3] = 255;
         }
     }
+    SDL_UnlockTexture(gui->grid_texture);
 }
 
-// 绘制网格
+// 绘制画布背景和网格：一次贴图
 void draw_grid(GUIState* gui) {
-    SDL_SetRenderDrawColor(gui->renderer, COLOR_GRID, 255);
+    SDL_Rect canvas = {gui->canvas_offset_x, gui->canvas_offset_y, CANVAS_WIDTH, CANVAS_HEIGHT};
 
-    int grid_size = 20;
-    for (int x = gui->canvas_offset_x; x < gui->canvas_offset_x + CANVAS_WIDTH; x += grid_size) {
-        SDL_RenderDrawLine(gui->renderer, x, gui->canvas_offset_y,
-                          x, gui->canvas_offset_y + CANVAS_HEIGHT);
-    }
-    for (int y = gui->canvas_offset_y; y < gui->canvas_offset_y + CANVAS_HEIGHT; y += grid_size) {
-        SDL_RenderDrawLine(gui->renderer, gui->canvas_offset_x, y,
-                          gui->canvas_offset_x + CANVAS_WIDTH, y);
+    update_grid_texture(gui);
+    if (!gui->grid_texture) {
+        SDL_SetRenderDrawColor(gui->renderer, COLOR_CANVAS, 255);
+        SDL_RenderFillRect(gui->renderer, &canvas);
+        return;
     }
+
+    // 网格线位于层级像素坐标中间距的整数倍处
+    int spacing = gui->grid_spacing;
+    SDL_Rect src = {(gui->view_x % spacing + spacing) % spacing, (gui->view_y % spacing + spacing) % spacing,
+                    CANVAS_WIDTH, CANVAS_HEIGHT};
+    SDL_RenderCopy(gui->renderer, gui->grid_texture, &src, &canvas);
+}
+
+// 文档坐标的矩形在屏幕上向外留 pad 像素画框，不随缩放变化
+static void draw_outline(GUIState* gui, double x0, double y0, double x1, double y1, int pad) {
+    SDL_Rect outline;
+    outline.x = doc_to_screen_x(gui, x0) - pad;
+    outline.y = doc_to_screen_y(gui, y0) - pad;
+    outline.w = doc_to_screen_x(gui, x1) - outline.x + pad;
+    outline.h = doc_to_screen_y(gui, y1) - outline.y + pad;
+    SDL_RenderDrawRect(gui->renderer, &outline);
 }
 
-// 绘制SVG图形
+// 绘制选中图形的边框和选框，图形本身在画布瓦片里。
+// 选中的太多时只画总包围盒
 void draw_svg_shapes(GUIState* gui) {
     if (!gui->doc) return;
 
-    for (int i = 0; i < gui->doc->shape_count; i++) {
-        SvgShape* shape = &gui->doc->shapes[i];
-
-        // 设置颜色
-        if (shape->type == SVG_SHAPE_LINE) {
-            sscanf(shape->data.line.stroke, "#%02x%02x%02x",
-                   &(int){0}, &(int){0}, &(int){0});
-        } else {
-            sscanf(shape->data.circle.fill, "#%02x%02x%02x",
-                   &(int){0}, &(int){0}, &(int){0});
+    SDL_SetRenderDrawColor(gui->renderer, COLOR_SELECTED, 255);
+    if (gui->selection.count > SELECTION_OUTLINE_LIMIT) {
+        GridBox box;
+        selection_bounds(&gui->selection, gui->doc, &box);
+        if (box.x0 <= box.x1) draw_outline(gui, box.x0, box.y0, box.x1, box.y1, 5);
+    } else {
+        for (int slot = selection_next(&gui->selection, 0); slot >= 0 && slot < gui->doc->shape_count;
+             slot = selection_next(&gui->selection, slot + 1)) {
+            const SvgShape* shape = svg_document_shape(gui->doc, slot);
+            if (!svg_shape_alive(shape)) continue;
+            GridBox box;
+            svg_shape_bounds(shape, &box);
+            draw_outline(gui, box.x0, box.y0, box.x1, box.y1, 5);
         }
+    }
 
-        // 选中状态的边框
-        if (shape->id == gui->selected_shape_id) {
-            SDL_SetRenderDrawColor(gui->renderer, COLOR_SELECTED, 255);
-            SDL_Rect outline;
-
-            switch (shape->type) {
-                case SVG_SHAPE_CIRCLE:
-                    outline.x = gui->canvas_offset_x + (int)(shape->data.circle.cx - shape->data.circle.r - 5);
-                    outline.y = gui->canvas_offset_y + (int)(shape->data.circle.cy - shape->data.circle.r - 5);
-                    outline.w = (int)(shape->data.circle.r * 2 + 10);
-                    outline.h = (int)(shape->data.circle.r * 2 + 10);
-                    SDL_RenderDrawRect(gui->renderer, &outline);
-                    break;
-                case SVG_SHAPE_RECT:
-                    outline.x = gui->canvas_offset_x + (int)(shape->data.rect.x - 5);
-                    outline.y = gui->canvas_offset_y + (int)(shape->data.rect.y - 5);
-                    outline.w = (int)(shape->data.rect.width + 10);
-                    outline.h = (int)(shape->data.rect.height + 10);
-                    SDL_RenderDrawRect(gui->renderer, &outline);
-                    break;
-            }
-        }
+    if (gui->is_banding) {
+        SDL_SetRenderDrawColor(gui->renderer, COLOR_BAND, 255);
+        draw_outline(gui, fmin(gui->drag_start_x, gui->band_x1), fmin(gui->drag_start_y, gui->band_y1),
+                     fmax(gui->drag_start_x, gui->band_x1), fmax(gui->drag_start_y, gui->band_y1), 0);
     }
 }
 
@@ -318,16 +652,20 @@ void draw_gui(GUIState* gui) {
     SDL_SetRenderDrawColor(gui->renderer, COLOR_PROPERTY, 255);
     SDL_RenderFillRect(gui->renderer, &property_panel);
 
-    // 绘制画布背景
+    // 绘制画布背景和网格
     SDL_Rect canvas = {gui->canvas_offset_x, gui->canvas_offset_y, CANVAS_WIDTH, CANVAS_HEIGHT};
-    SDL_SetRenderDrawColor(gui->renderer, COLOR_CANVAS, 255);
-    SDL_RenderFillRect(gui->renderer, &canvas);
-
-    // 绘制网格
     draw_grid(gui);
 
-    // 绘制SVG图形
+    // 绘制SVG图形：变化的区域先局部重绘，再贴上当前层级的瓦片。
+    // 缺的瓦片在时间预算内补画，补不完的留到下一帧
+    redraw_dirty(gui);
+    SDL_RenderSetClipRect(gui->renderer, &canvas);
+    if (tile_cache_draw(&gui->tiles, gui->scene, gui->index, gui->zoom_step,
+                        gui->view_x, gui->view_y, &canvas, TILE_BUDGET_MS) > 0) {
+        gui->needs_redraw = 1;
+    }
     draw_svg_shapes(gui);
+    SDL_RenderSetClipRect(gui->renderer, NULL);
 
     // 绘制按钮
     for (int i = 0; i < gui->button_count; i++) {
@@ -339,59 +677,174 @@ void draw_gui(GUIState* gui) {
         draw_text_input(gui, &gui->inputs[i]);
     }
 
+    // 导出进度条
+    SDL_Color text_color = {0, 0, 0, 255};
+    if (export_job_busy(&gui->export_job)) {
+        SDL_Rect bar = {10, 370, 180, 16};
+        SDL_Rect fill = bar;
+        fill.w = bar.w * SDL_AtomicGet(&gui->export_job.progress) / 100;
+        SDL_SetRenderDrawColor(gui->renderer, 90, 160, 90, 255);
+        SDL_RenderFillRect(gui->renderer, &fill);
+        SDL_SetRenderDrawColor(gui->renderer, 0, 0, 0, 255);
+        SDL_RenderDrawRect(gui->renderer, &bar);
+        text_draw(&gui->text_cache, gui->small_font, "正在导出...", text_color, bar.x, bar.y + bar.h + 4);
+    }
+
+    // 载入进度条、已加入的图形数和取消按钮
+    if (editing_locked(gui)) {
+        char count[32];
+        SDL_Rect bar = {10, 410, 180, 16};
+        SDL_Rect fill = bar;
+        fill.w = bar.w * SDL_AtomicGet(&gui->load_job.progress) / 100;
+        SDL_SetRenderDrawColor(gui->renderer, 90, 120, 190, 255);
+        SDL_RenderFillRect(gui->renderer, &fill);
+        SDL_SetRenderDrawColor(gui->renderer, 0, 0, 0, 255);
+        SDL_RenderDrawRect(gui->renderer, &bar);
+        text_draw(&gui->text_cache, gui->small_font, "正在载入", text_color, bar.x, bar.y + bar.h + 4);
+        snprintf(count, sizeof(count), "%d", gui->doc->live_count);
+        text_draw_dynamic(&gui->text_cache, gui->small_font, count, text_color, bar.x + 60, bar.y + bar.h + 4);
+
+        gui->cancel_button = (SDL_Rect){10, 450, 85, 30};
+        Button cancel = { gui->cancel_button, "取消", 0 };
+        draw_button(gui, &cancel);
+    }
+
     // 绘制标题
     if (gui->font) {
-        SDL_Color text_color = {0, 0, 0, 255};
         const char* title = gui->current_file[0] ? gui->current_file : "SVG 图形编辑器";
-        SDL_Surface* surface = TTF_RenderUTF8_Blended(gui->font, title, text_color);
-        if (surface) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(gui->renderer, surface);
-            if (texture) {
-                SDL_Rect text_rect = {
-                    TOOLBAR_WIDTH + 10, 10, surface->w, surface->h
-                };
-                SDL_RenderCopy(gui->renderer, texture, NULL, &text_rect);
-                SDL_DestroyTexture(texture);
-            }
-            SDL_FreeSurface(surface);
-        }
+        text_draw(&gui->text_cache, gui->font, title, text_color, TOOLBAR_WIDTH + 10, 10);
     }
 
     // 绘制工具栏标题
     if (gui->font) {
-        SDL_Color text_color = {0, 0, 0, 255};
-        SDL_Surface* surface = TTF_RenderUTF8_Blended(gui->font, "工具箱", text_color);
-        if (surface) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(gui->renderer, surface);
-            if (texture) {
-                SDL_Rect text_rect = {10, 10, surface->w, surface->h};
-                SDL_RenderCopy(gui->renderer, texture, NULL, &text_rect);
-                SDL_DestroyTexture(texture);
-            }
-            SDL_FreeSurface(surface);
-        }
+        text_draw(&gui->text_cache, gui->font, "工具箱", text_color, 10, 10);
     }
 
     // 绘制属性面板标题
     if (gui->font) {
-        SDL_Color text_color = {0, 0, 0, 255};
-        SDL_Surface* surface = TTF_RenderUTF8_Blended(gui->font, "属性", text_color);
-        if (surface) {
-            SDL_Texture* texture = SDL_CreateTextureFromSurface(gui->renderer, surface);
-            if (texture) {
-                SDL_Rect text_rect = {CANVAS_WIDTH + TOOLBAR_WIDTH + 10, 10, surface->w, surface->h};
-                SDL_RenderCopy(gui->renderer, texture, NULL, &text_rect);
-                SDL_DestroyTexture(texture);
-            }
-            SDL_FreeSurface(surface);
+        text_draw(&gui->text_cache, gui->font, "属性", text_color, CANVAS_WIDTH + TOOLBAR_WIDTH + 10, 10);
+    }
+}
+
+// 在后台线程导出当前文档的快照，导出期间可以继续编辑
+static void start_export(GUIState* gui, SvgExportFormat format, const char* ext) {
+    if (!gui->doc) return;
+    if (export_job_busy(&gui->export_job)) {
+        printf("上一次导出尚未完成\n");
+        return;
+    }
+
+    char filename[sizeof(gui->current_file) + 8];
+    snprintf(filename, sizeof(filename), "%s%s", gui->current_file[0] ? gui->current_file : "untitled", ext);
+    if (!export_job_start(&gui->export_job, gui->doc, format, filename)) {
+        printf("无法启动导出: %s\n", filename);
+    }
+}
+
+// 导出线程的进度和完成事件
+static void handle_export_event(GUIState* gui, const SDL_UserEvent* event) {
+    if (event->code == EXPORT_EVENT_DONE) {
+        const char* filename = gui->export_job.filename;
+        if (export_job_finish(&gui->export_job)) {
+            printf("已导出到 %s\n", filename);
+        } else {
+            printf("导出失败: %s\n", filename);
         }
     }
+    gui->needs_redraw = 1;
+}
+
+// 在后台线程载入文件：先清空文档，解析出的图形分批加入，画布逐步显示。
+// 原文档留在快照里，取消时回退，完成后整个载入记为一步撤销
+static void start_load(GUIState* gui, const char* filename) {
+    if (editing_locked(gui)) {
+        printf("上一次载入尚未完成\n");
+        return;
+    }
+    char path[sizeof(gui->current_file)];
+    snprintf(path, sizeof(path), "%s", filename);
+
+    gui->load_before = svg_document_snapshot(gui->doc);
+    if (!gui->load_before) return;
+    svg_document_clear(gui->doc);
+    clear_selection(gui);
+    rebuild_scene(gui);
+    if (!load_job_start(&gui->load_job, path)) {
+        printf("无法启动载入: %s\n", path);
+        svg_document_revert(gui->doc, gui->load_before);
+        free_svg_document(gui->load_before);
+        gui->load_before = NULL;
+        rebuild_scene(gui);
+        return;
+    }
+    snprintf(gui->current_file, sizeof(gui->current_file), "%s", path);
+    gui->load_start = SDL_GetPerformanceCounter();
+    gui->needs_redraw = 1;
+}
+
+// 回收载入线程：完整载入时记入撤销日志，取消或失败时回到载入前的文档
+static void finish_load(GUIState* gui) {
+    int ok = load_job_finish(&gui->load_job);
+    double ms = (SDL_GetPerformanceCounter() - gui->load_start) * 1000.0 / SDL_GetPerformanceFrequency();
+    if (ok) {
+        // 载入从空文档开始逐个插入，按最终图形数重建一次索引
+        rebuild_index(gui);
+        journal_reset(&gui->journal, gui->load_before, gui->doc);
+        printf("已载入 %s: %d 个图形，用时 %.0f ms\n", gui->current_file, gui->doc->live_count, ms);
+    } else {
+        printf("载入%s: %s\n", SDL_AtomicGet(&gui->load_job.cancel) ? "已取消" : "失败", gui->current_file);
+        svg_document_revert(gui->doc, gui->load_before);
+        free_svg_document(gui->load_before);
+        clear_selection(gui);
+        rebuild_scene(gui);
+    }
+    gui->load_before = NULL;
+    gui->needs_redraw = 1;
+}
 
-    SDL_RenderPresent(gui->renderer);
+static void cancel_load(GUIState* gui) {
+    load_job_cancel(&gui->load_job);
+    finish_load(gui);
+}
+
+// 在时间预算内把已解析的图形加入文档，剩下的留到下一帧
+static void publish_loaded(GUIState* gui) {
+    LoadJob* job = &gui->load_job;
+    Uint64 start = SDL_GetPerformanceCounter();
+    double budget = LOAD_BUDGET_MS * SDL_GetPerformanceFrequency() / 1000.0;
+    const SvgShape* shapes;
+    int done = 0;
+
+    while (SDL_GetPerformanceCounter() - start < budget) {
+        int n = load_job_take(job, &shapes, LOAD_SLICE, &done);
+        if (n == 0) break;
+        // 第一批之前先按 <svg> 的尺寸调整画布，此时文档还是空的
+        if (job->width > 0 && job->height > 0 &&
+            (job->width != gui->doc->width || job->height != gui->doc->height)) {
+            gui->doc->width = job->width;
+            gui->doc->height = job->height;
+            rebuild_scene(gui);
+        }
+        for (int i = 0; i < n; i++) {
+            if (append_shape(gui, &shapes[i]) < 0) {
+                load_job_cancel(job);
+                break;
+            }
+        }
+        gui->needs_redraw = 1;   // 预算用完时可能还有剩余
+    }
+    // 载入过程中图形数每翻一番重建一次索引，总代价 O(N)，边载入边浏览时查询仍然只扫附近的格子
+    if (!done && gui->doc->shape_count >= 2 * gui->indexed_count + LOAD_SLICE) rebuild_index(gui);
+    if (done) finish_load(gui);
 }
 
 // 处理鼠标点击
-void handle_mouse_click(GUIState* gui, int x, int y) {
+void handle_mouse_click(GUIState* gui, int x, int y, int shift) {
+    if (editing_locked(gui) && SDL_PointInRect(&(SDL_Point){x, y}, &gui->cancel_button)) {
+        cancel_load(gui);
+        return;
+    }
+
     // 检查按钮点击
     for (int i = 0; i < gui->button_count; i++) {
         if (SDL_PointInRect(&(SDL_Point){x, y}, &gui->buttons[i].rect)) {
@@ -400,36 +853,29 @@ void handle_mouse_click(GUIState* gui, int x, int y) {
                 case 1: gui->current_tool = TOOL_CIRCLE; break;
                 case 2: gui->current_tool = TOOL_RECT; break;
                 case 3: gui->current_tool = TOOL_LINE; break;
-                case 4: // 打开文件
-                    printf("打开文件功能待实现\n");
+                case 4: // 打开文件：重新载入当前文件，其它文件从命令行给出或拖到窗口上
+                    if (gui->current_file[0]) {
+                        start_load(gui, gui->current_file);
+                    } else {
+                        printf("用法: svg_gui 文件.svg，或把 SVG 文件拖到窗口上\n");
+                    }
                     break;
                 case 5: // 保存文件
                     printf("保存文件功能待实现\n");
                     break;
                 case 6: // 导出BMP
-                    if (gui->doc && gui->current_file[0]) {
-                        char bmp_file[256];
-                        strcpy(bmp_file, gui->current_file);
-                        strcat(bmp_file, ".bmp");
-                        if (export_to_bmp(gui->doc, bmp_file)) {
-                            printf("已导出到 %s\n", bmp_file);
-                        }
-                    }
+                    start_export(gui, SVG_EXPORT_BMP, ".bmp");
                     break;
                 case 7: // 导出JPG
-                    if (gui->doc && gui->current_file[0]) {
-                        char jpg_file[256];
-                        strcpy(jpg_file, gui->current_file);
-                        strcat(jpg_file, ".jpg");
-                        if (export_to_jpg(gui->doc, jpg_file)) {
-                            printf("已导出到 %s\n", jpg_file);
-                        }
-                    }
+                    start_export(gui, SVG_EXPORT_JPG, ".jpg");
                     break;
                 case 8: // 清空画布
-                    if (gui->doc) {
-                        gui->doc->shape_count = 0;
-                        gui->selected_shape_id = -1;
+                    if (gui->doc && !editing_locked(gui)) {
+                        SvgDocument* before = svg_document_snapshot(gui->doc);
+                        svg_document_clear(gui->doc);
+                        journal_reset(&gui->journal, before, gui->doc);
+                        clear_selection(gui);
+                        rebuild_scene(gui);
                     }
                     break;
                 case 9: // 帮助
@@ -444,80 +890,63 @@ void handle_mouse_click(GUIState* gui, int x, int y) {
     if (x >= gui->canvas_offset_x && x < gui->canvas_offset_x + CANVAS_WIDTH &&
         y >= gui->canvas_offset_y && y < gui->canvas_offset_y + CANVAS_HEIGHT) {
 
-        int canvas_x = x - gui->canvas_offset_x;
-        int canvas_y = y - gui->canvas_offset_y;
+        double canvas_x, canvas_y;
+        screen_to_doc(gui, x, y, &canvas_x, &canvas_y);
 
         if (gui->current_tool == TOOL_SELECT) {
-            // 选择图形
-            gui->selected_shape_id = -1;
-            for (int i = gui->doc->shape_count - 1; i >= 0; i--) {
-                SvgShape* shape = &gui->doc->shapes[i];
-                int is_hit = 0;
-
-                switch (shape->type) {
-                    case SVG_SHAPE_CIRCLE:
-                        {
-                            double dx = canvas_x - shape->data.circle.cx;
-                            double dy = canvas_y - shape->data.circle.cy;
-                            if (sqrt(dx*dx + dy*dy) <= shape->data.circle.r) {
-                                is_hit = 1;
-                            }
-                        }
-                        break;
-                    case SVG_SHAPE_RECT:
-                        if (canvas_x >= shape->data.rect.x &&
-                            canvas_x <= shape->data.rect.x + shape->data.rect.width &&
-                            canvas_y >= shape->data.rect.y &&
-                            canvas_y <= shape->data.rect.y + shape->data.rect.height) {
-                            is_hit = 1;
-                        }
-                        break;
-                }
-
-                if (is_hit) {
-                    gui->selected_shape_id = shape->id;
-                    gui->is_dragging = 1;
-                    gui->drag_start_x = canvas_x;
-                    gui->drag_start_y = canvas_y;
-                    update_property_inputs(gui, shape);
-                    break;
+            // 选择图形：拾取缓冲直接给出该像素上最上层的图形。
+            // Shift 点击增减选择；点在已选中的图形上拖动整组，点在空白处拖出选框
+            redraw_dirty(gui);
+            int index = gui->pick ? display_list_pick(gui->pick, (int)floor(canvas_x), (int)floor(canvas_y)) : -1;
+            gui->drag_start_x = canvas_x;
+            gui->drag_start_y = canvas_y;
+            if (index < 0) {
+                if (!shift) clear_selection(gui);
+                gui->is_banding = 1;
+                gui->band_x1 = canvas_x;
+                gui->band_y1 = canvas_y;
+            } else if (shift && selection_has(&gui->selection, index)) {
+                selection_remove(&gui->selection, index);
+                if (index == gui->selected_index) {
+                    gui->selected_shape_id = -1;
+                    gui->selected_index = -1;
                 }
+            } else {
+                if (!shift && !selection_has(&gui->selection, index)) selection_clear(&gui->selection);
+                selection_add(&gui->selection, index);
+                const SvgShape* shape = svg_document_shape(gui->doc, index);
+                gui->selected_shape_id = shape->id;
+                gui->selected_index = index;
+                gui->is_dragging = !editing_locked(gui);
+                update_property_inputs(gui, shape);
             }
         } else if (gui->current_tool == TOOL_CIRCLE) {
             // 添加圆形
             SvgShape new_shape;
             new_shape.type = SVG_SHAPE_CIRCLE;
-            new_shape.id = gui->doc->shape_count + 1;
             new_shape.data.circle.cx = canvas_x;
             new_shape.data.circle.cy = canvas_y;
             new_shape.data.circle.r = 30;
             strcpy(new_shape.data.circle.fill, "#FF0000");
 
-            if (gui->doc->shape_count < MAX_SHAPES) {
-                gui->doc->shapes[gui->doc->shape_count++] = new_shape;
-                gui->selected_shape_id = new_shape.id;
-            }
+            add_shape(gui, &new_shape);
         } else if (gui->current_tool == TOOL_RECT) {
             // 添加矩形
             SvgShape new_shape;
             new_shape.type = SVG_SHAPE_RECT;
-            new_shape.id = gui->doc->shape_count + 1;
             new_shape.data.rect.x = canvas_x - 40;
             new_shape.data.rect.y = canvas_y - 30;
             new_shape.data.rect.width = 80;
             new_shape.data.rect.height = 60;
             strcpy(new_shape.data.rect.fill, "#0000FF");
 
-            if (gui->doc->shape_count < MAX_SHAPES) {
-                gui->doc->shapes[gui->doc->shape_count++] = new_shape;
-                gui->selected_shape_id = new_shape.id;
-            }
+            add_shape(gui, &new_shape);
         }
     }
 }
 
 // 更新属性输入框
-void update_property_inputs(GUIState* gui, SvgShape* shape) {
+void update_property_inputs(GUIState* gui, const SvgShape* shape) {
     if (!shape) return;
 
     switch (shape->type) {
@@ -545,98 +974,313 @@ void update_property_inputs(GUIState* gui, SvgShape* shape) {
     }
 }
 
-// 主循环
-int main() {
+// 按当前鼠标位置拖动选中的全部图形（窗口坐标），一次拖动记为一步撤销
+void drag_selected(GUIState* gui, int x, int y) {
+    double canvas_x, canvas_y;
+    screen_to_doc(gui, x, y, &canvas_x, &canvas_y);
+    double dx = canvas_x - gui->drag_start_x;
+    double dy = canvas_y - gui->drag_start_y;
+    if (dx == 0 && dy == 0) return;
+
+    if (selection_move(gui->doc, &gui->selection, dx, dy, &gui->journal) <= 0) return;
+    update_selection(gui);
+    if (gui->selected_index >= 0) {
+        update_property_inputs(gui, svg_document_shape(gui->doc, gui->selected_index));
+    }
+
+    gui->drag_start_x = canvas_x;
+    gui->drag_start_y = canvas_y;
+    gui->needs_redraw = 1;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+void frame_stats_add(FrameStats* stats, double ms) {
+    stats->samples[stats->next] = ms;
+    stats->next = (stats->next + 1) % FRAME_STATS_SAMPLES;
+    if (stats->count < FRAME_STATS_SAMPLES) stats->count++;
+    stats->frames++;
+}
+
+// 每隔 FRAME_REPORT_MS 在终端输出最近帧的 p50/p99 绘制耗时，force 时立即输出
+void frame_stats_report(FrameStats* stats, int force) {
+    Uint32 now = SDL_GetTicks();
+    if (stats->count == 0 || stats->frames == stats->reported) return;
+    if (!force && now - stats->last_report < FRAME_REPORT_MS) return;
+
+    double sorted[FRAME_STATS_SAMPLES];
+    memcpy(sorted, stats->samples, stats->count * sizeof(double));
+    qsort(sorted, stats->count, sizeof(double), compare_double);
+
+    printf("帧耗时: p50 %.2f ms, p99 %.2f ms (最近 %d 帧, 共 %ld 帧)\n",
+           sorted[stats->count / 2], sorted[(stats->count * 99) / 100],
+           stats->count, stats->frames);
+    stats->last_report = now;
+    stats->reported = stats->frames;
+}
+
+// 松开选框：选中与它相交的图形
+static void finish_band(GUIState* gui) {
+    GridBox box = { (float)fmin(gui->drag_start_x, gui->band_x1), (float)fmin(gui->drag_start_y, gui->band_y1),
+                    (float)fmax(gui->drag_start_x, gui->band_x1), (float)fmax(gui->drag_start_y, gui->band_y1) };
+    gui->is_banding = 0;
+    gui->needs_redraw = 1;
+    int count = spatial_grid_query(gui->index, &box, &gui->hits, &gui->hit_capacity);
+    if (count <= 0) return;
+
+    selection_add_slots(&gui->selection, gui->doc, gui->hits, count);
+    if (gui->selected_index < 0) {
+        gui->selected_index = selection_next(&gui->selection, 0);
+        gui->selected_shape_id = svg_document_shape(gui->doc, gui->selected_index)->id;
+        update_property_inputs(gui, svg_document_shape(gui->doc, gui->selected_index));
+    }
+}
+
+// 主循环。--record 录制输入轨迹，--replay 在无窗口环境下回放轨迹并输出性能统计
+int main(int argc, char* argv[]) {
     GUIState gui = {0};
+    ReplaySession replay = {0};
+    const char* record_path = NULL;
+    const char* replay_path = NULL;
+    const char* open_path = NULL;
+    int realtime = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = 1;
+        } else if (argv[i][0] != '-' && !open_path) {
+            open_path = argv[i];
+        } else {
+            printf("用法: %s [文件.svg] [--record 轨迹文件] [--replay 轨迹文件 [--realtime]]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (replay_path && !replay_load(&replay, replay_path, realtime)) {
+        return 1;
+    }
 
-    if (!init_sdl(&gui)) {
+    if (!init_sdl(&gui, replay_path != NULL)) {
+        replay_free(&replay);
         return 1;
     }
+    if (record_path && !replay_record_open(&replay, record_path)) {
+        printf("无法创建轨迹文件: %s\n", record_path);
+    }
 
     init_gui_state(&gui);
+    if (open_path) start_load(&gui, open_path);
 
     printf("=== SVG 图形编辑器 ===\n");
     printf("使用鼠标点击工具栏选择工具\n");
     printf("在画布上点击添加图形或选择现有图形\n");
+    printf("Shift+点击增减选择，在空白处拖动框选，Ctrl+A 全选\n");
+    printf("Delete 删除选中的图形，[ ] 缩放，C 改色，Ctrl+Z 撤销，Ctrl+Y 或 Ctrl+Shift+Z 重做\n");
+    printf("滚轮或 +/- 缩放，0 复位，方向键或右键拖动平移\n");
+    printf("把 SVG 文件拖到窗口上载入，载入中可以浏览，ESC 或“取消”按钮取消载入\n");
     printf("按 ESC 或关闭窗口退出\n");
 
     int running = 1;
     SDL_Event event;
 
     while (running) {
-        while (SDL_PollEvent(&event)) {
-            switch (event.type) {
-                case SDL_QUIT:
-                    running = 0;
-                    break;
-
-                case SDL_KEYDOWN:
-                    if (event.key.keysym.sym == SDLK_ESCAPE) {
+        // 没有待绘制的内容时阻塞等待事件，不再空转重绘；回放时只等到下一个轨迹事件到期
+        int timeout = gui.needs_redraw ? 0 : IDLE_WAIT_MS;
+        int has_motion = 0, motion_x = 0, motion_y = 0;
+        int replay_wait = replay_pump(&replay);
+        if (replay_wait >= 0 && replay_wait < timeout) timeout = replay_wait;
+
+        if (SDL_WaitEventTimeout(&event, timeout)) {
+            do {
+                replay_record_event(&replay, &event);
+                switch (event.type) {
+                    case SDL_QUIT:
                         running = 0;
-                    }
-                    break;
+                        break;
 
-                case SDL_MOUSEBUTTONDOWN:
-                    if (event.button.button == SDL_BUTTON_LEFT) {
-                        handle_mouse_click(&gui, event.button.x, event.button.y);
-                    }
-                    break;
+                    case SDL_KEYDOWN:
+                        switch (event.key.keysym.sym) {
+                            case SDLK_ESCAPE:
+                                // 载入中先取消载入，否则退出
+                                if (editing_locked(&gui)) {
+                                    cancel_load(&gui);
+                                } else {
+                                    running = 0;
+                                }
+                                break;
+                            case SDLK_DELETE: delete_selected(&gui); break;
+                            case SDLK_z:
+                                if (event.key.keysym.mod & KMOD_CTRL) {
+                                    undo_redo(&gui, (event.key.keysym.mod & KMOD_SHIFT) != 0);
+                                }
+                                break;
+                            case SDLK_y:
+                                if (event.key.keysym.mod & KMOD_CTRL) undo_redo(&gui, 1);
+                                break;
+                            case SDLK_a:
+                                if (event.key.keysym.mod & KMOD_CTRL) {
+                                    selection_select_all(&gui.selection, gui.doc);
+                                    gui.needs_redraw = 1;
+                                }
+                                break;
+                            case SDLK_LEFTBRACKET: scale_selected(&gui, 1 / SELECTION_SCALE_STEP); break;
+                            case SDLK_RIGHTBRACKET: scale_selected(&gui, SELECTION_SCALE_STEP); break;
+                            case SDLK_c: recolor_selected(&gui); break;
+                            // 键盘缩放以画布中心为锚点
+                            case SDLK_PLUS:
+                            case SDLK_EQUALS:
+                                set_zoom(&gui, gui.zoom_step + 1, gui.canvas_offset_x + CANVAS_WIDTH / 2,
+                                         gui.canvas_offset_y + CANVAS_HEIGHT / 2);
+                                break;
+                            case SDLK_MINUS:
+                                set_zoom(&gui, gui.zoom_step - 1, gui.canvas_offset_x + CANVAS_WIDTH / 2,
+                                         gui.canvas_offset_y + CANVAS_HEIGHT / 2);
+                                break;
+                            case SDLK_0:
+                                set_zoom(&gui, 0, gui.canvas_offset_x, gui.canvas_offset_y);
+                                gui.view_x = gui.view_y = 0;
+                                break;
+                            case SDLK_LEFT: pan_view(&gui, -PAN_STEP, 0); break;
+                            case SDLK_RIGHT: pan_view(&gui, PAN_STEP, 0); break;
+                            case SDLK_UP: pan_view(&gui, 0, -PAN_STEP); break;
+                            case SDLK_DOWN: pan_view(&gui, 0, PAN_STEP); break;
+                        }
+                        break;
 
-                case SDL_MOUSEBUTTONUP:
-                    if (event.button.button == SDL_BUTTON_LEFT) {
-                        gui.is_dragging = 0;
+                    case SDL_MOUSEWHEEL: {
+                        // 滚轮以鼠标位置为锚点缩放
+                        if (event.wheel.y > 0) set_zoom(&gui, gui.zoom_step + 1, gui.mouse_x, gui.mouse_y);
+                        if (event.wheel.y < 0) set_zoom(&gui, gui.zoom_step - 1, gui.mouse_x, gui.mouse_y);
+                        break;
                     }
-                    break;
 
-                case SDL_MOUSEMOTION:
-                    if (gui.is_dragging && gui.selected_shape_id != -1) {
-                        int canvas_x = event.motion.x - gui.canvas_offset_x;
-                        int canvas_y = event.motion.y - gui.canvas_offset_y;
-                        int dx = canvas_x - gui.drag_start_x;
-                        int dy = canvas_y - gui.drag_start_y;
-
-                        // 移动选中的图形
-                        for (int i = 0; i < gui.doc->shape_count; i++) {
-                            if (gui.doc->shapes[i].id == gui.selected_shape_id) {
-                                SvgShape* shape = &gui.doc->shapes[i];
-
-                                switch (shape->type) {
-                                    case SVG_SHAPE_CIRCLE:
-                                        shape->data.circle.cx += dx;
-                                        shape->data.circle.cy += dy;
-                                        break;
-                                    case SVG_SHAPE_RECT:
-                                        shape->data.rect.x += dx;
-                                        shape->data.rect.y += dy;
-                                        break;
-                                    case SVG_SHAPE_LINE:
-                                        shape->data.line.x1 += dx;
-                                        shape->data.line.y1 += dy;
-                                        shape->data.line.x2 += dx;
-                                        shape->data.line.y2 += dy;
-                                        break;
-                                }
+                    case SDL_WINDOWEVENT:
+                        // 窗口被遮挡、恢复或改变大小后需要重画
+                        gui.needs_redraw = 1;
+                        break;
 
-                                update_property_inputs(&gui, shape);
-                                break;
+                    case SDL_MOUSEBUTTONDOWN:
+                        gui.mouse_x = event.button.x;
+                        gui.mouse_y = event.button.y;
+                        if (event.button.button == SDL_BUTTON_LEFT) {
+                            // 先应用之前合并的移动，保持事件顺序
+                            if (has_motion && gui.is_dragging) {
+                                drag_selected(&gui, motion_x, motion_y);
+                                has_motion = 0;
                             }
+                            handle_mouse_click(&gui, event.button.x, event.button.y,
+                                               (SDL_GetModState() & KMOD_SHIFT) != 0);
+                            gui.needs_redraw = 1;
+                        } else {
+                            // 右键或中键拖动平移视图
+                            gui.is_panning = 1;
+                            gui.pan_last_x = event.button.x;
+                            gui.pan_last_y = event.button.y;
                         }
+                        break;
 
-                        gui.drag_start_x = canvas_x;
-                        gui.drag_start_y = canvas_y;
-                    }
-                    break;
-            }
+                    case SDL_MOUSEBUTTONUP:
+                        if (event.button.button == SDL_BUTTON_LEFT) {
+                            if (has_motion && gui.is_dragging) {
+                                drag_selected(&gui, motion_x, motion_y);
+                                has_motion = 0;
+                            }
+                            gui.is_dragging = 0;
+                            journal_seal(&gui.journal);   // 一次拖动到此为止
+                            if (gui.is_banding) {
+                                screen_to_doc(&gui, event.button.x, event.button.y, &gui.band_x1, &gui.band_y1);
+                                finish_band(&gui);
+                            }
+                        } else {
+                            gui.is_panning = 0;
+                        }
+                        break;
+
+                    case SDL_MOUSEMOTION:
+                        gui.mouse_x = event.motion.x;
+                        gui.mouse_y = event.motion.y;
+                        // 同一批里的移动事件只保留最后一个位置
+                        if (gui.is_dragging && gui.selected_shape_id != -1) {
+                            has_motion = 1;
+                            motion_x = event.motion.x;
+                            motion_y = event.motion.y;
+                        }
+                        if (gui.is_banding) {
+                            screen_to_doc(&gui, event.motion.x, event.motion.y, &gui.band_x1, &gui.band_y1);
+                            gui.needs_redraw = 1;
+                        }
+                        if (gui.is_panning) {
+                            pan_view(&gui, gui.pan_last_x - event.motion.x, gui.pan_last_y - event.motion.y);
+                            gui.pan_last_x = event.motion.x;
+                            gui.pan_last_y = event.motion.y;
+                        }
+                        break;
+
+                    case SDL_DROPFILE:
+                        start_load(&gui, event.drop.file);
+                        SDL_free(event.drop.file);
+                        break;
+
+                    default:
+                        if (event.type == gui.export_job.event_type) {
+                            handle_export_event(&gui, &event.user);
+                        } else if (event.type == gui.load_job.event_type) {
+                            gui.needs_redraw = 1;   // 新的一批图形或解析结束，在下面加入文档
+                        }
+                        break;
+                }
+            } while (running && SDL_PollEvent(&event));
         }
 
-        draw_gui(&gui);
-        SDL_Delay(16); // 约60 FPS
+        if (has_motion && gui.is_dragging) {
+            drag_selected(&gui, motion_x, motion_y);
+        }
+        if (editing_locked(&gui)) {
+            publish_loaded(&gui);
+        }
+
+        if (gui.needs_redraw && running) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            gui.needs_redraw = 0;
+            draw_gui(&gui);   // 瓦片没补完时会重新置位
+            frame_stats_add(&gui.frame_stats,
+                            (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+            SDL_RenderPresent(gui.renderer);   // 开启垂直同步，由它控制帧率
+            replay_frame(&replay, (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency());
+        }
+        frame_stats_report(&gui.frame_stats, 0);
+
+        // 轨迹放完并且画面已经稳定后结束回放
+        if (replay.replaying && replay_done(&replay) && !gui.needs_redraw && !editing_locked(&gui)) {
+            running = 0;
+        }
     }
+    frame_stats_report(&gui.frame_stats, 1);
+    export_job_finish(&gui.export_job);
+    if (editing_locked(&gui)) cancel_load(&gui);
+    load_job_free(&gui.load_job);
+    replay_report(&replay, gui.doc);
+    replay_free(&replay);
 
     // 清理资源
-    if (gui.doc) {
-        free(gui.doc);
+    journal_free(&gui.journal);
+    selection_free(&gui.selection);
+    free_svg_document(gui.doc);
+    spatial_grid_free(gui.index);
+    free(gui.hits);
+    display_list_free(gui.scene);
+    free_image(gui.pick);
+    tile_cache_free(&gui.tiles);
+    if (gui.grid_texture) {
+        SDL_DestroyTexture(gui.grid_texture);
     }
+    text_cache_free(&gui.text_cache);
     if (gui.font) {
         TTF_CloseFont(gui.font);
     }
@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <string.h>
+#include "../include/svg_gui_export.h"
+
+int export_job_init(ExportJob* job) {
+    memset(job, 0, sizeof(*job));
+    job->event_type = SDL_RegisterEvents(1);
+    return job->event_type != (Uint32)-1;
+}
+
+int export_job_busy(const ExportJob* job) {
+    return job->thread != NULL;
+}
+
+static void push_event(ExportJob* job, int code) {
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = job->event_type;
+    event.user.code = code;
+    SDL_PushEvent(&event);
+}
+
+// 百分比变化时才推送进度事件
+static void report_progress(void* ctx, int done, int total) {
+    ExportJob* job = (ExportJob*)ctx;
+    int percent = done * 100 / total;
+    if (percent != SDL_AtomicGet(&job->progress)) {
+        SDL_AtomicSet(&job->progress, percent);
+        push_event(job, EXPORT_EVENT_PROGRESS);
+    }
+}
+
+static int export_thread(void* data) {
+    ExportJob* job = (ExportJob*)data;
+    job->ok = export_svg_document(job->snapshot, job->filename, job->format, report_progress, job);
+    push_event(job, EXPORT_EVENT_DONE);
+    return 0;
+}
+
+int export_job_start(ExportJob* job, const SvgDocument* doc, SvgExportFormat format, const char* filename) {
+    if (export_job_busy(job) || job->event_type == (Uint32)-1) return 0;
+
+    job->snapshot = svg_document_snapshot(doc);
+    if (!job->snapshot) return 0;
+    job->format = format;
+    snprintf(job->filename, sizeof(job->filename), "%s", filename);
+    job->ok = 0;
+    SDL_AtomicSet(&job->progress, 0);
+
+    job->thread = SDL_CreateThread(export_thread, "svg-export", job);
+    if (!job->thread) {
+        free_svg_document(job->snapshot);
+        job->snapshot = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+int export_job_finish(ExportJob* job) {
+    if (!job->thread) return 0;
+
+    SDL_WaitThread(job->thread, NULL);
+    job->thread = NULL;
+    free_svg_document(job->snapshot);
+    job->snapshot = NULL;
+    return job->ok;
+}
@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../include/svg_gui_load.h"
+
+// 每次读入的字节数；一个标签超过这个长度时丢弃
+#define LOAD_READ_SIZE (1 << 16)
+// 工作线程每攒够这么多图形放入队列一次
+#define LOAD_BATCH 4096
+
+int load_job_init(LoadJob* job) {
+    memset(job, 0, sizeof(*job));
+    job->event_type = SDL_RegisterEvents(1);
+    job->lock = SDL_CreateMutex();
+    return job->event_type != (Uint32)-1 && job->lock != NULL;
+}
+
+void load_job_free(LoadJob* job) {
+    load_job_cancel(job);
+    load_job_finish(job);
+    if (job->lock) SDL_DestroyMutex(job->lock);
+    job->lock = NULL;
+}
+
+int load_job_busy(const LoadJob* job) {
+    return job->thread != NULL;
+}
+
+static void push_event(LoadJob* job, int code) {
+    SDL_Event event;
+    memset(&event, 0, sizeof(event));
+    event.type = job->event_type;
+    event.user.code = code;
+    SDL_PushEvent(&event);
+}
+
+/* ---------- 流式解析（工作线程） ---------- */
+
+// 在标签 [tag, end) 中找属性 name="..."，返回值的起点，*value_end 为结束引号
+static const char* find_attr(const char* tag, const char* end, const char* name, const char** value_end) {
+    size_t n = strlen(name);
+    for (const char* p = tag; p + n + 2 <= end; p++) {
+        if (p != tag && !isspace((unsigned char)p[-1])) continue;
+        if (memcmp(p, name, n) != 0 || p[n] != '=' || (p[n + 1] != '"' && p[n + 1] != '\'')) continue;
+        const char* value = p + n + 2;
+        const char* close = (const char*)memchr(value, p[n + 1], end - value);
+        if (!close) return NULL;
+        *value_end = close;
+        return value;
+    }
+    return NULL;
+}
+
+static double attr_number(const char* tag, const char* end, const char* name) {
+    const char* value_end;
+    const char* value = find_attr(tag, end, name, &value_end);
+    return value ? strtod(value, NULL) : 0;
+}
+
+// 颜色原样保留（十六进制或颜色名），由绘制时解析，没有时为黑色
+static void attr_color(const char* tag, const char* end, const char* name, char* out) {
+    const char* value_end;
+    const char* value = find_attr(tag, end, name, &value_end);
+    if (!value) {
+        strcpy(out, "#000000");
+        return;
+    }
+    size_t n = value_end - value;
+    if (n > 15) n = 15;
+    memcpy(out, value, n);
+    out[n] = '\0';
+}
+
+// 标签名是否为 name（后面紧跟空白、/ 或标签结尾）
+static int tag_is(const char* tag, const char* end, const char* name) {
+    size_t n = strlen(name);
+    if ((size_t)(end - tag) < n || memcmp(tag, name, n) != 0) return 0;
+    return tag + n == end || isspace((unsigned char)tag[n]) || tag[n] == '/';
+}
+
+// 解析 '<' 与 '>' 之间的一个标签，是图形时写入 out 并返回 1
+static int parse_tag(LoadJob* job, const char* tag, const char* end, SvgShape* out) {
+    memset(out, 0, sizeof(*out));
+    if (tag_is(tag, end, "circle")) {
+        out->type = SVG_SHAPE_CIRCLE;
+        out->data.circle.cx = attr_number(tag, end, "cx");
+        out->data.circle.cy = attr_number(tag, end, "cy");
+        out->data.circle.r = attr_number(tag, end, "r");
+        attr_color(tag, end, "fill", out->data.circle.fill);
+        return 1;
+    }
+    if (tag_is(tag, end, "rect")) {
+        out->type = SVG_SHAPE_RECT;
+        out->data.rect.x = attr_number(tag, end, "x");
+        out->data.rect.y = attr_number(tag, end, "y");
+        out->data.rect.width = attr_number(tag, end, "width");
+        out->data.rect.height = attr_number(tag, end, "height");
+        attr_color(tag, end, "fill", out->data.rect.fill);
+        return 1;
+    }
+    if (tag_is(tag, end, "line")) {
+        out->type = SVG_SHAPE_LINE;
+        out->data.line.x1 = attr_number(tag, end, "x1");
+        out->data.line.y1 = attr_number(tag, end, "y1");
+        out->data.line.x2 = attr_number(tag, end, "x2");
+        out->data.line.y2 = attr_number(tag, end, "y2");
+        attr_color(tag, end, "stroke", out->data.line.stroke);
+        return 1;
+    }
+    if (tag_is(tag, end, "svg")) {
+        SDL_LockMutex(job->lock);
+        job->width = attr_number(tag, end, "width");
+        job->height = attr_number(tag, end, "height");
+        SDL_UnlockMutex(job->lock);
+    }
+    return 0;
+}
+
+// 把一批图形放入队列，界面线程在等待时唤醒它；内存不足返回 0
+static int publish(LoadJob* job, const SvgShape* batch, int count) {
+    if (count == 0) return 1;
+
+    SDL_LockMutex(job->lock);
+    int needed = job->incoming_count + count;
+    if (needed > job->incoming_capacity) {
+        int capacity = job->incoming_capacity ? job->incoming_capacity : LOAD_BATCH;
+        while (capacity < needed) capacity *= 2;
+        SvgShape* grown = (SvgShape*)realloc(job->incoming, capacity * sizeof(SvgShape));
+        if (!grown) {
+            SDL_UnlockMutex(job->lock);
+            return 0;
+        }
+        job->incoming = grown;
+        job->incoming_capacity = capacity;
+    }
+    memcpy(job->incoming + job->incoming_count, batch, count * sizeof(SvgShape));
+    job->incoming_count = needed;
+    int wake = job->waiting;
+    job->waiting = 0;
+    SDL_UnlockMutex(job->lock);
+
+    if (wake) push_event(job, LOAD_EVENT_BATCH);
+    return 1;
+}
+
+// 按块读入文件，逐个切出完整的标签解析；跨块的标签留到下一块拼上
+static int parse_stream(LoadJob* job, FILE* f, long file_size, char* buf, SvgShape* batch) {
+    size_t len = 0;
+    long consumed = 0;
+    int count = 0;
+
+    while (!SDL_AtomicGet(&job->cancel)) {
+        size_t n = fread(buf + len, 1, 2 * LOAD_READ_SIZE - len, f);
+        if (n == 0) break;
+        len += n;
+        consumed += (long)n;
+
+        const char* p = buf;
+        const char* end = buf + len;
+        while ((p = (const char*)memchr(p, '<', end - p)) != NULL) {
+            const char* close = (const char*)memchr(p, '>', end - p);
+            if (!close) break;
+            count += parse_tag(job, p + 1, close, &batch[count]);
+            if (count == LOAD_BATCH) {
+                if (!publish(job, batch, count)) return 0;
+                count = 0;
+            }
+            p = close + 1;
+        }
+
+        size_t rest = p ? (size_t)(end - p) : 0;
+        if (rest > LOAD_READ_SIZE) rest = 0;
+        memmove(buf, p ? p : buf, rest);
+        len = rest;
+        if (file_size > 0) SDL_AtomicSet(&job->progress, (int)(consumed * 100 / file_size));
+    }
+    if (ferror(f)) return 0;
+    return publish(job, batch, count);
+}
+
+static int load_thread(void* data) {
+    LoadJob* job = (LoadJob*)data;
+    int ok = 0;
+
+    FILE* f = fopen(job->filename, "rb");
+    char* buf = (char*)malloc(2 * LOAD_READ_SIZE);
+    SvgShape* batch = (SvgShape*)malloc(LOAD_BATCH * sizeof(SvgShape));
+    if (f && buf && batch) {
+        fseek(f, 0, SEEK_END);
+        long file_size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        ok = parse_stream(job, f, file_size, buf, batch) && !SDL_AtomicGet(&job->cancel);
+    }
+    if (f) fclose(f);
+    free(buf);
+    free(batch);
+
+    SDL_LockMutex(job->lock);
+    job->ok = ok;
+    job->finished = 1;
+    SDL_UnlockMutex(job->lock);
+    push_event(job, LOAD_EVENT_DONE);
+    return 0;
+}
+
+/* ---------- 界面线程 ---------- */
+
+int load_job_start(LoadJob* job, const char* filename) {
+    if (load_job_busy(job) || !job->lock || job->event_type == (Uint32)-1) return 0;
+
+    snprintf(job->filename, sizeof(job->filename), "%s", filename);
+    SDL_AtomicSet(&job->cancel, 0);
+    SDL_AtomicSet(&job->progress, 0);
+    job->incoming_count = 0;
+    job->drain_count = job->drain_next = 0;
+    job->waiting = 1;
+    job->finished = 0;
+    job->width = job->height = 0;
+    job->ok = 0;
+    job->shapes = 0;
+
+    job->thread = SDL_CreateThread(load_thread, "svg-load", job);
+    return job->thread != NULL;
+}
+
+void load_job_cancel(LoadJob* job) {
+    SDL_AtomicSet(&job->cancel, 1);
+}
+
+int load_job_take(LoadJob* job, const SvgShape** shapes, int max, int* done) {
+    *done = 0;
+    if (job->drain_next == job->drain_count) {
+        // 当前这片用完了，与队列整体交换，锁只持有一次指针交换的时间
+        SDL_LockMutex(job->lock);
+        SvgShape* array = job->draining;
+        int capacity = job->drain_capacity;
+        job->draining = job->incoming;
+        job->drain_capacity = job->incoming_capacity;
+        job->drain_count = job->incoming_count;
+        job->drain_next = 0;
+        job->incoming = array;
+        job->incoming_capacity = capacity;
+        job->incoming_count = 0;
+        if (job->drain_count == 0) {
+            job->waiting = 1;
+            *done = job->finished;
+        }
+        SDL_UnlockMutex(job->lock);
+    }
+
+    int n = job->drain_count - job->drain_next;
+    if (n > max) n = max;
+    *shapes = job->draining + job->drain_next;
+    job->drain_next += n;
+    job->shapes += n;
+    return n;
+}
+
+int load_job_finish(LoadJob* job) {
+    if (!job->thread) return 0;
+
+    SDL_WaitThread(job->thread, NULL);
+    job->thread = NULL;
+    free(job->incoming);
+    free(job->draining);
+    job->incoming = job->draining = NULL;
+    job->incoming_count = job->incoming_capacity = 0;
+    job->drain_count = job->drain_next = job->drain_capacity = 0;
+    return job->ok;
+}
@@ -0,0 +1,260 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/svg_gui_replay.h"
+
+// 快速回放时每帧推进的轨迹时间
+#define REPLAY_FRAME_MS 16
+
+#ifdef REPLAY_COUNT_ALLOCS
+#include <stdatomic.h>
+
+// 链接时以 --wrap 把 malloc/calloc/realloc 换成下面的计数版本
+static atomic_long alloc_count;
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+void* __wrap_malloc(size_t size) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    atomic_fetch_add_explicit(&alloc_count, 1, memory_order_relaxed);
+    return __real_realloc(ptr, size);
+}
+
+long replay_allocations(void) {
+    return atomic_load_explicit(&alloc_count, memory_order_relaxed);
+}
+#else
+long replay_allocations(void) {
+    return -1;
+}
+#endif
+
+int replay_record_open(ReplaySession* session, const char* path) {
+    session->record = fopen(path, "w");
+    if (!session->record) return 0;
+    fprintf(session->record, "# svg_gui 输入轨迹: 毫秒 类型 参数\n");
+    session->record_start = SDL_GetTicks();
+    return 1;
+}
+
+void replay_record_event(ReplaySession* session, const SDL_Event* event) {
+    FILE* f = session->record;
+    if (!f) return;
+
+    Uint32 t = SDL_GetTicks() - session->record_start;
+    switch (event->type) {
+        case SDL_MOUSEBUTTONDOWN:
+        case SDL_MOUSEBUTTONUP:
+            // 界面按 SDL_GetModState() 判断 Shift 多选，一并记下
+            fprintf(f, "%u %s %d %d %d %d\n", t, event->type == SDL_MOUSEBUTTONDOWN ? "down" : "up",
+                    event->button.x, event->button.y, event->button.button, (int)SDL_GetModState());
+            break;
+        case SDL_MOUSEMOTION:
+            fprintf(f, "%u motion %d %d\n", t, event->motion.x, event->motion.y);
+            break;
+        case SDL_MOUSEWHEEL:
+            fprintf(f, "%u wheel %d\n", t, event->wheel.y);
+            break;
+        case SDL_KEYDOWN:
+            fprintf(f, "%u key %d %d\n", t, (int)event->key.keysym.sym, (int)event->key.keysym.mod);
+            break;
+    }
+}
+
+// 解析一行轨迹，成功返回 1
+static int parse_event(const char* line, ReplayEvent* out) {
+    char type[16];
+    int a = 0, b = 0, c = 0, d = 0;
+    int n = sscanf(line, "%u %15s %d %d %d %d", &out->time, type, &a, &b, &c, &d);
+    if (n < 2) return 0;
+
+    SDL_Event* e = &out->event;
+    memset(e, 0, sizeof(*e));
+    out->mod = 0;
+    if ((strcmp(type, "down") == 0 || strcmp(type, "up") == 0) && n >= 5) {
+        out->mod = (Uint16)d;
+        e->type = type[0] == 'd' ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+        e->button.x = a;
+        e->button.y = b;
+        e->button.button = (Uint8)c;
+        e->button.state = type[0] == 'd';
+        e->button.clicks = 1;
+    } else if (strcmp(type, "motion") == 0 && n >= 4) {
+        e->type = SDL_MOUSEMOTION;
+        e->motion.x = a;
+        e->motion.y = b;
+    } else if (strcmp(type, "wheel") == 0 && n >= 3) {
+        e->type = SDL_MOUSEWHEEL;
+        e->wheel.y = a;
+    } else if (strcmp(type, "key") == 0 && n >= 4) {
+        e->type = SDL_KEYDOWN;
+        e->key.keysym.sym = a;
+        e->key.keysym.mod = (Uint16)b;
+        e->key.state = 1;
+    } else {
+        return 0;
+    }
+    return 1;
+}
+
+int replay_load(ReplaySession* session, const char* path, int realtime) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        printf("无法打开轨迹文件: %s\n", path);
+        return 0;
+    }
+
+    char line[256];
+    int capacity = 0, line_no = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_no++;
+        if (line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0') continue;
+        if (session->count == capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            ReplayEvent* grown = (ReplayEvent*)realloc(session->events, capacity * sizeof(ReplayEvent));
+            if (!grown) break;
+            session->events = grown;
+        }
+        if (parse_event(line, &session->events[session->count])) {
+            session->count++;
+        } else {
+            printf("轨迹第 %d 行无法识别，已跳过\n", line_no);
+        }
+    }
+    fclose(f);
+
+    session->replaying = 1;
+    session->realtime = realtime;
+    session->start_ticks = SDL_GetTicks();
+    session->start = SDL_GetPerformanceCounter();
+    session->allocs_mark = replay_allocations();
+    return 1;
+}
+
+static int grow(void** array, int* capacity, int needed, size_t size) {
+    if (needed <= *capacity) return 1;
+    int n = *capacity ? *capacity * 2 : 1024;
+    while (n < needed) n *= 2;
+    void* grown = realloc(*array, n * size);
+    if (!grown) return 0;
+    *array = grown;
+    *capacity = n;
+    return 1;
+}
+
+int replay_pump(ReplaySession* session) {
+    if (!session->replaying || replay_done(session)) return -1;
+
+    if (session->realtime) {
+        session->clock = SDL_GetTicks() - session->start_ticks;
+    } else {
+        // 跳过空闲的时间，每帧推进一个帧间隔
+        Uint32 first = session->events[session->next].time;
+        if (session->clock < first) session->clock = first;
+        session->clock += REPLAY_FRAME_MS;
+    }
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    int pushed = 0;
+    while (!replay_done(session) && session->events[session->next].time <= session->clock) {
+        // 鼠标按键事件处理时才读全局修饰键：修饰键变化时先让已推入的事件在这一帧处理完，
+        // 下一帧再改状态并推入，保证每个点击看到录制时的修饰键
+        const ReplayEvent* next = &session->events[session->next];
+        if ((next->event.type == SDL_MOUSEBUTTONDOWN || next->event.type == SDL_MOUSEBUTTONUP) &&
+            next->mod != SDL_GetModState()) {
+            if (pushed > 0) return 0;
+            SDL_SetModState((SDL_Keymod)next->mod);
+        }
+        if (grow((void**)&session->pending, &session->pending_capacity,
+                 session->pending_count + 1, sizeof(Uint64))) {
+            session->pending[session->pending_count++] = now;
+        }
+        SDL_PushEvent(&session->events[session->next].event);
+        session->next++;
+        pushed++;
+    }
+    if (replay_done(session)) return -1;
+    return session->realtime ? (int)(session->events[session->next].time - session->clock) : 0;
+}
+
+void replay_frame(ReplaySession* session, double frame_ms) {
+    if (!session->replaying) return;
+
+    Uint64 now = SDL_GetPerformanceCounter();
+    double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+    if (grow((void**)&session->latency, &session->latency_capacity,
+             session->latency_count + session->pending_count, sizeof(double))) {
+        for (int i = 0; i < session->pending_count; i++) {
+            session->latency[session->latency_count++] = (now - session->pending[i]) / ticks_per_ms;
+        }
+    }
+    session->pending_count = 0;
+
+    // 两个数组容量相同，一起增长
+    int capacity = session->frame_capacity;
+    if (!grow((void**)&session->frame_ms, &capacity, session->frames + 1, sizeof(double))) return;
+    capacity = session->frame_capacity;
+    if (!grow((void**)&session->frame_allocs, &capacity, session->frames + 1, sizeof(double))) return;
+    session->frame_capacity = capacity;
+
+    long allocs = replay_allocations();
+    session->frame_ms[session->frames] = frame_ms;
+    session->frame_allocs[session->frames] = (double)(allocs - session->allocs_mark);
+    session->allocs_mark = allocs;
+    session->frames++;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+// 排序后输出平均、p50、p99 和最大值
+static void print_distribution(const char* label, double* values, int count, const char* unit) {
+    if (count == 0) {
+        printf("%s: 无数据\n", label);
+        return;
+    }
+    double sum = 0;
+    for (int i = 0; i < count; i++) sum += values[i];
+    qsort(values, count, sizeof(double), compare_double);
+    printf("%s: 平均 %.2f%s, p50 %.2f%s, p99 %.2f%s, 最大 %.2f%s\n", label,
+           sum / count, unit, values[count / 2], unit, values[(count * 99) / 100], unit,
+           values[count - 1], unit);
+}
+
+void replay_report(ReplaySession* session, const SvgDocument* doc) {
+    if (!session->replaying) return;
+
+    double total = (SDL_GetPerformanceCounter() - session->start) * 1000.0 / SDL_GetPerformanceFrequency();
+    printf("\n=== 回放结果 ===\n");
+    printf("事件: %d, 帧: %d, 用时 %.1f ms\n", session->next, session->frames, total);
+    print_distribution("帧耗时", session->frame_ms, session->frames, " ms");
+    print_distribution("事件到呈现延迟", session->latency, session->latency_count, " ms");
+    if (replay_allocations() < 0) {
+        printf("每帧分配: 未统计（构建时没有包装分配函数）\n");
+    } else {
+        print_distribution("每帧分配", session->frame_allocs, session->frames, "");
+    }
+    printf("文档: %d 个图形, 校验和 %016llx\n", doc->live_count, svg_document_checksum(doc));
+}
+
+void replay_free(ReplaySession* session) {
+    if (session->record) fclose(session->record);
+    free(session->events);
+    free(session->pending);
+    free(session->latency);
+    free(session->frame_ms);
+    free(session->frame_allocs);
+    memset(session, 0, sizeof(*session));
+}
@@ -3,8 +3,10 @@
 #include <string.h>
 #include <math.h>
 #include <SDL.h>
+#include "../include/image.h"
+#include "../include/svg_display_list.h"
 
-// 简化的GUI版本，不依赖TTF和libjpeg
+// 简化的GUI版本，不依赖TTF和libjpeg；图形由核心光栅化器绘制，与导出结果一致
 // 窗口设置
 #define WINDOW_WIDTH 1000
 #define WINDOW_HEIGHT 600
@@ -93,6 +95,12 @@ typedef struct {
     // 画布偏移
     int canvas_offset_x, canvas_offset_y;
 
+    // 画布：文档变化后整体重新光栅化，再一次性上传到纹理
+    DisplayList* scene;
+    Image* canvas;
+    SDL_Texture* canvas_texture;
+    int canvas_dirty;
+
 } SimpleGUIState;
 
 // 创建SVG文档
@@ -183,6 +191,17 @@ void init_gui_state(SimpleGUIState* gui) {
     gui->buttons[gui->button_count++] = (Button){ {10, 140, 180, 30}, "Rect", 0 };
     gui->buttons[gui->button_count++] = (Button){ {10, 180, 180, 30}, "Line", 0 };
     gui->buttons[gui->button_count++] = (Button){ {10, 240, 180, 30}, "Clear", 0 };
+
+    // 背景透明，网格从图形下面透出
+    gui->scene = display_list_create(CANVAS_WIDTH, CANVAS_HEIGHT);
+    gui->canvas = create_image(CANVAS_WIDTH, CANVAS_HEIGHT);
+    image_enable_alpha(gui->canvas);
+    gui->canvas_texture = SDL_CreateTexture(gui->renderer, SDL_PIXELFORMAT_RGBA32,
+                                            SDL_TEXTUREACCESS_STREAMING, CANVAS_WIDTH, CANVAS_HEIGHT);
+    if (gui->canvas_texture) {
+        SDL_SetTextureBlendMode(gui->canvas_texture, SDL_BLENDMODE_BLEND);
+    }
+    gui->canvas_dirty = 1;
 }
 
 // 绘制按钮
@@ -212,60 +231,71 @@ void draw_grid(SimpleGUIState* gui) {
     }
 }
 
-// 绘制SVG图形
-void draw_svg_shapes(SimpleGUIState* gui) {
+static RGBColor shape_rgb(int r, int g, int b) {
+    RGBColor c = {(unsigned char)r, (unsigned char)g, (unsigned char)b};
+    return c;
+}
+
+// 文档变化后重新编译显示列表、光栅化画布并上传纹理
+void update_canvas(SimpleGUIState* gui) {
+    if (!gui->canvas_dirty || !gui->scene || !gui->canvas) return;
+    gui->canvas_dirty = 0;
+
+    display_list_clear(gui->scene);
     for (int i = 0; i < gui->doc.shape_count; i++) {
         SvgShape* shape = &gui->doc.shapes[i];
-
         switch (shape->type) {
             case SVG_SHAPE_CIRCLE:
-                SDL_SetRenderDrawColor(gui->renderer,
-                                      shape->data.circle.r_color,
-                                      shape->data.circle.g_color,
-                                      shape->data.circle.b_color, 255);
-
-                // 简单的圆形绘制（使用多个小矩形近似）
-                int radius = (int)shape->data.circle.r;
-                int cx = (int)shape->data.circle.cx + gui->canvas_offset_x;
-                int cy = (int)shape->data.circle.cy + gui->canvas_offset_y;
-
-                for (int y = -radius; y <= radius; y++) {
-                    for (int x = -radius; x <= radius; x++) {
-                        if (x*x + y*y <= radius*radius) {
-                            SDL_RenderDrawPoint(gui->renderer, cx + x, cy + y);
-                        }
-                    }
-                }
+                display_list_add_circle(gui->scene, shape->data.circle.cx, shape->data.circle.cy,
+                                        shape->data.circle.r,
+                                        shape_rgb(shape->data.circle.r_color, shape->data.circle.g_color,
+                                                  shape->data.circle.b_color));
                 break;
-
             case SVG_SHAPE_RECT:
-                SDL_SetRenderDrawColor(gui->renderer,
-                                      shape->data.rect.r_color,
-                                      shape->data.rect.g_color,
-                                      shape->data.rect.b_color, 255);
-
-                SDL_Rect rect = {
-                    (int)shape->data.rect.x + gui->canvas_offset_x,
-                    (int)shape->data.rect.y + gui->canvas_offset_y,
-                    (int)shape->data.rect.width,
-                    (int)shape->data.rect.height
-                };
-                SDL_RenderFillRect(gui->renderer, &rect);
+                display_list_add_rect(gui->scene, shape->data.rect.x, shape->data.rect.y,
+                                      shape->data.rect.width, shape->data.rect.height,
+                                      shape_rgb(shape->data.rect.r_color, shape->data.rect.g_color,
+                                                shape->data.rect.b_color));
                 break;
-
             case SVG_SHAPE_LINE:
-                SDL_SetRenderDrawColor(gui->renderer,
-                                      shape->data.line.r_color,
-                                      shape->data.line.g_color,
-                                      shape->data.line.b_color, 255);
-
-                SDL_RenderDrawLine(gui->renderer,
-                                  (int)shape->data.line.x1 + gui->canvas_offset_x,
-                                  (int)shape->data.line.y1 + gui->canvas_offset_y,
-                                  (int)shape->data.line.x2 + gui->canvas_offset_x,
-                                  (int)shape->data.line.y2 + gui->canvas_offset_y);
+                display_list_add_line(gui->scene, shape->data.line.x1, shape->data.line.y1,
+                                      shape->data.line.x2, shape->data.line.y2,
+                                      shape_rgb(shape->data.line.r_color, shape->data.line.g_color,
+                                                shape->data.line.b_color));
                 break;
         }
+    }
+
+    RenderBackground clear = { {255, 255, 255}, 1 };
+    display_list_render_area(gui->scene, gui->canvas, NULL, NULL, &clear, NULL, 0);
+
+    void* pixels;
+    int pitch;
+    if (!gui->canvas_texture || SDL_LockTexture(gui->canvas_texture, NULL, &pixels, &pitch) != 0) return;
+    for (int y = 0; y < CANVAS_HEIGHT; y++) {
+        const RGBColor* src = gui->canvas->pixels + (size_t)y * CANVAS_WIDTH;
+        const unsigned char* alpha = gui->canvas->alpha + (size_t)y * CANVAS_WIDTH;
+        Uint8* dst = (Uint8*)pixels + (size_t)y * pitch;
+        for (int x = 0; x < CANVAS_WIDTH; x++) {
+            dst[4 * x + 0] = src[x].r;
+            dst[4 * x + 1] = src[x].g;
+            dst[4 * x + 2] = src[x].b;
+            dst[4 * x + 3] = alpha[x];
+        }
+    }
+    SDL_UnlockTexture(gui->canvas_texture);
+}
+
+// 绘制SVG图形：画布纹理一次贴图，再叠加选中边框
+void draw_svg_shapes(SimpleGUIState* gui) {
+    update_canvas(gui);
+    if (gui->canvas_texture) {
+        SDL_Rect canvas = {gui->canvas_offset_x, gui->canvas_offset_y, CANVAS_WIDTH, CANVAS_HEIGHT};
+        SDL_RenderCopy(gui->renderer, gui->canvas_texture, NULL, &canvas);
+    }
+
+    for (int i = 0; i < gui->doc.shape_count; i++) {
+        SvgShape* shape = &gui->doc.shapes[i];
 
         // 绘制选中边框
         if (shape->id == gui->selected_shape_id) {
@@ -348,6 +378,7 @@ void handle_mouse_click(SimpleGUIState* gui, int x, int y) {
                 case 4: // Clear
                     gui->doc.shape_count = 0;
                     gui->selected_shape_id = -1;
+                    gui->canvas_dirty = 1;
                     break;
             }
             return;
@@ -411,6 +442,7 @@ void handle_mouse_click(SimpleGUIState* gui, int x, int y) {
 
                 gui->doc.shapes[gui->doc.shape_count++] = new_shape;
                 gui->selected_shape_id = new_shape.id;
+                gui->canvas_dirty = 1;
             }
         } else if (gui->current_tool == TOOL_RECT) {
             // 添加矩形
@@ -428,6 +460,7 @@ void handle_mouse_click(SimpleGUIState* gui, int x, int y) {
 
                 gui->doc.shapes[gui->doc.shape_count++] = new_shape;
                 gui->selected_shape_id = new_shape.id;
+                gui->canvas_dirty = 1;
             }
         } else if (gui->current_tool == TOOL_LINE) {
             // 添加直线（简单的水平线）
@@ -445,6 +478,7 @@ void handle_mouse_click(SimpleGUIState* gui, int x, int y) {
 
                 gui->doc.shapes[gui->doc.shape_count++] = new_shape;
                 gui->selected_shape_id = new_shape.id;
+                gui->canvas_dirty = 1;
             }
         }
     }
@@ -521,6 +555,7 @@ int main() {
                                         shape->data.line.y2 += dy;
                                         break;
                                 }
+                                gui.canvas_dirty = 1;
                                 break;
                             }
                         }
@@ -537,6 +572,11 @@ int main() {
     }
 
     // 清理资源
+    display_list_free(gui.scene);
+    free_image(gui.canvas);
+    if (gui.canvas_texture) {
+        SDL_DestroyTexture(gui.canvas_texture);
+    }
     SDL_DestroyRenderer(gui.renderer);
     SDL_DestroyWindow(gui.window);
     SDL_Quit();
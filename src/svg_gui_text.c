@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/svg_gui_text.h"
+
+void text_cache_init(TextCache* cache, SDL_Renderer* renderer) {
+    memset(cache, 0, sizeof(*cache));
+    cache->renderer = renderer;
+}
+
+void text_cache_free(TextCache* cache) {
+    for (int i = 0; i < cache->count; i++) {
+        SDL_DestroyTexture(cache->entries[i].texture);
+        free(cache->entries[i].text);
+    }
+    for (int i = 0; i < cache->atlas_count; i++) {
+        SDL_DestroyTexture(cache->atlases[i].texture);
+    }
+    cache->count = 0;
+    cache->atlas_count = 0;
+}
+
+static int same_color(SDL_Color a, SDL_Color b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+// 渲染文字并转成纹理，返回纹理和尺寸
+static SDL_Texture* render_text(TextCache* cache, TTF_Font* font, const char* text, SDL_Color color,
+                                int* w, int* h) {
+    SDL_Surface* surface = TTF_RenderUTF8_Blended(font, text, color);
+    if (!surface) return NULL;
+
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(cache->renderer, surface);
+    *w = surface->w;
+    *h = surface->h;
+    SDL_FreeSurface(surface);
+    if (texture) cache->textures_created++;
+    return texture;
+}
+
+const TextEntry* text_cache_get(TextCache* cache, TTF_Font* font, const char* text, SDL_Color color) {
+    if (!font || !text || !text[0]) return NULL;
+    cache->clock++;
+
+    for (int i = 0; i < cache->count; i++) {
+        TextEntry* e = &cache->entries[i];
+        if (e->font == font && same_color(e->color, color) && strcmp(e->text, text) == 0) {
+            e->last_used = cache->clock;
+            return e;
+        }
+    }
+
+    // 没有命中：有空位就追加，否则替换最久未用的条目
+    TextEntry* slot;
+    if (cache->count < TEXT_CACHE_SIZE) {
+        slot = &cache->entries[cache->count++];
+    } else {
+        slot = &cache->entries[0];
+        for (int i = 1; i < TEXT_CACHE_SIZE; i++) {
+            if (cache->entries[i].last_used < slot->last_used) slot = &cache->entries[i];
+        }
+        SDL_DestroyTexture(slot->texture);
+        free(slot->text);
+    }
+
+    slot->font = font;
+    slot->color = color;
+    slot->last_used = cache->clock;
+    slot->text = strdup(text);
+    slot->texture = render_text(cache, font, text, color, &slot->w, &slot->h);
+    if (!slot->texture || !slot->text) {
+        // 失败的条目不保留，下次重新尝试
+        SDL_DestroyTexture(slot->texture);
+        free(slot->text);
+        *slot = cache->entries[--cache->count];
+        return NULL;
+    }
+    return slot;
+}
+
+void text_draw(TextCache* cache, TTF_Font* font, const char* text, SDL_Color color, int x, int y) {
+    const TextEntry* e = text_cache_get(cache, font, text, color);
+    if (!e) return;
+
+    SDL_Rect dst = { x, y, e->w, e->h };
+    SDL_RenderCopy(cache->renderer, e->texture, NULL, &dst);
+}
+
+// 取 (字体, 颜色) 的图集，没有时把整组字符渲染成一张纹理，
+// 每个字符的位置由前缀宽度得出
+static GlyphAtlas* get_atlas(TextCache* cache, TTF_Font* font, SDL_Color color) {
+    for (int i = 0; i < cache->atlas_count; i++) {
+        GlyphAtlas* a = &cache->atlases[i];
+        if (a->font == font && same_color(a->color, color)) return a->texture ? a : NULL;
+    }
+    if (cache->atlas_count >= GLYPH_ATLAS_MAX) return NULL;
+
+    GlyphAtlas* a = &cache->atlases[cache->atlas_count++];
+    int w;
+    a->font = font;
+    a->color = color;
+    a->texture = render_text(cache, font, GLYPH_ATLAS_CHARS, color, &w, &a->h);
+    if (!a->texture) return NULL;
+
+    char prefix[sizeof(GLYPH_ATLAS_CHARS)];
+    int n = (int)sizeof(GLYPH_ATLAS_CHARS) - 1;
+    a->x[0] = 0;
+    for (int i = 1; i <= n; i++) {
+        memcpy(prefix, GLYPH_ATLAS_CHARS, i);
+        prefix[i] = '\0';
+        if (TTF_SizeUTF8(font, prefix, &a->x[i], NULL) != 0) a->x[i] = a->x[i - 1];
+    }
+    return a;
+}
+
+void text_draw_dynamic(TextCache* cache, TTF_Font* font, const char* text, SDL_Color color, int x, int y) {
+    if (!font || !text || !text[0]) return;
+
+    GlyphAtlas* a = strspn(text, GLYPH_ATLAS_CHARS) == strlen(text) ? get_atlas(cache, font, color) : NULL;
+    if (!a) {
+        text_draw(cache, font, text, color, x, y);
+        return;
+    }
+
+    for (const char* p = text; *p; p++) {
+        int k = (int)(strchr(GLYPH_ATLAS_CHARS, *p) - GLYPH_ATLAS_CHARS);
+        int w = a->x[k + 1] - a->x[k];
+        SDL_Rect src = { a->x[k], 0, w, a->h };
+        SDL_Rect dst = { x, y, w, a->h };
+        SDL_RenderCopy(cache->renderer, a->texture, &src, &dst);
+        x += w;
+    }
+}
@@ -0,0 +1,222 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/svg_gui_tiles.h"
+
+void tile_cache_init(TileCache* cache, SDL_Renderer* renderer) {
+    memset(cache, 0, sizeof(*cache));
+    cache->renderer = renderer;
+}
+
+void tile_cache_free(TileCache* cache) {
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        free_image(cache->tiles[i].image);
+        if (cache->tiles[i].texture) {
+            SDL_DestroyTexture(cache->tiles[i].texture);
+        }
+    }
+    free(cache->ids);
+    memset(cache, 0, sizeof(*cache));
+}
+
+void tile_cache_invalidate_all(TileCache* cache) {
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        cache->tiles[i].stale = 1;
+    }
+}
+
+static float level_scale(int level) {
+    return ldexpf(1.0f, level);
+}
+
+// 向负无穷取整的除法，视图平移到文档左上方时瓦片编号为负
+static int floor_div(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static CanvasTile* find_tile(TileCache* cache, int level, int tx, int ty) {
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        CanvasTile* t = &cache->tiles[i];
+        if (t->used && t->level == level && t->tx == tx && t->ty == ty) return t;
+    }
+    return NULL;
+}
+
+// 把瓦片的一块区域转换成 RGBA 上传到纹理
+static void upload_tile(CanvasTile* t, const PixelRect* r) {
+    SDL_Rect rect = { r->x0, r->y0, r->x1 - r->x0, r->y1 - r->y0 };
+    void* pixels;
+    int pitch;
+    if (SDL_LockTexture(t->texture, &rect, &pixels, &pitch) != 0) return;
+
+    for (int y = 0; y < rect.h; y++) {
+        size_t row = (size_t)(r->y0 + y) * t->image->width + r->x0;
+        const RGBColor* src = t->image->pixels + row;
+        const unsigned char* alpha = t->image->alpha + row;
+        Uint8* dst = (Uint8*)pixels + (size_t)y * pitch;
+        for (int x = 0; x < rect.w; x++) {
+            dst[4 * x + 0] = src[x].r;
+            dst[4 * x + 1] = src[x].g;
+            dst[4 * x + 2] = src[x].b;
+            dst[4 * x + 3] = alpha[x];
+        }
+    }
+    SDL_UnlockTexture(t->texture);
+}
+
+// 重绘瓦片内的区域 r（瓦片像素坐标）：只光栅化索引中与它相交的图形
+static void render_tile_area(TileCache* cache, const DisplayList* dl, const SpatialGrid* grid,
+                             CanvasTile* t, const PixelRect* r) {
+    float s = level_scale(t->level);
+    float ox = (float)t->tx * TILE_SIZE, oy = (float)t->ty * TILE_SIZE;
+    DisplayListView view = { s, s, -ox, -oy };
+
+    // 多留一个像素，抵消光栅化时的取整
+    GridBox box = { (ox + r->x0 - 1) / s, (oy + r->y0 - 1) / s,
+                    (ox + r->x1 + 1) / s, (oy + r->y1 + 1) / s };
+    int count = spatial_grid_query(grid, &box, &cache->ids, &cache->id_capacity);
+    const int* ids = count < 0 ? NULL : cache->ids;
+
+    RenderBackground clear = { {255, 255, 255}, 1 };
+    display_list_render_area(dl, t->image, &view, r, &clear, ids, count);
+    upload_tile(t, r);
+}
+
+// 取一个槽位给新瓦片：优先空槽，否则换出最久未用的；本帧已用到的瓦片不换出
+static CanvasTile* alloc_tile(TileCache* cache) {
+    CanvasTile* slot = NULL;
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        CanvasTile* t = &cache->tiles[i];
+        if (!t->used) {
+            slot = t;
+            break;
+        }
+        if (t->last_used != cache->clock && (!slot || t->last_used < slot->last_used)) slot = t;
+    }
+    if (!slot) return NULL;
+
+    // 槽位的图像和纹理创建后一直复用
+    if (!slot->image) {
+        slot->image = create_image(TILE_SIZE, TILE_SIZE);
+        if (slot->image && !image_enable_alpha(slot->image)) {
+            free_image(slot->image);
+            slot->image = NULL;
+        }
+    }
+    if (slot->image && !slot->texture) {
+        slot->texture = SDL_CreateTexture(cache->renderer, SDL_PIXELFORMAT_RGBA32,
+                                          SDL_TEXTUREACCESS_STREAMING, TILE_SIZE, TILE_SIZE);
+        if (slot->texture) SDL_SetTextureBlendMode(slot->texture, SDL_BLENDMODE_BLEND);
+    }
+    if (!slot->image || !slot->texture) return NULL;
+
+    slot->used = 0;
+    return slot;
+}
+
+void tile_cache_invalidate(TileCache* cache, const DisplayList* dl, const SpatialGrid* grid,
+                           const PixelRect* area, int level) {
+    if (area->x0 >= area->x1 || area->y0 >= area->y1) return;
+
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        CanvasTile* t = &cache->tiles[i];
+        if (!t->used || t->stale) continue;
+
+        // 换算到瓦片像素坐标，多留一个像素
+        float s = level_scale(t->level);
+        PixelRect r = {
+            (int)floorf(area->x0 * s) - t->tx * TILE_SIZE - 1,
+            (int)floorf(area->y0 * s) - t->ty * TILE_SIZE - 1,
+            (int)ceilf(area->x1 * s) - t->tx * TILE_SIZE + 1,
+            (int)ceilf(area->y1 * s) - t->ty * TILE_SIZE + 1
+        };
+        if (r.x0 < 0) r.x0 = 0;
+        if (r.y0 < 0) r.y0 = 0;
+        if (r.x1 > TILE_SIZE) r.x1 = TILE_SIZE;
+        if (r.y1 > TILE_SIZE) r.y1 = TILE_SIZE;
+        if (r.x0 >= r.x1 || r.y0 >= r.y1) continue;
+
+        if (t->level == level) {
+            render_tile_area(cache, dl, grid, t, &r);
+        } else {
+            t->stale = 1;
+        }
+    }
+}
+
+// 用较粗层级已缓存的瓦片放大顶替，返回是否找到
+static int draw_fallback(TileCache* cache, int level, int tx, int ty, const SDL_Rect* dst) {
+    for (int k = 1; k <= TILE_FALLBACK_LEVELS && level - k >= TILE_MIN_LEVEL; k++) {
+        CanvasTile* p = find_tile(cache, level - k, tx >> k, ty >> k);
+        if (!p) continue;
+
+        int size = TILE_SIZE >> k;
+        SDL_Rect src = { (tx - ((tx >> k) << k)) * size, (ty - ((ty >> k) << k)) * size, size, size };
+        p->last_used = cache->clock;
+        SDL_RenderCopy(cache->renderer, p->texture, &src, dst);
+        return 1;
+    }
+    return 0;
+}
+
+int tile_cache_draw(TileCache* cache, const DisplayList* dl, const SpatialGrid* grid,
+                    int level, int origin_x, int origin_y, const SDL_Rect* dst, double budget_ms) {
+    float s = level_scale(level);
+    int doc_w = (int)ceilf(dl->width * s), doc_h = (int)ceilf(dl->height * s);
+    int tx0 = floor_div(origin_x, TILE_SIZE), tx1 = floor_div(origin_x + dst->w - 1, TILE_SIZE);
+    int ty0 = floor_div(origin_y, TILE_SIZE), ty1 = floor_div(origin_y + dst->h - 1, TILE_SIZE);
+    if (tx0 < 0) tx0 = 0;
+    if (ty0 < 0) ty0 = 0;
+    if (tx1 > (doc_w - 1) / TILE_SIZE) tx1 = (doc_w - 1) / TILE_SIZE;
+    if (ty1 > (doc_h - 1) / TILE_SIZE) ty1 = (doc_h - 1) / TILE_SIZE;
+
+    Uint64 start = SDL_GetPerformanceCounter();
+    double ticks_per_ms = SDL_GetPerformanceFrequency() / 1000.0;
+    int rendered = 0, missing = 0;
+    cache->clock++;
+
+    // 先标记本帧可见的瓦片，补画时不会把它们换出
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            CanvasTile* t = find_tile(cache, level, tx, ty);
+            if (t) t->last_used = cache->clock;
+        }
+    }
+
+    for (int ty = ty0; ty <= ty1; ty++) {
+        for (int tx = tx0; tx <= tx1; tx++) {
+            SDL_Rect rect = { dst->x + tx * TILE_SIZE - origin_x, dst->y + ty * TILE_SIZE - origin_y,
+                              TILE_SIZE, TILE_SIZE };
+            CanvasTile* t = find_tile(cache, level, tx, ty);
+
+            if (!t || t->stale) {
+                int in_budget = rendered == 0 ||
+                                (SDL_GetPerformanceCounter() - start) / ticks_per_ms < budget_ms;
+                CanvasTile* slot = !in_budget ? NULL : t ? t : alloc_tile(cache);
+                if (slot) {
+                    PixelRect full = { 0, 0, TILE_SIZE, TILE_SIZE };
+                    slot->level = level;
+                    slot->tx = tx;
+                    slot->ty = ty;
+                    render_tile_area(cache, dl, grid, slot, &full);
+                    slot->used = 1;
+                    slot->stale = 0;
+                    slot->last_used = cache->clock;
+                    cache->rendered++;
+                    rendered++;
+                    t = slot;
+                } else {
+                    missing++;
+                }
+            }
+
+            // 过期的瓦片在重绘前照常显示
+            if (t) {
+                SDL_RenderCopy(cache->renderer, t->texture, NULL, &rect);
+            } else {
+                draw_fallback(cache, level, tx, ty, &rect);
+            }
+        }
+    }
+    return missing;
+}
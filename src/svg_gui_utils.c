@@ -1,22 +1,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "../include/svg_gui_types.h"
 #include "../include/image.h"
 #include "../include/bmp_writer.h"
 #include "../include/jpg_writer.h"
-
-// 创建SVG文档
-SvgDocument* create_svg_document(double width, double height) {
-    SvgDocument* doc = (SvgDocument*)malloc(sizeof(SvgDocument));
-    if (!doc) return NULL;
-
-    doc->width = width;
-    doc->height = height;
-    doc->shape_count = 0;
-
-    return doc;
-}
+#include "../include/svg_display_list.h"
 
 // 解析颜色字符串
 unsigned int parse_color(const char* color_str) {
@@ -51,169 +41,121 @@ void color_to_rgb(unsigned int color, int* r, int* g, int* b) {
     *b = color & 0xFF;
 }
 
-// 渲染SVG到Image
-int render_svg_to_image(SvgDocument* doc, Image* img) {
-    if (!doc || !img) return 0;
+static RGBColor shape_color(const char* color_str) {
+    int r, g, b;
+    color_to_rgb(parse_color(color_str), &r, &g, &b);
+    RGBColor c = {(unsigned char)r, (unsigned char)g, (unsigned char)b};
+    return c;
+}
 
-    // 初始化图像为白色背景
-    for (int y = 0; y < img->height; y++) {
-        for (int x = 0; x < img->width; x++) {
-            img->pixels[y * img->width + x].r = 255;
-            img->pixels[y * img->width + x].g = 255;
-            img->pixels[y * img->width + x].b = 255;
-        }
+// 图形对应的绘制命令（文档坐标）
+void svg_shape_command(const SvgShape* shape, RenderPrimitive* cmd) {
+    memset(cmd, 0, sizeof(*cmd));
+    if (!svg_shape_alive(shape)) return;
+
+    switch (shape->type) {
+        case SVG_SHAPE_CIRCLE:
+            cmd->kind = PRIM_CIRCLE;
+            cmd->p[0] = shape->data.circle.cx;
+            cmd->p[1] = shape->data.circle.cy;
+            cmd->p[2] = shape->data.circle.r;
+            cmd->color = shape_color(shape->data.circle.fill);
+            break;
+        case SVG_SHAPE_RECT:
+            cmd->kind = PRIM_RECT;
+            cmd->p[0] = shape->data.rect.x;
+            cmd->p[1] = shape->data.rect.y;
+            cmd->p[2] = shape->data.rect.width;
+            cmd->p[3] = shape->data.rect.height;
+            cmd->color = shape_color(shape->data.rect.fill);
+            break;
+        case SVG_SHAPE_LINE:
+            cmd->kind = PRIM_LINE;
+            cmd->p[0] = shape->data.line.x1;
+            cmd->p[1] = shape->data.line.y1;
+            cmd->p[2] = shape->data.line.x2;
+            cmd->p[3] = shape->data.line.y2;
+            cmd->color = shape_color(shape->data.line.stroke);
+            break;
     }
+    primitive_compute_bounds(cmd);
+}
+
+// 把文档编译成显示列表，与命令行版本共用同一套光栅化。
+// 命令编号与槽位一一对应
+DisplayList* compile_svg_document(SvgDocument* doc) {
+    DisplayList* dl = display_list_create(doc->width, doc->height);
+    if (!dl) return NULL;
 
-    // 渲染所有图形
     for (int i = 0; i < doc->shape_count; i++) {
-        SvgShape* shape = &doc->shapes[i];
-        unsigned int color = 0;
-        int r, g, b;
-
-        switch (shape->type) {
-            case SVG_SHAPE_CIRCLE:
-                color = parse_color(shape->data.circle.fill);
-                color_to_rgb(color, &r, &g, &b);
-
-                // 简单的圆形绘制算法（中点圆算法）
-                {
-                    int cx = (int)shape->data.circle.cx;
-                    int cy = (int)shape->data.circle.cy;
-                    int radius = (int)shape->data.circle.r;
-
-                    for (int y = -radius; y <= radius; y++) {
-                        for (int x = -radius; x <= radius; x++) {
-                            if (x*x + y*y <= radius*radius) {
-                                int px = cx + x;
-                                int py = cy + y;
-                                if (px >= 0 && px < img->width && py >= 0 && py < img->height) {
-                                    img->pixels[py * img->width + px].r = r;
-                                    img->pixels[py * img->width + px].g = g;
-                                    img->pixels[py * img->width + px].b = b;
-                                }
-                            }
-                        }
-                    }
-                }
-                break;
-
-            case SVG_SHAPE_RECT:
-                color = parse_color(shape->data.rect.fill);
-                color_to_rgb(color, &r, &g, &b);
-
-                // 绘制矩形
-                {
-                    int x1 = (int)shape->data.rect.x;
-                    int y1 = (int)shape->data.rect.y;
-                    int x2 = x1 + (int)shape->data.rect.width;
-                    int y2 = y1 + (int)shape->data.rect.height;
-
-                    for (int y = y1; y < y2 && y < img->height; y++) {
-                        if (y < 0) continue;
-                        for (int x = x1; x < x2 && x < img->width; x++) {
-                            if (x < 0) continue;
-                            img->pixels[y * img->width + x].r = r;
-                            img->pixels[y * img->width + x].g = g;
-                            img->pixels[y * img->width + x].b = b;
-                        }
-                    }
-                }
-                break;
-
-            case SVG_SHAPE_LINE:
-                color = parse_color(shape->data.line.stroke);
-                color_to_rgb(color, &r, &g, &b);
-
-                // Bresenham直线算法
-                {
-                    int x1 = (int)shape->data.line.x1;
-                    int y1 = (int)shape->data.line.y1;
-                    int x2 = (int)shape->data.line.x2;
-                    int y2 = (int)shape->data.line.y2;
-
-                    int dx = abs(x2 - x1);
-                    int dy = abs(y2 - y1);
-                    int sx = x1 < x2 ? 1 : -1;
-                    int sy = y1 < y2 ? 1 : -1;
-                    int err = dx - dy;
-
-                    while (1) {
-                        if (x1 >= 0 && x1 < img->width && y1 >= 0 && y1 < img->height) {
-                            img->pixels[y1 * img->width + x1].r = r;
-                            img->pixels[y1 * img->width + x1].g = g;
-                            img->pixels[y1 * img->width + x1].b = b;
-                        }
-
-                        if (x1 == x2 && y1 == y2) break;
-
-                        int e2 = 2 * err;
-                        if (e2 > -dy) {
-                            err -= dy;
-                            x1 += sx;
-                        }
-                        if (e2 < dx) {
-                            err += dx;
-                            y1 += sy;
-                        }
-                    }
-                }
-                break;
+        RenderPrimitive cmd;
+        svg_shape_command(svg_document_shape(doc, i), &cmd);
+        if (!display_list_push(dl, &cmd)) {
+            display_list_free(dl);
+            return NULL;
         }
     }
 
-    return 1;
+    return dl;
 }
 
-// 导出到BMP
-int export_to_bmp(SvgDocument* doc, const char* filename) {
-    if (!doc || !filename) return 0;
-
-    // 创建图像
-    Image img;
-    img.width = (int)doc->width;
-    img.height = (int)doc->height;
-    img.pixels = (RGBColor*)malloc(img.width * img.height * sizeof(RGBColor));
-    if (!img.pixels) return 0;
-
-    // 渲染SVG到图像
-    if (!render_svg_to_image(doc, &img)) {
-        free(img.pixels);
-        return 0;
-    }
+// 渲染SVG到Image
+int render_svg_to_image(SvgDocument* doc, Image* img) {
+    if (!doc || !img) return 0;
 
-    // 保存为BMP
-    write_bmp(filename, &img);
-    int result = 1; // 假设成功
+    DisplayList* dl = compile_svg_document(doc);
+    if (!dl) return 0;
 
-    // 清理
-    free(img.pixels);
+    // 白色背景，按图像尺寸缩放整个文档
+    DisplayListView view = display_list_view_fit(dl, img->width, img->height);
+    display_list_render(dl, img, &view, NULL);
 
-    return result;
+    display_list_free(dl);
+    return 1;
 }
 
-// 导出到JPG
-int export_to_jpg(SvgDocument* doc, const char* filename) {
-    if (!doc || !filename) return 0;
+// 条带高度：整幅按条带渲染，每条带后报告一次进度
+#define EXPORT_BAND_HEIGHT 64
 
-    // 创建图像
-    Image img;
-    img.width = (int)doc->width;
-    img.height = (int)doc->height;
-    img.pixels = (RGBColor*)malloc(img.width * img.height * sizeof(RGBColor));
-    if (!img.pixels) return 0;
+int export_svg_document(SvgDocument* doc, const char* filename, SvgExportFormat format,
+                        SvgExportProgress progress, void* ctx) {
+    if (!doc || !filename) return 0;
 
-    // 渲染SVG到图像
-    if (!render_svg_to_image(doc, &img)) {
-        free(img.pixels);
+    Image* img = create_image((int)doc->width, (int)doc->height);
+    if (!img) return 0;
+    DisplayList* dl = compile_svg_document(doc);
+    if (!dl) {
+        free_image(img);
         return 0;
     }
 
-    // 保存为JPG
-    write_jpg(filename, &img, 90); // 90% quality
-    int result = 1; // 假设成功
+    // 各条带的结果与整幅回放逐像素一致，最后一步为编码
+    DisplayListView view = display_list_view_fit(dl, img->width, img->height);
+    int bands = (img->height + EXPORT_BAND_HEIGHT - 1) / EXPORT_BAND_HEIGHT;
+    for (int b = 0; b < bands; b++) {
+        PixelRect band = { 0, b * EXPORT_BAND_HEIGHT, img->width, (b + 1) * EXPORT_BAND_HEIGHT };
+        display_list_render_area(dl, img, &view, &band, NULL, NULL, 0);
+        if (progress) progress(ctx, b + 1, bands + 1);
+    }
+    display_list_free(dl);
+
+    if (format == SVG_EXPORT_JPG) {
+        write_jpg(filename, img, 90); // 90% quality
+    } else {
+        write_bmp(filename, img);
+    }
+    if (progress) progress(ctx, bands + 1, bands + 1);
 
-    // 清理
-    free(img.pixels);
+    free_image(img);
+    return 1;
+}
+
+// 导出到BMP
+int export_to_bmp(SvgDocument* doc, const char* filename) {
+    return export_svg_document(doc, filename, SVG_EXPORT_BMP, NULL, NULL);
+}
 
-    return result;
-}
\ No newline at end of file
+// 导出到JPG
+int export_to_jpg(SvgDocument* doc, const char* filename) {
+    return export_svg_document(doc, filename, SVG_EXPORT_JPG, NULL, NULL);
+}
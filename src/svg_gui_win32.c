@@ -4,6 +4,7 @@
 #include <math.h>
 #include <windows.h>
 #include <windowsx.h>
+#include "../include/svg_writer.h"
 
 // 窗口设置
 #define WINDOW_WIDTH 1000
@@ -450,45 +451,55 @@ void export_svg(Win32GUI* gui) {
     ofn.lpstrDefExt = "svg";
 
     if (GetSaveFileName(&ofn)) {
-        FILE* file = fopen(filename, "w");
-        if (file) {
-            fprintf(file, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-            fprintf(file, "<svg width=\"%.0f\" height=\"%.0f\" xmlns=\"http://www.w3.org/2000/svg\">\n",
-                    gui->doc.width, gui->doc.height);
+        SvgWriter w;
+        if (svg_writer_open(&w, filename)) {
+            char color[8];
+            svg_writer_str(&w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<svg");
+            svg_writer_attr(&w, "width", gui->doc.width);
+            svg_writer_attr(&w, "height", gui->doc.height);
+            svg_writer_str(&w, " xmlns=\"http://www.w3.org/2000/svg\">\n");
 
             for (int i = 0; i < gui->doc.shape_count; i++) {
                 SvgShape* shape = &gui->doc.shapes[i];
 
                 switch (shape->type) {
                     case SVG_SHAPE_CIRCLE:
-                        fprintf(file, "  <circle cx=\"%.1f\" cy=\"%.1f\" r=\"%.1f\" fill=\"#%02X%02X%02X\"/>\n",
-                                shape->data.circle.cx, shape->data.circle.cy, shape->data.circle.r,
-                                GetRValue(shape->data.circle.color),
-                                GetGValue(shape->data.circle.color),
-                                GetBValue(shape->data.circle.color));
+                        sprintf(color, "#%02X%02X%02X", GetRValue(shape->data.circle.color),
+                                GetGValue(shape->data.circle.color), GetBValue(shape->data.circle.color));
+                        svg_writer_str(&w, "  <circle");
+                        svg_writer_attr(&w, "cx", shape->data.circle.cx);
+                        svg_writer_attr(&w, "cy", shape->data.circle.cy);
+                        svg_writer_attr(&w, "r", shape->data.circle.r);
+                        svg_writer_attr_str(&w, "fill", color);
                         break;
                     case SVG_SHAPE_RECT:
-                        fprintf(file, "  <rect x=\"%.1f\" y=\"%.1f\" width=\"%.1f\" height=\"%.1f\" fill=\"#%02X%02X%02X\"/>\n",
-                                shape->data.rect.x, shape->data.rect.y,
-                                shape->data.rect.width, shape->data.rect.height,
-                                GetRValue(shape->data.rect.color),
-                                GetGValue(shape->data.rect.color),
-                                GetBValue(shape->data.rect.color));
+                        sprintf(color, "#%02X%02X%02X", GetRValue(shape->data.rect.color),
+                                GetGValue(shape->data.rect.color), GetBValue(shape->data.rect.color));
+                        svg_writer_str(&w, "  <rect");
+                        svg_writer_attr(&w, "x", shape->data.rect.x);
+                        svg_writer_attr(&w, "y", shape->data.rect.y);
+                        svg_writer_attr(&w, "width", shape->data.rect.width);
+                        svg_writer_attr(&w, "height", shape->data.rect.height);
+                        svg_writer_attr_str(&w, "fill", color);
                         break;
                     case SVG_SHAPE_LINE:
-                        fprintf(file, "  <line x1=\"%.1f\" y1=\"%.1f\" x2=\"%.1f\" y2=\"%.1f\" stroke=\"#%02X%02X%02X\" stroke-width=\"2\"/>\n",
-                                shape->data.line.x1, shape->data.line.y1,
-                                shape->data.line.x2, shape->data.line.y2,
-                                GetRValue(shape->data.line.color),
-                                GetGValue(shape->data.line.color),
-                                GetBValue(shape->data.line.color));
+                        sprintf(color, "#%02X%02X%02X", GetRValue(shape->data.line.color),
+                                GetGValue(shape->data.line.color), GetBValue(shape->data.line.color));
+                        svg_writer_str(&w, "  <line");
+                        svg_writer_attr(&w, "x1", shape->data.line.x1);
+                        svg_writer_attr(&w, "y1", shape->data.line.y1);
+                        svg_writer_attr(&w, "x2", shape->data.line.x2);
+                        svg_writer_attr(&w, "y2", shape->data.line.y2);
+                        svg_writer_attr_str(&w, "stroke", color);
+                        svg_writer_str(&w, " stroke-width=\"2\"");
                         break;
                 }
+                svg_writer_str(&w, "/>\n");
             }
 
-            fprintf(file, "</svg>\n");
-            fclose(file);
-
+            svg_writer_str(&w, "</svg>\n");
+        }
+        if (svg_writer_close(&w)) {
             char status[256];
             sprintf(status, "已导出到文件: %s", filename);
             update_status(gui, status);
@@ -0,0 +1,416 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/svg_journal.h"
+
+#define RECORD_ALIGN 8
+#define JOURNAL_INITIAL_BYTES 4096
+#define JOURNAL_INITIAL_RECORDS 256
+
+// 各类记录的内容，都以 op 开头
+typedef struct {
+    int op, id;
+    double dx, dy;
+} MoveRecord;
+
+typedef struct {
+    int op, id;
+    SvgShape before, after;
+} ChangeRecord;
+
+typedef struct {
+    int op, id, slot;
+} DeleteRecord;
+
+// 重做插入时原槽位可能已经不在（中间撤销过整体操作），按内容重新放回
+typedef struct {
+    int op, slot;
+    SvgShape shape;
+} InsertRecord;
+
+// 批量记录的定长部分，后面紧跟各自的数组
+typedef struct {
+    int op, count;
+    double dx, dy;          // 之后是 int ids[count]
+} MoveManyRecord;
+
+typedef struct {
+    int op, count;
+    ShapeEdit edit;         // 之后是 SvgShape before[count]
+} EditManyRecord;
+
+typedef struct {
+    int op, count;          // 之后是 int ids[count], slots[count]
+} DeleteManyRecord;
+
+typedef struct {
+    int op;
+    SvgDocument* before;
+    SvgDocument* after;
+    size_t bytes;           // 计入预算的快照内存
+} ResetRecord;
+
+void journal_init(SvgJournal* j, size_t budget) {
+    memset(j, 0, sizeof(*j));
+    j->budget = budget;
+}
+
+static void* record_at(const SvgJournal* j, int i) {
+    return j->data + j->offsets[i];
+}
+
+static int record_op(const SvgJournal* j, int i) {
+    return *(const int*)record_at(j, i);
+}
+
+static void release_record(SvgJournal* j, int i) {
+    if (record_op(j, i) != JOURNAL_RESET) return;
+    ResetRecord* r = (ResetRecord*)record_at(j, i);
+    free_svg_document(r->before);
+    free_svg_document(r->after);
+    j->snapshot_bytes -= r->bytes;
+}
+
+// 丢弃第 first 条及之后的记录
+static void truncate_records(SvgJournal* j, int first) {
+    for (int i = first; i < j->count; i++) {
+        release_record(j, i);
+    }
+    if (first < j->count) j->size = j->offsets[first];
+    j->count = first;
+    if (j->cursor > first) j->cursor = first;
+}
+
+void journal_clear(SvgJournal* j) {
+    truncate_records(j, 0);
+    j->open_move = 0;
+}
+
+void journal_free(SvgJournal* j) {
+    journal_clear(j);
+    free(j->data);
+    free(j->offsets);
+    free(j->touched);
+    memset(j, 0, sizeof(*j));
+}
+
+void journal_seal(SvgJournal* j) {
+    j->open_move = 0;
+}
+
+static size_t journal_bytes(const SvgJournal* j) {
+    return j->size + (size_t)j->count * sizeof(size_t) + j->snapshot_bytes;
+}
+
+// 超出预算时丢弃最早的一批记录，降到预算的四分之三，减少整体搬移的次数
+static void trim(SvgJournal* j) {
+    size_t bytes = journal_bytes(j);
+    if (bytes <= j->budget) return;
+
+    size_t target = j->budget / 4 * 3;
+    int drop = 0;
+    while (drop < j->count - 1 && bytes > target) {
+        bytes -= j->offsets[drop + 1] - j->offsets[drop] + sizeof(size_t);
+        if (record_op(j, drop) == JOURNAL_RESET) bytes -= ((ResetRecord*)record_at(j, drop))->bytes;
+        release_record(j, drop);
+        drop++;
+    }
+    if (drop == 0) return;
+
+    size_t base = j->offsets[drop];
+    memmove(j->data, j->data + base, j->size - base);
+    j->size -= base;
+    for (int i = drop; i < j->count; i++) {
+        j->offsets[i - drop] = j->offsets[i] - base;
+    }
+    j->count -= drop;
+    j->cursor -= drop;
+}
+
+// 丢弃可重做的记录后追加一条，返回其内容；失败时清空日志，
+// 避免之后的撤销作用在与记录对不上的文档上
+static void* append(SvgJournal* j, JournalOp op, size_t size) {
+    truncate_records(j, j->cursor);
+    j->open_move = 0;
+    size = (size + RECORD_ALIGN - 1) & ~(size_t)(RECORD_ALIGN - 1);
+
+    if (j->size + size > j->capacity) {
+        size_t capacity = j->capacity ? j->capacity * 2 : JOURNAL_INITIAL_BYTES;
+        while (capacity < j->size + size) capacity *= 2;
+        unsigned char* data = (unsigned char*)realloc(j->data, capacity);
+        if (!data) {
+            journal_clear(j);
+            return NULL;
+        }
+        j->data = data;
+        j->capacity = capacity;
+    }
+    if (j->count == j->offset_capacity) {
+        int capacity = j->offset_capacity ? j->offset_capacity * 2 : JOURNAL_INITIAL_RECORDS;
+        size_t* offsets = (size_t*)realloc(j->offsets, capacity * sizeof(size_t));
+        if (!offsets) {
+            journal_clear(j);
+            return NULL;
+        }
+        j->offsets = offsets;
+        j->offset_capacity = capacity;
+    }
+
+    void* rec = j->data + j->size;
+    j->offsets[j->count++] = j->size;
+    j->size += size;
+    j->cursor = j->count;
+    *(int*)rec = op;
+    return rec;
+}
+
+int journal_move(SvgJournal* j, int id, double dx, double dy) {
+    if (j->open_move && j->cursor == j->count && j->count > 0 &&
+        record_op(j, j->count - 1) == JOURNAL_MOVE) {
+        MoveRecord* last = (MoveRecord*)record_at(j, j->count - 1);
+        if (last->id == id) {
+            last->dx += dx;
+            last->dy += dy;
+            return 1;
+        }
+    }
+
+    MoveRecord* r = (MoveRecord*)append(j, JOURNAL_MOVE, sizeof(MoveRecord));
+    if (!r) return 0;
+    r->id = id;
+    r->dx = dx;
+    r->dy = dy;
+    j->open_move = 1;
+    trim(j);
+    return 1;
+}
+
+int journal_move_many(SvgJournal* j, const int* ids, int count, double dx, double dy) {
+    size_t size = sizeof(MoveManyRecord) + (size_t)count * sizeof(int);
+
+    // 拖动一批图形时每次移动的 ID 列表相同，合并到上一条
+    if (j->open_move && j->cursor == j->count && j->count > 0 &&
+        record_op(j, j->count - 1) == JOURNAL_MOVE_MANY) {
+        MoveManyRecord* last = (MoveManyRecord*)record_at(j, j->count - 1);
+        if (last->count == count && memcmp(last + 1, ids, count * sizeof(int)) == 0) {
+            last->dx += dx;
+            last->dy += dy;
+            return 1;
+        }
+    }
+
+    MoveManyRecord* r = (MoveManyRecord*)append(j, JOURNAL_MOVE_MANY, size);
+    if (!r) return 0;
+    r->count = count;
+    r->dx = dx;
+    r->dy = dy;
+    memcpy(r + 1, ids, count * sizeof(int));
+    j->open_move = 1;
+    trim(j);
+    return 1;
+}
+
+int journal_edit_many(SvgJournal* j, const SvgShape* before, int count, const ShapeEdit* edit) {
+    EditManyRecord* r = (EditManyRecord*)append(j, JOURNAL_EDIT_MANY,
+                                                sizeof(EditManyRecord) + (size_t)count * sizeof(SvgShape));
+    if (!r) return 0;
+    r->count = count;
+    r->edit = *edit;
+    memcpy(r + 1, before, count * sizeof(SvgShape));
+    trim(j);
+    return 1;
+}
+
+int journal_delete_many(SvgJournal* j, const int* ids, const int* slots, int count) {
+    DeleteManyRecord* r = (DeleteManyRecord*)append(j, JOURNAL_DELETE_MANY,
+                                                    sizeof(DeleteManyRecord) + (size_t)count * 2 * sizeof(int));
+    if (!r) return 0;
+    r->count = count;
+    memcpy(r + 1, ids, count * sizeof(int));
+    memcpy((int*)(r + 1) + count, slots, count * sizeof(int));
+    trim(j);
+    return 1;
+}
+
+int journal_change(SvgJournal* j, const SvgShape* before, const SvgShape* after) {
+    ChangeRecord* r = (ChangeRecord*)append(j, JOURNAL_CHANGE, sizeof(ChangeRecord));
+    if (!r) return 0;
+    r->id = before->id;
+    r->before = *before;
+    r->after = *after;
+    trim(j);
+    return 1;
+}
+
+int journal_insert(SvgJournal* j, const SvgShape* shape, int slot) {
+    InsertRecord* r = (InsertRecord*)append(j, JOURNAL_INSERT, sizeof(InsertRecord));
+    if (!r) return 0;
+    r->slot = slot;
+    r->shape = *shape;
+    trim(j);
+    return 1;
+}
+
+int journal_delete(SvgJournal* j, int id, int slot) {
+    DeleteRecord* r = (DeleteRecord*)append(j, JOURNAL_DELETE, sizeof(DeleteRecord));
+    if (!r) return 0;
+    r->id = id;
+    r->slot = slot;
+    trim(j);
+    return 1;
+}
+
+int journal_reset(SvgJournal* j, SvgDocument* before, const SvgDocument* doc) {
+    SvgDocument* after = before ? svg_document_snapshot(doc) : NULL;
+    ResetRecord* r = after ? (ResetRecord*)append(j, JOURNAL_RESET, sizeof(ResetRecord)) : NULL;
+    if (!r) {
+        free_svg_document(before);
+        free_svg_document(after);
+        journal_clear(j);
+        return 0;
+    }
+
+    // 操作后的快照与文档共享块，只有操作前的内容算作额外占用
+    r->before = before;
+    r->after = after;
+    r->bytes = (size_t)before->shape_count * sizeof(SvgShape);
+    j->snapshot_bytes += r->bytes;
+    trim(j);
+    return 1;
+}
+
+int journal_compact(SvgJournal* j, SvgDocument* doc, int force) {
+    SvgDocument* before = svg_document_snapshot(doc);
+    if (!svg_document_compact(doc, force)) {
+        free_svg_document(before);
+        return 0;
+    }
+    journal_reset(j, before, doc);
+    return 1;
+}
+
+// 记下改动的槽位，内存不足时返回 0
+static int touch(SvgJournal* j, int slot) {
+    if (j->touched_count == j->touched_capacity) {
+        int capacity = j->touched_capacity ? j->touched_capacity * 2 : 64;
+        int* touched = (int*)realloc(j->touched, capacity * sizeof(int));
+        if (!touched) return 0;
+        j->touched = touched;
+        j->touched_capacity = capacity;
+    }
+    j->touched[j->touched_count++] = slot;
+    return 1;
+}
+
+// 按 ID 找到图形准备修改，并记下它的槽位
+static SvgShape* edit_by_id(SvgJournal* j, SvgDocument* doc, int id) {
+    int s = svg_document_find(doc, id);
+    SvgShape* shape = s < 0 ? NULL : svg_document_edit(doc, s);
+    return shape && touch(j, s) ? shape : NULL;
+}
+
+// 撤销删除时墓碑里还是删除前的内容，恢复 ID 即可
+static int revive(SvgJournal* j, SvgDocument* doc, int id, int slot) {
+    if (slot >= doc->shape_count) return 0;
+    SvgShape shape = *svg_document_shape(doc, slot);
+    shape.id = id;
+    return svg_document_restore(doc, slot, &shape) >= 0 && touch(j, slot);
+}
+
+static int remove_id(SvgJournal* j, SvgDocument* doc, int id) {
+    int s = svg_document_remove(doc, id);
+    return s >= 0 && touch(j, s);
+}
+
+// 应用第 i 条记录（undo 时反向），单条失败返回 0。
+// 批量记录里个别图形失败时跳过，其余照常应用
+static int apply(SvgJournal* j, SvgDocument* doc, int i, int undo) {
+    int op = record_op(j, i);
+    double sign = undo ? -1.0 : 1.0;
+    switch (op) {
+        case JOURNAL_MOVE: {
+            const MoveRecord* r = (const MoveRecord*)record_at(j, i);
+            SvgShape* shape = edit_by_id(j, doc, r->id);
+            if (!shape) return 0;
+            svg_shape_translate(shape, sign * r->dx, sign * r->dy);
+            return 1;
+        }
+        case JOURNAL_CHANGE: {
+            const ChangeRecord* r = (const ChangeRecord*)record_at(j, i);
+            SvgShape* shape = edit_by_id(j, doc, r->id);
+            if (!shape) return 0;
+            *shape = undo ? r->before : r->after;
+            return 1;
+        }
+        case JOURNAL_INSERT: {
+            const InsertRecord* r = (const InsertRecord*)record_at(j, i);
+            if (undo) return remove_id(j, doc, r->shape.id);
+            return svg_document_restore(doc, r->slot, &r->shape) >= 0 && touch(j, r->slot);
+        }
+        case JOURNAL_DELETE: {
+            const DeleteRecord* r = (const DeleteRecord*)record_at(j, i);
+            return undo ? revive(j, doc, r->id, r->slot) : remove_id(j, doc, r->id);
+        }
+        case JOURNAL_MOVE_MANY: {
+            const MoveManyRecord* r = (const MoveManyRecord*)record_at(j, i);
+            const int* ids = (const int*)(r + 1);
+            for (int k = 0; k < r->count; k++) {
+                SvgShape* shape = edit_by_id(j, doc, ids[k]);
+                if (shape) svg_shape_translate(shape, sign * r->dx, sign * r->dy);
+            }
+            return 1;
+        }
+        case JOURNAL_EDIT_MANY: {
+            const EditManyRecord* r = (const EditManyRecord*)record_at(j, i);
+            const SvgShape* before = (const SvgShape*)(r + 1);
+            for (int k = 0; k < r->count; k++) {
+                SvgShape* shape = edit_by_id(j, doc, before[k].id);
+                if (!shape) continue;
+                if (undo) {
+                    *shape = before[k];
+                } else {
+                    shape_edit_apply(shape, &r->edit);
+                }
+            }
+            return 1;
+        }
+        case JOURNAL_DELETE_MANY: {
+            const DeleteManyRecord* r = (const DeleteManyRecord*)record_at(j, i);
+            const int* ids = (const int*)(r + 1);
+            const int* slots = ids + r->count;
+            for (int k = 0; k < r->count; k++) {
+                if (undo) {
+                    revive(j, doc, ids[k], slots[k]);
+                } else {
+                    remove_id(j, doc, ids[k]);
+                }
+            }
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 整体操作回退到快照，其它记录逐个槽位应用
+static JournalResult step(SvgJournal* j, SvgDocument* doc, int i, int undo) {
+    j->open_move = 0;
+    j->touched_count = 0;
+    if (record_op(j, i) == JOURNAL_RESET) {
+        const ResetRecord* r = (const ResetRecord*)record_at(j, i);
+        return svg_document_revert(doc, undo ? r->before : r->after) ? JOURNAL_ALL : JOURNAL_NOTHING;
+    }
+    return apply(j, doc, i, undo) ? JOURNAL_SLOTS : JOURNAL_NOTHING;
+}
+
+JournalResult journal_undo(SvgJournal* j, SvgDocument* doc) {
+    if (!journal_can_undo(j)) return JOURNAL_NOTHING;
+    JournalResult result = step(j, doc, j->cursor - 1, 1);
+    if (result != JOURNAL_NOTHING) j->cursor--;
+    return result;
+}
+
+JournalResult journal_redo(SvgJournal* j, SvgDocument* doc) {
+    if (!journal_can_redo(j)) return JOURNAL_NOTHING;
+    JournalResult result = step(j, doc, j->cursor, 0);
+    if (result != JOURNAL_NOTHING) j->cursor++;
+    return result;
+}
@@ -0,0 +1,332 @@
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "../include/svg_raster.h"
+
+static int clip_is_empty(const PixelRect *r)
+{
+    return r->x0 >= r->x1 || r->y0 >= r->y1;
+}
+
+// 求两个像素矩形的交集
+static PixelRect rect_intersect(const PixelRect *a, const PixelRect *b)
+{
+    PixelRect r;
+    r.x0 = a->x0 > b->x0 ? a->x0 : b->x0;
+    r.y0 = a->y0 > b->y0 ? a->y0 : b->y0;
+    r.x1 = a->x1 < b->x1 ? a->x1 : b->x1;
+    r.y1 = a->y1 < b->y1 ? a->y1 : b->y1;
+    return r;
+}
+
+// 填充一行 [x0, x1)，调用者保证已裁剪
+static void fill_span(Image *img, int y, int x0, int x1, RGBColor color)
+{
+    image_fill_span(img, y, x0, x1, color);
+}
+
+// 只填充掩码中尚未覆盖的像素，返回新写入的像素数
+static long fill_span_masked(Image *img, CoverageMask *cov, int y, int x0, int x1, RGBColor color)
+{
+    int w = cov->area.x1 - cov->area.x0;
+    int ry = y - cov->area.y0;
+    if (cov->row_covered[ry] == w) return 0;
+
+    unsigned char *m = cov->mask + (size_t)ry * w - cov->area.x0;
+    RGBColor *row = img->pixels + (size_t)y * img->width;
+    unsigned char *alpha = img->alpha ? img->alpha + (size_t)y * img->width : NULL;
+    long n = 0;
+    for (int x = x0; x < x1; x++) {
+        if (!m[x]) {
+            m[x] = 1;
+            row[x] = color;
+            if (alpha) alpha[x] = 255;
+            n++;
+        }
+    }
+    cov->row_covered[ry] += n;
+    cov->covered += n;
+    return n;
+}
+
+// 计算图元可能写入的像素范围（与下方光栅化规则严格对应）
+void primitive_compute_bounds(RenderPrimitive *prim)
+{
+    PixelRect *b = &prim->bounds;
+
+    switch (prim->kind) {
+        case PRIM_RECT: {
+            // 左上角向下取整，宽高独立截断
+            int ix = (int)floorf(prim->p[0]), iy = (int)floorf(prim->p[1]);
+            int iw = (int)prim->p[2], ih = (int)prim->p[3];
+            b->x0 = ix;
+            b->y0 = iy;
+            b->x1 = ix + (iw > 0 ? iw : 0);
+            b->y1 = iy + (ih > 0 ? ih : 0);
+            break;
+        }
+        case PRIM_CIRCLE: {
+            int icx = (int)floorf(prim->p[0]), icy = (int)floorf(prim->p[1]);
+            int ir = (int)prim->p[2];
+            if (ir <= 0) {
+                b->x0 = b->y0 = b->x1 = b->y1 = 0;
+                break;
+            }
+            b->x0 = icx - ir;
+            b->y0 = icy - ir;
+            b->x1 = icx + ir + 1;
+            b->y1 = icy + ir + 1;
+            break;
+        }
+        case PRIM_LINE: {
+            int ix1 = (int)floorf(prim->p[0]), iy1 = (int)floorf(prim->p[1]);
+            int ix2 = (int)floorf(prim->p[2]), iy2 = (int)floorf(prim->p[3]);
+            b->x0 = ix1 < ix2 ? ix1 : ix2;
+            b->y0 = iy1 < iy2 ? iy1 : iy2;
+            b->x1 = (ix1 > ix2 ? ix1 : ix2) + 1;
+            b->y1 = (iy1 > iy2 ? iy1 : iy2) + 1;
+            break;
+        }
+        default:
+            b->x0 = b->y0 = b->x1 = b->y1 = 0;
+            break;
+    }
+}
+
+// 圆在第 dy 行的半宽：满足 x*x + dy*dy <= r*r 的最大 x
+static int circle_half_width(int r, int dy)
+{
+    int rem = r * r - dy * dy;
+    int hw = (int)sqrt((double)rem);
+    while ((hw + 1) * (hw + 1) <= rem) hw++;
+    while (hw * hw > rem) hw--;
+    return hw;
+}
+
+// 光栅化模式
+typedef enum {
+    RASTER_WRITE,   // 直接写入
+    RASTER_MASKED,  // 只写入未覆盖像素
+    RASTER_COUNT    // 只统计像素数，不写入
+} RasterMode;
+
+// 向下 / 向上取整的整数除法，b > 0
+static long long floor_div(long long a, long long b)
+{
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static long long ceil_div(long long a, long long b)
+{
+    return -floor_div(-a, b);
+}
+
+// Bresenham 直线，仅处理裁剪区域内的像素
+static long raster_line(Image *img, const RenderPrimitive *prim, const PixelRect *clip,
+                        RasterMode mode, CoverageMask *cov)
+{
+    int ix1 = (int)floorf(prim->p[0]), iy1 = (int)floorf(prim->p[1]);
+    int ix2 = (int)floorf(prim->p[2]), iy2 = (int)floorf(prim->p[3]);
+
+    int dx = abs(ix2 - ix1);
+    int dy = abs(iy2 - iy1);
+    int sx = (ix1 < ix2) ? 1 : -1;
+    int sy = (iy1 < iy2) ? 1 : -1;
+    int err = dx - dy;
+    long n = 0;
+
+    // 直接跳到第一个可能落在裁剪区域内的点。x 为主轴（dx >= dy）时每一步都走 x，
+    // 走了 u 步后 y 方向走了 v(u) = max(0, ceil((2u*dy - dx) / (2dx))) 步，
+    // 误差项为 dx - dy - u*dy + v*dx，和逐步迭代的状态完全相同；y 为主轴时对称。
+    // 长直线只有一小段落在分块或瓦片里时，省掉前面的空转
+    long long need_x = sx > 0 ? (long long)clip->x0 - ix1 : (long long)ix1 - (clip->x1 - 1);
+    long long need_y = sy > 0 ? (long long)clip->y0 - iy1 : (long long)iy1 - (clip->y1 - 1);
+    if (need_x > 0 || need_y > 0) {
+        long long u, v;
+        if (dx >= dy) {
+            u = need_x > 0 ? need_x : 0;
+            if (need_y > 0) {
+                if (dy == 0) return 0;
+                long long uy = floor_div(2LL * dx * need_y - dx, 2LL * dy) + 1;
+                if (uy > u) u = uy;
+            }
+            if (u > dx) return 0;
+            v = dx ? ceil_div(2LL * u * dy - dx, 2LL * dx) : 0;
+            if (v < 0) v = 0;
+        } else {
+            v = need_y > 0 ? need_y : 0;
+            if (need_x > 0) {
+                if (dx == 0) return 0;
+                long long vx = floor_div(2LL * dy * need_x - dy, 2LL * dx) + 1;
+                if (vx > v) v = vx;
+            }
+            if (v > dy) return 0;
+            u = ceil_div(2LL * v * dx - dy, 2LL * dy);
+            if (u < 0) u = 0;
+        }
+        ix1 += (int)(sx * u);
+        iy1 += (int)(sy * v);
+        err = (int)(dx - dy - u * dy + v * dx);
+    }
+
+    while (1) {
+        if (ix1 >= clip->x0 && ix1 < clip->x1 && iy1 >= clip->y0 && iy1 < clip->y1) {
+            if (mode == RASTER_WRITE) {
+                size_t i = (size_t)iy1 * img->width + ix1;
+                img->pixels[i] = prim->color;
+                if (img->alpha) img->alpha[i] = 255;
+            } else if (mode == RASTER_MASKED) {
+                n += fill_span_masked(img, cov, iy1, ix1, ix1 + 1, prim->color);
+            } else {
+                n++;
+            }
+        } else if ((sx > 0 ? ix1 >= clip->x1 : ix1 < clip->x0) ||
+                   (sy > 0 ? iy1 >= clip->y1 : iy1 < clip->y0)) {
+            break; // 坐标单调变化，越过裁剪区域的远端后不会再进入
+        }
+
+        if (ix1 == ix2 && iy1 == iy2) break;
+
+        int e2 = 2 * err;
+        if (e2 > -dy) {
+            err -= dy;
+            ix1 += sx;
+        }
+        if (e2 < dx) {
+            err += dx;
+            iy1 += sy;
+        }
+    }
+    return n;
+}
+
+// 按模式光栅化已裁剪的图元，返回写入（或统计）的像素数
+static long raster_primitive(Image *img, const RenderPrimitive *prim, const PixelRect *r,
+                             RasterMode mode, CoverageMask *cov)
+{
+    long n = 0;
+
+    switch (prim->kind) {
+        case PRIM_RECT:
+            if (mode == RASTER_COUNT) {
+                return (long)(r->x1 - r->x0) * (r->y1 - r->y0);
+            }
+            for (int y = r->y0; y < r->y1; y++) {
+                if (mode == RASTER_MASKED) {
+                    n += fill_span_masked(img, cov, y, r->x0, r->x1, prim->color);
+                } else {
+                    fill_span(img, y, r->x0, r->x1, prim->color);
+                }
+            }
+            break;
+
+        case PRIM_CIRCLE: {
+            int icx = (int)floorf(prim->p[0]), icy = (int)floorf(prim->p[1]);
+            int ir = (int)prim->p[2];
+            for (int y = r->y0; y < r->y1; y++) {
+                int hw = circle_half_width(ir, y - icy);
+                int x0 = icx - hw, x1 = icx + hw + 1;
+                if (x0 < r->x0) x0 = r->x0;
+                if (x1 > r->x1) x1 = r->x1;
+                if (x0 >= x1) continue;
+
+                if (mode == RASTER_MASKED) {
+                    n += fill_span_masked(img, cov, y, x0, x1, prim->color);
+                } else if (mode == RASTER_COUNT) {
+                    n += x1 - x0;
+                } else {
+                    fill_span(img, y, x0, x1, prim->color);
+                }
+            }
+            break;
+        }
+
+        case PRIM_LINE:
+            n = raster_line(img, prim, r, mode, cov);
+            break;
+
+        default:
+            break;
+    }
+    return n;
+}
+
+// 在裁剪区域内绘制图元；clip 为 NULL 时裁剪到整幅图像
+void draw_primitive(Image *img, const RenderPrimitive *prim, const PixelRect *clip)
+{
+    PixelRect full = {0, 0, img->width, img->height};
+    PixelRect area = clip ? rect_intersect(clip, &full) : full;
+    PixelRect r = rect_intersect(&prim->bounds, &area);
+    if (clip_is_empty(&r)) return;
+
+    raster_primitive(img, prim, &r, RASTER_WRITE, NULL);
+}
+
+// 由前向后绘制：只写入 cov 区域内尚未覆盖的像素
+long draw_primitive_front(Image *img, const RenderPrimitive *prim, CoverageMask *cov)
+{
+    PixelRect full = {0, 0, img->width, img->height};
+    PixelRect area = rect_intersect(&cov->area, &full);
+    PixelRect r = rect_intersect(&prim->bounds, &area);
+    if (clip_is_empty(&r)) return 0;
+
+    // 包围盒覆盖的行已全部被遮挡时整体跳过
+    int w = cov->area.x1 - cov->area.x0;
+    int y = r.y0;
+    while (y < r.y1 && cov->row_covered[y - cov->area.y0] == w) y++;
+    if (y == r.y1) return 0;
+
+    return raster_primitive(img, prim, &r, RASTER_MASKED, cov);
+}
+
+// 图元在裁剪区域内会写入的像素数（用于重绘统计）
+long primitive_pixel_count(const RenderPrimitive *prim, const PixelRect *clip)
+{
+    PixelRect r = rect_intersect(&prim->bounds, clip);
+    if (clip_is_empty(&r)) return 0;
+
+    return raster_primitive(NULL, prim, &r, RASTER_COUNT, NULL);
+}
+
+//-------- 背景 --------//
+
+// 最后一个覆盖整幅图像的矩形，在它之前绘制的图元都被完全覆盖；没有时返回 -1
+int find_background_primitive(const RenderPrimitive *prims, int count, int width, int height)
+{
+    for (int i = count - 1; i >= 0; i--) {
+        const RenderPrimitive *p = &prims[i];
+        if (p->kind == PRIM_RECT && p->bounds.x0 <= 0 && p->bounds.y0 <= 0 &&
+            p->bounds.x1 >= width && p->bounds.y1 >= height) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 确定实际背景：有铺满画布的矩形时用它的颜色清屏，并从它之后开始绘制
+RenderBackground resolve_background(const RenderPrimitive *prims, int count, const Image *img,
+                                    const RenderBackground *bg, int *first)
+{
+    RenderBackground out = {{255, 255, 255}, 0};
+    if (bg) out = *bg;
+
+    int k = find_background_primitive(prims, count, img->width, img->height);
+    *first = k + 1;
+    if (k >= 0) {
+        out.color = prims[k].color;
+        out.transparent = 0;
+    }
+    return out;
+}
+
+// 用背景清空区域；透明背景只在图像带 alpha 通道时生效
+void render_clear(Image *img, const PixelRect *area, const RenderBackground *bg)
+{
+    image_fill_rect(img, area->x0, area->y0, area->x1, area->y1, bg->color);
+    if (img->alpha && bg->transparent) {
+        for (int y = area->y0; y < area->y1; y++) {
+            memset(img->alpha + (size_t)y * img->width + area->x0, 0, area->x1 - area->x0);
+        }
+    }
+}
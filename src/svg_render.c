@@ -7,6 +7,11 @@
 
 #include "../include/svg_render.h"
 #include "../include/image.h"
+#include "../include/thread_pool.h"
+#include "../include/log.h"
+
+// 每个并行编译任务处理的形状数
+#define COMPILE_BATCH 4096
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -323,7 +328,7 @@ void apply_transforms_to_point(Transform *transforms, int count, float *x, float
 RGBColor parse_color(const char *color_str) {
     RGBColor color = {0, 0, 0};
     if (color_str[0] == '#') {
-        int r, g, b;
+        int r = 0, g = 0, b = 0;
         if (strlen(color_str) == 7) {
             sscanf(color_str, "#%02x%02x%02x", &r, &g, &b);
         } else if (strlen(color_str) == 4) {
@@ -335,8 +340,8 @@ RGBColor parse_color(const char *color_str) {
         color.b = b;
         
     } else if (strstr(color_str, "rgb(")) {
-        int r, g, b;
-        sscanf(color_str, "rgb(%d,%d,%d)", &r, &g, &b);
+        int r = 0, g = 0, b = 0;
+        sscanf(color_str, "rgb(%d ,%d ,%d", &r, &g, &b);
         color.r = r;
         color.g = g;
         color.b = b;
@@ -395,14 +400,139 @@ char* extract_attribute(const char *line, const char *attr_name) {
     return result;
 }
 
+// 解析 preserveAspectRatio，如 "xMidYMid meet"、"xMinYMax slice"、"none"
+static void parse_aspect_ratio(const char *value, SVGViewport *vp) {
+    const char *p = value;
+    skip_spaces(&p);
+
+    if (strncmp(p, "none", 4) == 0) {
+        vp->align_none = 1;
+        return;
+    }
+
+    static const char *names[] = {"Min", "Mid", "Max"};
+    if (p[0] == 'x' && strlen(p) >= 8 && p[4] == 'Y') {
+        for (int i = 0; i < 3; i++) {
+            if (strncmp(p + 1, names[i], 3) == 0) vp->align_x = (ViewportAlign)i;
+            if (strncmp(p + 5, names[i], 3) == 0) vp->align_y = (ViewportAlign)i;
+        }
+    }
+    vp->slice = strstr(p, "slice") != NULL;
+}
+
+// 解析 <svg> 根元素的视口属性
+static void parse_viewport(const char *tag, SVGViewport *vp) {
+    char *width_val = extract_attribute(tag, "width");
+    char *height_val = extract_attribute(tag, "height");
+    char *viewbox_val = extract_attribute(tag, "viewBox");
+    char *aspect_val = extract_attribute(tag, "preserveAspectRatio");
+
+    // 百分比相对外部容器，这里没有容器，视为未给出
+    if (width_val && !strchr(width_val, '%')) vp->width = atof(width_val);
+    if (height_val && !strchr(height_val, '%')) vp->height = atof(height_val);
+
+    if (viewbox_val) {
+        float v[4];
+        const char *p = viewbox_val;
+        int n = 0;
+        while (n < 4) {
+            char *end;
+            while (*p == ',' || isspace((unsigned char)*p)) p++;
+            v[n] = strtof(p, &end);
+            if (end == p) break;
+            p = end;
+            n++;
+        }
+        // 宽高必须为正，否则按规范忽略 viewBox
+        if (n == 4 && v[2] > 0 && v[3] > 0) {
+            vp->has_viewbox = 1;
+            vp->vb_x = v[0];
+            vp->vb_y = v[1];
+            vp->vb_w = v[2];
+            vp->vb_h = v[3];
+        }
+    }
+
+    if (aspect_val) parse_aspect_ratio(aspect_val, vp);
+
+    free(width_val);
+    free(height_val);
+    free(viewbox_val);
+    free(aspect_val);
+}
+
+void svg_viewport_size(const SVGViewport *vp, float fallback_w, float fallback_h, float *w, float *h) {
+    *w = fallback_w;
+    *h = fallback_h;
+
+    if (vp->width > 0 && vp->height > 0) {
+        *w = vp->width;
+        *h = vp->height;
+    } else if (vp->has_viewbox) {
+        // 只给出一边时按 viewBox 比例补另一边
+        float aspect = vp->vb_w / vp->vb_h;
+        if (vp->width > 0) {
+            *w = vp->width;
+            *h = vp->width / aspect;
+        } else if (vp->height > 0) {
+            *w = vp->height * aspect;
+            *h = vp->height;
+        } else {
+            *w = vp->vb_w;
+            *h = vp->vb_h;
+        }
+    }
+}
+
+DisplayListView svg_viewport_view(const SVGViewport *vp, float doc_w, float doc_h, int out_w, int out_h) {
+    float vx = 0, vy = 0, vw = doc_w, vh = doc_h;
+    if (vp->has_viewbox) {
+        vx = vp->vb_x;
+        vy = vp->vb_y;
+        vw = vp->vb_w;
+        vh = vp->vb_h;
+    }
+
+    DisplayListView view = display_list_view_identity();
+    if (vw <= 0 || vh <= 0) return view;
+
+    float sx = out_w / vw, sy = out_h / vh;
+    float tx = 0, ty = 0;
+
+    if (!vp->align_none) {
+        float s = vp->slice ? fmaxf(sx, sy) : fminf(sx, sy);
+        float free_x = out_w - vw * s, free_y = out_h - vh * s;
+        sx = sy = s;
+        tx = vp->align_x == ALIGN_MIN ? 0 : (vp->align_x == ALIGN_MID ? free_x / 2 : free_x);
+        ty = vp->align_y == ALIGN_MIN ? 0 : (vp->align_y == ALIGN_MID ? free_y / 2 : free_y);
+    }
+
+    view.scale_x = sx;
+    view.scale_y = sy;
+    view.offset_x = tx - vx * sx;
+    view.offset_y = ty - vy * sy;
+    return view;
+}
+
 // 解析 SVG 文件，提取形状信息
 int parse_svg(const char *filename, SVGShape **shapes, int *shape_count) {
+    return parse_svg_ex(filename, shapes, shape_count, NULL);
+}
+
+// 解析 SVG 文件，提取形状信息和根元素视口
+int parse_svg_ex(const char *filename, SVGShape **shapes, int *shape_count, SVGViewport *viewport) {
     FILE *file = fopen(filename, "r");
     if (!file) {
-        printf("无法打开文件: %s\n", filename);
+        LOG_ERROR("无法打开文件: %s", filename);
         return 0;
     }
     
+    if (viewport) {
+        memset(viewport, 0, sizeof(SVGViewport));
+        viewport->align_x = ALIGN_MID;
+        viewport->align_y = ALIGN_MID;
+    }
+
     char line[1024];
     *shape_count = 0;
     int capacity = 10;
@@ -425,6 +555,12 @@ int parse_svg(const char *filename, SVGShape **shapes, int *shape_count) {
         while (*trimmed == ' ' || *trimmed == '\t') trimmed++;
 
 
+        // 根元素 <svg>
+        if (strstr(trimmed, "<svg")) {
+            if (viewport) parse_viewport(trimmed, viewport);
+            continue;
+        }
+
         // 检查分组开始 <g>
         if (strstr(trimmed, "<g")) {
             SVGGroup *new_group = malloc(sizeof(SVGGroup));
@@ -436,7 +572,7 @@ int parse_svg(const char *filename, SVGShape **shapes, int *shape_count) {
             char *transform_val = extract_attribute(trimmed, "transform");
             if (transform_val) {
                 parse_transform(transform_val, &new_group->transforms, &new_group->transform_count);
-                printf("解析分组变换: %d 个变换\n", new_group->transform_count);
+                LOG_TRACE("解析分组变换: %d 个变换", new_group->transform_count);
                 free(transform_val);
             }
             
@@ -602,166 +738,238 @@ int parse_svg(const char *filename, SVGShape **shapes, int *shape_count) {
     }
     
     fclose(file);
+    LOG_DEBUG("解析完成: %d 个形状", *shape_count);
     return 1;
 }
 
 // 绘制线条
 void draw_line(Image *img, float x1, float y1, float x2, float y2, RGBColor color) {
-    int ix1 = (int)x1, iy1 = (int)y1;
-    int ix2 = (int)x2, iy2 = (int)y2;
-    
-    // Bresenham's line algorithm
-    int dx = abs(ix2 - ix1);
-    int dy = abs(iy2 - iy1);
-    int sx = (ix1 < ix2) ? 1 : -1;
-    int sy = (iy1 < iy2) ? 1 : -1;
-    int err = dx - dy;
-    
-    while (1) {
-        set_pixel(img, ix1, iy1, color);
-        
-        if (ix1 == ix2 && iy1 == iy2) break;
-        
-        int e2 = 2 * err;
-        if (e2 > -dy) {
-            err -= dy;
-            ix1 += sx;
-        }
-        if (e2 < dx) {
-            err += dx;
-            iy1 += sy;
-        }
-    }
+    RenderPrimitive prim = {PRIM_LINE, {x1, y1, x2, y2}, color};
+    primitive_compute_bounds(&prim);
+    draw_primitive(img, &prim, NULL);
 }
 
-
 // 绘制矩形
 void draw_rectangle(Image *img, float x, float y, float width, float height, RGBColor color) {
-    // 对于无旋转的矩形，使用简单填充
-    int ix = (int)x, iy = (int)y;
-    int iw = (int)width, ih = (int)height;
-    
-    // 确保坐标在图像范围内
-    if (ix < 0) ix = 0;
-    if (iy < 0) iy = 0;
-    if (ix + iw > img->width) iw = img->width - ix;
-    if (iy + ih > img->height) ih = img->height - iy;
-    
-    // 填充矩形
-    for (int py = iy; py < iy + ih; py++) {
-        for (int px = ix; px < ix + iw; px++) {
-            set_pixel(img, px, py, color);
-        }
-    }
+    RenderPrimitive prim = {PRIM_RECT, {x, y, width, height}, color};
+    primitive_compute_bounds(&prim);
+    draw_primitive(img, &prim, NULL);
 }
 
 // 绘制圆形
 void draw_circle(Image *img, float cx, float cy, float r, RGBColor color) {
-    int icx = (int)cx, icy = (int)cy;
-    int ir = (int)r;
+    RenderPrimitive prim = {PRIM_CIRCLE, {cx, cy, r, 0}, color};
+    primitive_compute_bounds(&prim);
+    draw_primitive(img, &prim, NULL);
+}
 
-    // 确保半径在合理范围内
-    if (ir <= 0) return;
-    
-    for (int y = -ir; y <= ir; y++) {
-        for (int x = -ir; x <= ir; x++) {
-            if (x*x + y*y <= ir*ir) {
-                int px = icx + x;
-                int py = icy + y;
-                if (px >= 0 && px < img->width && py >= 0 && py < img->height) {
-                    set_pixel(img, px, py, color);
+// 把 SVG 形状的变换落到几何上，得到可直接光栅化的图元
+int prepare_shape(SVGShape *shape, RenderPrimitive *prim) {
+    int transformed = shape->group || (shape->transforms && shape->transform_count > 0);
+
+    prim->color = shape->color;
+
+    if (strcmp(shape->type, "rect") == 0) {
+        float x = shape->x, y = shape->y, width = shape->width, height = shape->height;
+
+        // 应用变换到矩形的四个角
+        if (transformed) {
+            // 变换矩形的四个角点
+            float x1 = x, y1 = y;
+            float x2 = x + width, y2 = y;
+            float x3 = x + width, y3 = y + height;
+            float x4 = x, y4 = y + height;
+
+            apply_all_transforms(shape, &x1, &y1);
+            apply_all_transforms(shape, &x2, &y2);
+            apply_all_transforms(shape, &x3, &y3);
+            apply_all_transforms(shape, &x4, &y4);
+
+            // 计算变换后的边界框
+            float min_x = fmin(fmin(x1, x2), fmin(x3, x4));
+            float min_y = fmin(fmin(y1, y2), fmin(y3, y4));
+            float max_x = fmax(fmax(x1, x2), fmax(x3, x4));
+            float max_y = fmax(fmax(y1, y2), fmax(y3, y4));
+
+            x = min_x;
+            y = min_y;
+            width = max_x - min_x;
+            height = max_y - min_y;
+        }
+
+        prim->kind = PRIM_RECT;
+        prim->p[0] = x;
+        prim->p[1] = y;
+        prim->p[2] = width;
+        prim->p[3] = height;
+    } else if (strcmp(shape->type, "circle") == 0) {
+        float cx = shape->cx, cy = shape->cy, r = shape->r;
+
+        // 应用变换
+        if (transformed) {
+            apply_all_transforms(shape, &cx, &cy);
+
+            // 对于缩放变换，调整半径
+            for (int j = 0; j < shape->transform_count; j++) {
+                Transform *t = &shape->transforms[j];
+                if (t->type == TRANSFORM_SCALE) {
+                    r *= (t->x + t->y) / 2.0; // 使用平均缩放因子
                 }
             }
         }
+
+        prim->kind = PRIM_CIRCLE;
+        prim->p[0] = cx;
+        prim->p[1] = cy;
+        prim->p[2] = r;
+        prim->p[3] = 0;
+    } else if (strcmp(shape->type, "line") == 0) {
+        float x1 = shape->x, y1 = shape->y, x2 = shape->x2, y2 = shape->y2;
+
+        // 应用变换
+        if (transformed) {
+            apply_all_transforms(shape, &x1, &y1);
+            apply_all_transforms(shape, &x2, &y2);
+        }
+
+        prim->kind = PRIM_LINE;
+        prim->p[0] = x1;
+        prim->p[1] = y1;
+        prim->p[2] = x2;
+        prim->p[3] = y2;
+    } else {
+        prim->kind = PRIM_NONE;
+        primitive_compute_bounds(prim);
+        return 0;
     }
+
+    primitive_compute_bounds(prim);
+    return 1;
 }
 
-// 渲染 SVG 形状到图像
-void render_svg_to_image(Image *img, SVGShape *shapes, int shape_count) {
-    // 初始化白色背景
+//-------- 背景 --------//
+
+// 解析背景参数：颜色（名称、#RGB、#RRGGBB、rgb()）或 none / transparent
+int render_parse_background(const char *arg, RenderBackground *bg)
+{
     RGBColor white = {255, 255, 255};
-    for (int i = 0; i < img->width * img->height; i++) {
-        img->pixels[i] = white;
+
+    if (strcmp(arg, "none") == 0 || strcmp(arg, "transparent") == 0) {
+        bg->color = white;
+        bg->transparent = 1;
+        return 1;
     }
-    
-    // 绘制所有形状
-    for (int i = 0; i < shape_count; i++) {
-        SVGShape *shape = &shapes[i];
-        
-        //打印调试信息
-        printf("绘制形状 %d: 类型=%s, 颜色=(%d, %d, %d), 变换数量=%d\n", i, shape->type, shape->color.r, shape->color.g, shape->color.b, shape->transform_count);
-        
-        if (strcmp(shape->type, "rect") == 0) {
-            float x = shape->x, y = shape->y, width = shape->width, height = shape->height;
-            
-            // 应用变换到矩形的四个角
-            if (shape->group || (shape->transforms && shape->transform_count > 0)) {
-                
-                // 变换矩形的四个角点
-                float x1 = x, y1 = y;
-                float x2 = x + width, y2 = y;
-                float x3 = x + width, y3 = y + height;
-                float x4 = x, y4 = y + height;
-                
-                apply_all_transforms(shape, &x1, &y1);
-                apply_all_transforms(shape, &x2, &y2);
-                apply_all_transforms(shape, &x3, &y3);
-                apply_all_transforms(shape, &x4, &y4);
-                
-                // 计算变换后的边界框
-                float min_x = fmin(fmin(x1, x2), fmin(x3, x4));
-                float min_y = fmin(fmin(y1, y2), fmin(y3, y4));
-                float max_x = fmax(fmax(x1, x2), fmax(x3, x4));
-                float max_y = fmax(fmax(y1, y2), fmax(y3, y4));
-                
-                x = min_x;
-                y = min_y;
-                width = max_x - min_x;
-                height = max_y - min_y;
-                
-                printf("  变换后矩形: (%.1f,%.1f) w=%.1f h=%.1f\n", x, y, width, height);
-            }
-            
-            draw_rectangle(img, x, y, width, height, shape->color);
-        } else if (strcmp(shape->type, "circle") == 0) {
-            float cx = shape->cx, cy = shape->cy, r = shape->r;
-            
-            // 应用变换
-            if (shape->group || (shape->transforms && shape->transform_count > 0)) {
-                float temp_cx = cx, temp_cy = cy;
-                apply_all_transforms(shape, &temp_cx, &temp_cy);
-                cx = temp_cx;
-                cy = temp_cy;
-                
-                // 对于缩放变换，调整半径
-                for (int j = 0; j < shape->transform_count; j++) {
-                    Transform *t = &shape->transforms[j];
-                    if (t->type == TRANSFORM_SCALE) {
-                        r *= (t->x + t->y) / 2.0; // 使用平均缩放因子
-                    }
-                }
-            }
-            
-            draw_circle(img, cx, cy, r, shape->color);
-        } else if (strcmp(shape->type, "line") == 0) {
-            float x1 = shape->x, y1 = shape->y, x2 = shape->x2, y2 = shape->y2;
-            
-            // 应用变换
-            if (shape->group || (shape->transforms && shape->transform_count > 0)) {
-                float temp_x1 = x1, temp_y1 = y1;
-                float temp_x2 = x2, temp_y2 = y2;
-                
-                apply_all_transforms(shape, &temp_x1, &temp_y1);
-                apply_all_transforms(shape, &temp_x2, &temp_y2);
-                
-                x1 = temp_x1;
-                y1 = temp_y1;
-                x2 = temp_x2;
-                y2 = temp_y2;
-            }
-            
-            draw_line(img, x1, y1, x2, y2, shape->color);
+
+    size_t len = strlen(arg);
+    int valid;
+    if (arg[0] == '#') {
+        valid = (len == 4 || len == 7) && strspn(arg + 1, "0123456789abcdefABCDEF") == len - 1;
+    } else if (strncmp(arg, "rgb(", 4) == 0) {
+        // rgb(r,g,b)，三个分量都要在 0..255 之内
+        int r, g, b;
+        char close = 0;
+        valid = sscanf(arg, "rgb(%d ,%d ,%d %c", &r, &g, &b, &close) == 4 && close == ')' &&
+                r >= 0 && r <= 255 && g >= 0 && g <= 255 && b >= 0 && b <= 255;
+    } else if (strcmp(arg, "black") == 0) {
+        valid = 1;
+    } else {
+        // 颜色名：parse_color 对未知名称返回黑色
+        RGBColor c = parse_color(arg);
+        valid = c.r || c.g || c.b;
+    }
+    if (!valid) return 0;
+
+    bg->color = parse_color(arg);
+    bg->transparent = 0;
+    return 1;
+}
+
+//-------- 显示列表 --------//
+
+typedef struct {
+    SVGShape *shapes;
+    RenderPrimitive *prims;
+    int count;
+} CompileJob;
+
+static void compile_shape(SVGShape *shape, RenderPrimitive *cmd, int index)
+{
+    prepare_shape(shape, cmd);
+
+    LOG_TRACE("绘制形状 %d: 类型=%s, 颜色=(%d, %d, %d), 变换数量=%d", index, shape->type,
+              shape->color.r, shape->color.g, shape->color.b, shape->transform_count);
+    if (cmd->kind == PRIM_RECT && (shape->group || (shape->transforms && shape->transform_count > 0))) {
+        LOG_TRACE("  变换后矩形: (%.1f,%.1f) w=%.1f h=%.1f", cmd->p[0], cmd->p[1], cmd->p[2], cmd->p[3]);
+    }
+}
+
+static void compile_batch(int index, void *ctx)
+{
+    CompileJob *job = (CompileJob *)ctx;
+    int begin = index * COMPILE_BATCH;
+    int end = begin + COMPILE_BATCH < job->count ? begin + COMPILE_BATCH : job->count;
+
+    for (int i = begin; i < end; i++) {
+        compile_shape(&job->shapes[i], &job->prims[i], i);
+    }
+}
+
+// 编译显示列表：变换、颜色和包围盒都只在这里计算一次
+DisplayList *display_list_compile(SVGShape *shapes, int shape_count, float width, float height,
+                                  int threads) {
+    DisplayList *dl = display_list_create(width, height);
+    if (!dl) return NULL;
+
+    dl->cmds = malloc((shape_count > 0 ? shape_count : 1) * sizeof(RenderPrimitive));
+    if (!dl->cmds) {
+        display_list_free(dl);
+        return NULL;
+    }
+    dl->capacity = shape_count > 0 ? shape_count : 1;
+    dl->count = shape_count;
+
+    // 变换计算只读共享分组数据，可以并行
+    if (threads > 1) {
+        CompileJob job = {shapes, dl->cmds, shape_count};
+        parallel_for((shape_count + COMPILE_BATCH - 1) / COMPILE_BATCH, threads, compile_batch, &job);
+    } else {
+        for (int i = 0; i < shape_count; i++) {
+            compile_shape(&shapes[i], &dl->cmds[i], i);
         }
     }
+
+    LOG_DEBUG("显示列表: %d 条命令, 画布 %.0fx%.0f", dl->count, width, height);
+    return dl;
 }
 
+// 渲染 SVG 形状到图像（白色背景）
+void render_svg_to_image(Image *img, SVGShape *shapes, int shape_count) {
+    render_svg_to_image_bg(img, shapes, shape_count, NULL);
+}
+
+// 渲染 SVG 形状到图像，bg 为 NULL 时使用白色背景
+void render_svg_to_image_bg(Image *img, SVGShape *shapes, int shape_count, const RenderBackground *bg) {
+    DisplayList *dl = display_list_compile(shapes, shape_count, img->width, img->height, 1);
+    if (!dl) {
+        LOG_ERROR("渲染内存不足");
+        return;
+    }
+
+    display_list_render(dl, img, NULL, bg);
+    display_list_free(dl);
+}
+
+// 分块并行渲染
+void render_svg_to_image_tiled(Image *img, SVGShape *shapes, int shape_count,
+                               const TileRenderOptions *opts) {
+    int threads = (opts && opts->threads > 0) ? opts->threads : cpu_count();
+
+    DisplayList *dl = display_list_compile(shapes, shape_count, img->width, img->height, threads);
+    if (!dl) {
+        LOG_ERROR("分块渲染内存不足");
+        return;
+    }
+
+    render_display_list_tiled(dl, img, NULL, opts);
+    display_list_free(dl);
+}
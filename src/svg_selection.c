@@ -0,0 +1,294 @@
+#include <stdlib.h>
+#include <string.h>
+#include "../include/svg_selection.h"
+#include "../include/svg_journal.h"
+
+// 每个槽位块对应的位图字数
+#define CHUNK_WORDS (SVG_CHUNK_SIZE / 64)
+
+void shape_edit_apply(SvgShape* shape, const ShapeEdit* edit) {
+    double f = edit->factor;
+    switch (edit->kind) {
+        case SHAPE_EDIT_SCALE:
+            switch (shape->type) {
+                case SVG_SHAPE_CIRCLE: {
+                    SvgCircle* c = &shape->data.circle;
+                    c->cx = edit->cx + (c->cx - edit->cx) * f;
+                    c->cy = edit->cy + (c->cy - edit->cy) * f;
+                    c->r *= f;
+                    break;
+                }
+                case SVG_SHAPE_RECT: {
+                    SvgRect* r = &shape->data.rect;
+                    r->x = edit->cx + (r->x - edit->cx) * f;
+                    r->y = edit->cy + (r->y - edit->cy) * f;
+                    r->width *= f;
+                    r->height *= f;
+                    break;
+                }
+                case SVG_SHAPE_LINE: {
+                    SvgLine* l = &shape->data.line;
+                    l->x1 = edit->cx + (l->x1 - edit->cx) * f;
+                    l->y1 = edit->cy + (l->y1 - edit->cy) * f;
+                    l->x2 = edit->cx + (l->x2 - edit->cx) * f;
+                    l->y2 = edit->cy + (l->y2 - edit->cy) * f;
+                    break;
+                }
+            }
+            break;
+        case SHAPE_EDIT_RECOLOR: {
+            // 三种图形的颜色字段都在各自结构的末尾，分别写入
+            char* color = shape->type == SVG_SHAPE_CIRCLE ? shape->data.circle.fill :
+                          shape->type == SVG_SHAPE_RECT ? shape->data.rect.fill :
+                          shape->data.line.stroke;
+            strncpy(color, edit->color, 15);
+            color[15] = '\0';
+            break;
+        }
+    }
+}
+
+/* ---------- 位图 ---------- */
+
+void selection_init(SvgSelection* sel) {
+    memset(sel, 0, sizeof(*sel));
+}
+
+void selection_free(SvgSelection* sel) {
+    free(sel->bits);
+    memset(sel, 0, sizeof(*sel));
+}
+
+void selection_clear(SvgSelection* sel) {
+    if (sel->hi > sel->lo) memset(sel->bits + sel->lo, 0, (sel->hi - sel->lo) * sizeof(unsigned long long));
+    sel->count = 0;
+    sel->lo = sel->hi = 0;
+}
+
+// 把 word 并入非零字的范围
+static void mark_word(SvgSelection* sel, int word) {
+    if (sel->hi == sel->lo) {
+        sel->lo = word;
+        sel->hi = word + 1;
+    } else if (word < sel->lo) {
+        sel->lo = word;
+    } else if (word >= sel->hi) {
+        sel->hi = word + 1;
+    }
+}
+
+int selection_add(SvgSelection* sel, int slot) {
+    int word = slot >> 6;
+    if (word >= sel->words) {
+        // 按整块对齐增长，批量操作可以整块检查
+        int words = sel->words ? sel->words * 2 : CHUNK_WORDS;
+        while (words <= word) words *= 2;
+        unsigned long long* bits = (unsigned long long*)realloc(sel->bits, words * sizeof(unsigned long long));
+        if (!bits) return 0;
+        memset(bits + sel->words, 0, (words - sel->words) * sizeof(unsigned long long));
+        sel->bits = bits;
+        sel->words = words;
+    }
+    unsigned long long mask = 1ULL << (slot & 63);
+    if (!(sel->bits[word] & mask)) {
+        sel->bits[word] |= mask;
+        sel->count++;
+        mark_word(sel, word);
+    }
+    return 1;
+}
+
+void selection_remove(SvgSelection* sel, int slot) {
+    int word = slot >> 6;
+    if (word >= sel->words) return;
+    unsigned long long mask = 1ULL << (slot & 63);
+    if (sel->bits[word] & mask) {
+        sel->bits[word] &= ~mask;
+        sel->count--;
+    }
+}
+
+int selection_has(const SvgSelection* sel, int slot) {
+    int word = slot >> 6;
+    return word < sel->words && (sel->bits[word] >> (slot & 63)) & 1;
+}
+
+int selection_next(const SvgSelection* sel, int slot) {
+    if (slot < 0) slot = 0;
+    int word = slot >> 6;
+    if (word < sel->lo) {
+        word = sel->lo;
+        slot = word << 6;
+    }
+    if (word >= sel->hi) return -1;
+    unsigned long long bits = sel->bits[word] & (~0ULL << (slot & 63));
+    while (!bits) {
+        if (++word >= sel->hi) return -1;
+        bits = sel->bits[word];
+    }
+    return (word << 6) + __builtin_ctzll(bits);
+}
+
+int selection_add_slots(SvgSelection* sel, const SvgDocument* doc, const int* slots, int count) {
+    int before = sel->count;
+    for (int i = 0; i < count; i++) {
+        if (slots[i] < 0 || slots[i] >= doc->shape_count) continue;
+        if (!svg_shape_alive(svg_document_shape(doc, slots[i]))) continue;
+        if (!selection_add(sel, slots[i])) break;
+    }
+    return sel->count - before;
+}
+
+int selection_select_all(SvgSelection* sel, const SvgDocument* doc) {
+    selection_clear(sel);
+    // 先按最后一个槽位一次性扩容
+    if (doc->shape_count > 0 && !selection_add(sel, doc->shape_count - 1)) return 0;
+    selection_clear(sel);
+    for (int slot = 0; slot < doc->shape_count; slot++) {
+        if (svg_shape_alive(svg_document_shape(doc, slot))) {
+            sel->bits[slot >> 6] |= 1ULL << (slot & 63);
+            sel->count++;
+        }
+    }
+    sel->lo = 0;
+    sel->hi = sel->count > 0 ? ((doc->shape_count - 1) >> 6) + 1 : 0;
+    return sel->count;
+}
+
+void selection_bounds_d(const SvgSelection* sel, const SvgDocument* doc, double box[4]) {
+    box[0] = box[1] = 0;
+    box[2] = box[3] = -1;
+    int first = 1;
+    for (int slot = selection_next(sel, 0); slot >= 0 && slot < doc->shape_count;
+         slot = selection_next(sel, slot + 1)) {
+        const SvgShape* shape = svg_document_shape(doc, slot);
+        if (!svg_shape_alive(shape)) continue;
+        double b[4];
+        svg_shape_bounds_d(shape, b);
+        if (first) {
+            memcpy(box, b, sizeof(b));
+            first = 0;
+            continue;
+        }
+        if (b[0] < box[0]) box[0] = b[0];
+        if (b[1] < box[1]) box[1] = b[1];
+        if (b[2] > box[2]) box[2] = b[2];
+        if (b[3] > box[3]) box[3] = b[3];
+    }
+}
+
+void selection_bounds(const SvgSelection* sel, const SvgDocument* doc, GridBox* box) {
+    double b[4];
+    selection_bounds_d(sel, doc, b);
+    box->x0 = (float)b[0];
+    box->y0 = (float)b[1];
+    box->x1 = (float)b[2];
+    box->y1 = (float)b[3];
+}
+
+/* ---------- 批量操作 ---------- */
+
+// 逐块遍历选中的有效图形：每块只做一次写时复制，visit 返回 0 时中止。
+// 直接跳到下一个选中的槽位，遍历完 count 个后不再扫描余下的位图。
+// 返回访问的图形数，内存不足返回 -1
+typedef int (*ShapeVisitor)(void* ctx, SvgShape* shape, int slot);
+
+static int for_each_selected(SvgDocument* doc, const SvgSelection* sel, ShapeVisitor visit, void* ctx) {
+    int visited = 0, seen = 0;
+    int slot = sel->count > 0 ? selection_next(sel, 0) : -1;
+    while (slot >= 0 && slot < doc->shape_count) {
+        int chunk = slot >> SVG_CHUNK_BITS;
+        int base = chunk << SVG_CHUNK_BITS;
+        int end = base + SVG_CHUNK_SIZE < doc->shape_count ? base + SVG_CHUNK_SIZE : doc->shape_count;
+
+        // 先只读跳过墓碑，块内选中的全是墓碑时不复制这一块
+        const SvgShape* current = svg_document_shape(doc, base);
+        while (slot >= 0 && slot < end && !svg_shape_alive(&current[slot - base])) {
+            slot = ++seen < sel->count ? selection_next(sel, slot + 1) : -1;
+        }
+        if (slot < 0 || slot >= end) continue;
+
+        SvgShape* shapes = svg_document_edit_chunk(doc, chunk);
+        if (!shapes) return -1;
+        for (; slot >= 0 && slot < end; slot = ++seen < sel->count ? selection_next(sel, slot + 1) : -1) {
+            SvgShape* shape = &shapes[slot - base];
+            if (!svg_shape_alive(shape)) continue;
+            if (!visit(ctx, shape, slot)) return -1;
+            visited++;
+        }
+    }
+    return visited;
+}
+
+typedef struct {
+    double dx, dy;
+    const ShapeEdit* edit;
+    int* ids;
+    int* slots;
+    SvgShape* before;
+    int count;
+} BulkState;
+
+static int visit_move(void* ctx, SvgShape* shape, int slot) {
+    BulkState* s = (BulkState*)ctx;
+    (void)slot;
+    svg_shape_translate(shape, s->dx, s->dy);
+    if (s->ids) s->ids[s->count++] = shape->id;
+    return 1;
+}
+
+static int visit_edit(void* ctx, SvgShape* shape, int slot) {
+    BulkState* s = (BulkState*)ctx;
+    (void)slot;
+    if (s->before) s->before[s->count++] = *shape;
+    shape_edit_apply(shape, s->edit);
+    return 1;
+}
+
+static int visit_collect(void* ctx, SvgShape* shape, int slot) {
+    BulkState* s = (BulkState*)ctx;
+    s->ids[s->count] = shape->id;
+    s->slots[s->count++] = slot;
+    return 1;
+}
+
+int selection_move(SvgDocument* doc, const SvgSelection* sel, double dx, double dy,
+                   struct SvgJournal* journal) {
+    BulkState s = {dx, dy, NULL, NULL, NULL, NULL, 0};
+    if (journal && sel->count > 0) {
+        s.ids = (int*)malloc(sel->count * sizeof(int));
+        if (!s.ids) return -1;
+    }
+    int moved = for_each_selected(doc, sel, visit_move, &s);
+    if (moved > 0 && journal) journal_move_many(journal, s.ids, s.count, dx, dy);
+    free(s.ids);
+    return moved;
+}
+
+int selection_edit(SvgDocument* doc, const SvgSelection* sel, const ShapeEdit* edit,
+                   struct SvgJournal* journal) {
+    BulkState s = {0, 0, edit, NULL, NULL, NULL, 0};
+    if (journal && sel->count > 0) {
+        s.before = (SvgShape*)malloc(sel->count * sizeof(SvgShape));
+        if (!s.before) return -1;
+    }
+    int edited = for_each_selected(doc, sel, visit_edit, &s);
+    if (edited > 0 && journal) journal_edit_many(journal, s.before, s.count, edit);
+    free(s.before);
+    return edited;
+}
+
+int selection_delete(SvgDocument* doc, const SvgSelection* sel, struct SvgJournal* journal) {
+    if (sel->count == 0) return 0;
+    BulkState s = {0, 0, NULL, NULL, NULL, NULL, 0};
+    s.ids = (int*)malloc(sel->count * 2 * sizeof(int));
+    if (!s.ids) return -1;
+    s.slots = s.ids + sel->count;
+
+    // 先逐块收集，再按 ID 删除，哈希表随之更新
+    int found = for_each_selected(doc, sel, visit_collect, &s);
+    for (int i = 0; i < s.count; i++) svg_document_remove(doc, s.ids[i]);
+    if (found > 0 && journal) journal_delete_many(journal, s.ids, s.slots, s.count);
+    free(s.ids);
+    return found;
+}
@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <stdatomic.h>
+#include <sys/stat.h>
+
+#include "../include/svg_tile_pyramid.h"
+#include "../include/thread_pool.h"
+#include "../include/jpg_writer.h"
+#include "../include/log.h"
+
+// 每层的瓦片排布，tile_start 为该层第一块在全局编号中的位置
+typedef struct {
+    float scale;            // 文档坐标到该层像素的缩放
+    int tiles_x, tiles_y;
+    long long tile_start;
+} PyramidLevel;
+
+typedef struct {
+    const DisplayList *dl;
+    const DisplayListRect *window;
+    const SpatialGrid *grid;
+    const PyramidOptions *opts;
+    PyramidLevel *levels;
+    int level_count;
+    int tile_size;
+    RenderBackground background;
+    atomic_llong written;
+    atomic_llong empty;
+} PyramidJob;
+
+static double now_seconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int make_dir(const char *path)
+{
+    return mkdir(path, 0755) == 0 || errno == EEXIST;
+}
+
+// 提前建好 out_dir/z/x，渲染线程只写文件
+static int make_level_dirs(const char *out_dir, int z, int tiles_x)
+{
+    char path[4096];
+
+    snprintf(path, sizeof(path), "%s/%d", out_dir, z);
+    if (!make_dir(path)) return 0;
+    for (int x = 0; x < tiles_x; x++) {
+        snprintf(path, sizeof(path), "%s/%d/%d", out_dir, z, x);
+        if (!make_dir(path)) return 0;
+    }
+    return 1;
+}
+
+// 整个窗口的背景：最后一个覆盖整个窗口的矩形，它之前的命令在任何瓦片里都不可见
+static int find_window_background(const DisplayList *dl, const DisplayListRect *window)
+{
+    for (int i = dl->count - 1; i >= 0; i--) {
+        const RenderPrimitive *c = &dl->cmds[i];
+        if (c->kind == PRIM_RECT && c->p[0] <= window->x && c->p[1] <= window->y &&
+            c->p[0] + c->p[2] >= window->x + window->w &&
+            c->p[1] + c->p[3] >= window->y + window->h) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void render_pyramid_tile(int index, void *ctx)
+{
+    PyramidJob *job = (PyramidJob *)ctx;
+    int ts = job->tile_size;
+
+    int z = job->level_count - 1;
+    while (z > 0 && job->levels[z].tile_start > index) z--;
+    const PyramidLevel *level = &job->levels[z];
+    int local = (int)(index - level->tile_start);
+    int tx = local % level->tiles_x, ty = local / level->tiles_x;
+
+    // 与整层画布共用缩放，平移整数个瓦片，相邻瓦片之间没有接缝
+    DisplayListView view;
+    view.scale_x = view.scale_y = level->scale;
+    view.offset_x = -job->window->x * level->scale - (float)tx * ts;
+    view.offset_y = -job->window->y * level->scale - (float)ty * ts;
+
+    DisplayListCull cull;
+    display_list_cull_init(&cull, &view, ts, ts);
+    GridBox query = {cull.x0, cull.y0, cull.x1, cull.y1};
+
+    int *ids = NULL, capacity = 0;
+    int count = spatial_grid_query(job->grid, &query, &ids, &capacity);
+    if (count < 0) {
+        LOG_ERROR("瓦片 %d/%d/%d 内存不足", z, tx, ty);
+        free(ids);
+        return;
+    }
+    if (count == 0) {
+        atomic_fetch_add(&job->empty, 1);
+        free(ids);
+        return;
+    }
+
+    Image *img = create_image(ts, ts);
+    if (!img) {
+        LOG_ERROR("瓦片 %d/%d/%d 内存不足", z, tx, ty);
+        free(ids);
+        return;
+    }
+    display_list_render_ids(job->dl, img, &view, &job->background, ids, count);
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%d/%d/%d.jpg", job->opts->out_dir, z, tx, ty);
+    write_jpg(path, img, job->opts->quality > 0 ? job->opts->quality : 90);
+    atomic_fetch_add(&job->written, 1);
+
+    free_image(img);
+    free(ids);
+}
+
+int export_tile_pyramid(const DisplayList *dl, const DisplayListRect *window,
+                        const PyramidOptions *opts, PyramidStats *stats)
+{
+    int ts = opts->tile_size > 0 ? opts->tile_size : PYRAMID_TILE_SIZE;
+    int threads = opts->threads > 0 ? opts->threads : cpu_count();
+    int level_count = opts->levels > 0 ? opts->levels : 1;
+    double t0 = now_seconds();
+
+    memset(stats, 0, sizeof(PyramidStats));
+    if (window->w <= 0 || window->h <= 0) return 0;
+
+    if (!make_dir(opts->out_dir)) {
+        LOG_ERROR("无法创建目录: %s", opts->out_dir);
+        return 0;
+    }
+
+    PyramidLevel *levels = malloc(level_count * sizeof(PyramidLevel));
+    if (!levels) return 0;
+
+    // 第 z 层长边为 ts * 2^z 像素
+    float longest = window->w > window->h ? window->w : window->h;
+    long long total = 0;
+    for (int z = 0; z < level_count; z++) {
+        PyramidLevel *level = &levels[z];
+        level->scale = (float)ts * (float)(1LL << z) / longest;
+        level->tiles_x = (int)((window->w * level->scale + ts - 1) / ts);
+        level->tiles_y = (int)((window->h * level->scale + ts - 1) / ts);
+        if (level->tiles_x < 1) level->tiles_x = 1;
+        if (level->tiles_y < 1) level->tiles_y = 1;
+        level->tile_start = total;
+        total += (long long)level->tiles_x * level->tiles_y;
+
+        if (!make_level_dirs(opts->out_dir, z, level->tiles_x)) {
+            LOG_ERROR("无法创建目录: %s/%d", opts->out_dir, z);
+            free(levels);
+            return 0;
+        }
+    }
+    if (total > 0x7fffffff) {
+        LOG_ERROR("瓦片数过多: %lld", total);
+        free(levels);
+        return 0;
+    }
+
+    PyramidJob job;
+    job.dl = dl;
+    job.window = window;
+    job.opts = opts;
+    job.levels = levels;
+    job.level_count = level_count;
+    job.tile_size = ts;
+    job.background.color.r = job.background.color.g = job.background.color.b = 255;
+    job.background.transparent = 0;
+    if (opts->background && !opts->background->transparent) {
+        job.background = *opts->background;
+    }
+    atomic_init(&job.written, 0);
+    atomic_init(&job.empty, 0);
+
+    // 覆盖整个窗口的矩形当作背景，只有它之后的命令进入索引，
+    // 查询为空的瓦片就是纯背景，直接跳过
+    int first = find_window_background(dl, window) + 1;
+    if (first > 0) {
+        job.background.color = dl->cmds[first - 1].color;
+    }
+
+    SpatialGrid *grid = display_list_build_index(dl, first, window);
+    if (!grid) {
+        LOG_ERROR("空间索引内存不足");
+        free(levels);
+        return 0;
+    }
+    job.grid = grid;
+    LOG_DEBUG("空间索引: %d 条命令, %dx%d 格", grid->count, grid->cols, grid->rows);
+
+    parallel_for((int)total, threads, render_pyramid_tile, &job);
+
+    stats->tiles = total;
+    stats->written = atomic_load(&job.written);
+    stats->empty = atomic_load(&job.empty);
+    stats->seconds = now_seconds() - t0;
+
+    spatial_grid_free(grid);
+    free(levels);
+    return stats->written + stats->empty == total;
+}
+
+void print_pyramid_stats(const PyramidStats *st)
+{
+    printf("瓦片: %lld, 写出: %lld, 空白跳过: %lld\n", st->tiles, st->written, st->empty);
+    printf("耗时 %.3f s, %.1f 瓦片/秒\n", st->seconds,
+           st->seconds > 0 ? st->tiles / st->seconds : 0.0);
+}
@@ -0,0 +1,327 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "../include/svg_tile_render.h"
+#include "../include/thread_pool.h"
+#include "../include/log.h"
+
+// 分块索引：bin i 的图元编号为 items[offsets[i] .. offsets[i+1])
+typedef struct {
+    int tile_size;
+    int tiles_x, tiles_y;
+    size_t *offsets;
+    int *items;
+} TileBins;
+
+typedef struct {
+    Image *img;
+    const RenderPrimitive *prims;
+    const TileBins *bins;
+    RenderBackground background;
+    int occlusion_cull;
+    unsigned char *pair_drawn;    // 遮挡模式：每个图元-分块对是否写入过像素
+    OcclusionStats *tile_stats;   // 遮挡模式：每个分块一份统计，结束后汇总
+    int stats_enabled;
+} TileJob;
+
+static void resolve_options(const TileRenderOptions *opts, int *tile_size, int *threads)
+{
+    *tile_size = (opts && opts->tile_size > 0) ? opts->tile_size : RENDER_TILE_SIZE;
+    *threads = (opts && opts->threads > 0) ? opts->threads : cpu_count();
+}
+
+// 图元与画布相交后所覆盖的分块范围，不相交时返回 0
+static int primitive_tile_span(const RenderPrimitive *prim, const Image *img, int ts,
+                               int *tx0, int *ty0, int *tx1, int *ty1)
+{
+    const PixelRect *b = &prim->bounds;
+    int x0 = b->x0 > 0 ? b->x0 : 0;
+    int y0 = b->y0 > 0 ? b->y0 : 0;
+    int x1 = b->x1 < img->width ? b->x1 : img->width;
+    int y1 = b->y1 < img->height ? b->y1 : img->height;
+    if (prim->kind == PRIM_NONE || x0 >= x1 || y0 >= y1) return 0;
+
+    *tx0 = x0 / ts;
+    *ty0 = y0 / ts;
+    *tx1 = (x1 - 1) / ts;
+    *ty1 = (y1 - 1) / ts;
+    return 1;
+}
+
+// 两遍计数排序建立分块索引，bin 内保持图元原有顺序
+static int build_bins(TileBins *bins, const Image *img, const RenderPrimitive *prims,
+                      int first, int count, int ts)
+{
+    int tx0, ty0, tx1, ty1;
+
+    bins->tile_size = ts;
+    bins->tiles_x = (img->width + ts - 1) / ts;
+    bins->tiles_y = (img->height + ts - 1) / ts;
+    int tiles = bins->tiles_x * bins->tiles_y;
+
+    bins->offsets = calloc((size_t)tiles + 1, sizeof(size_t));
+    bins->items = NULL;
+    if (!bins->offsets) return 0;
+
+    for (int i = first; i < count; i++) {
+        if (!primitive_tile_span(&prims[i], img, ts, &tx0, &ty0, &tx1, &ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                bins->offsets[ty * bins->tiles_x + tx + 1]++;
+            }
+        }
+    }
+    for (int t = 0; t < tiles; t++) {
+        bins->offsets[t + 1] += bins->offsets[t];
+    }
+
+    size_t *cursor = malloc((size_t)tiles * sizeof(size_t));
+    bins->items = malloc((bins->offsets[tiles] + 1) * sizeof(int));
+    if (!cursor || !bins->items) {
+        free(cursor);
+        free(bins->items);
+        free(bins->offsets);
+        return 0;
+    }
+    memcpy(cursor, bins->offsets, (size_t)tiles * sizeof(size_t));
+
+    for (int i = first; i < count; i++) {
+        if (!primitive_tile_span(&prims[i], img, ts, &tx0, &ty0, &tx1, &ty1)) continue;
+        for (int ty = ty0; ty <= ty1; ty++) {
+            for (int tx = tx0; tx <= tx1; tx++) {
+                bins->items[cursor[ty * bins->tiles_x + tx]++] = i;
+            }
+        }
+    }
+
+    free(cursor);
+    return 1;
+}
+
+static void free_bins(TileBins *bins)
+{
+    free(bins->offsets);
+    free(bins->items);
+}
+
+// 渲染单个分块：先铺背景，再按 z 序绘制落在该分块的图元
+static void render_tile(int index, void *ctx)
+{
+    TileJob *job = (TileJob *)ctx;
+    const TileBins *bins = job->bins;
+    Image *img = job->img;
+    int ts = bins->tile_size;
+
+    PixelRect clip;
+    clip.x0 = (index % bins->tiles_x) * ts;
+    clip.y0 = (index / bins->tiles_x) * ts;
+    clip.x1 = clip.x0 + ts < img->width ? clip.x0 + ts : img->width;
+    clip.y1 = clip.y0 + ts < img->height ? clip.y0 + ts : img->height;
+
+    render_clear(img, &clip, &job->background);
+
+    for (size_t k = bins->offsets[index]; k < bins->offsets[index + 1]; k++) {
+        draw_primitive(img, &job->prims[bins->items[k]], &clip);
+    }
+}
+
+// 由前向后渲染单个分块：覆盖掩码记录已写像素，最后只给未覆盖像素铺背景
+static void render_tile_front(int index, void *ctx)
+{
+    TileJob *job = (TileJob *)ctx;
+    const TileBins *bins = job->bins;
+    Image *img = job->img;
+    int ts = bins->tile_size;
+
+    CoverageMask cov;
+    cov.area.x0 = (index % bins->tiles_x) * ts;
+    cov.area.y0 = (index / bins->tiles_x) * ts;
+    cov.area.x1 = cov.area.x0 + ts < img->width ? cov.area.x0 + ts : img->width;
+    cov.area.y1 = cov.area.y0 + ts < img->height ? cov.area.y0 + ts : img->height;
+    cov.covered = 0;
+
+    int w = cov.area.x1 - cov.area.x0;
+    int h = cov.area.y1 - cov.area.y0;
+    long area = (long)w * h;
+
+    cov.mask = calloc((size_t)area, 1);
+    cov.row_covered = calloc(h, sizeof(int));
+    if (!cov.mask || !cov.row_covered) {
+        // 内存不足时该分块退回普通绘制，统计上视为全部绘制
+        free(cov.mask);
+        free(cov.row_covered);
+        memset(job->pair_drawn + bins->offsets[index], 1,
+               bins->offsets[index + 1] - bins->offsets[index]);
+        render_tile(index, ctx);
+        return;
+    }
+
+    OcclusionStats *st = job->stats_enabled ? &job->tile_stats[index] : NULL;
+
+    for (size_t k = bins->offsets[index + 1]; k-- > bins->offsets[index]; ) {
+        const RenderPrimitive *prim = &job->prims[bins->items[k]];
+        long n = 0;
+
+        if (cov.covered < area) {
+            n = draw_primitive_front(img, prim, &cov);
+        }
+        job->pair_drawn[k] = n > 0;
+
+        if (st) {
+            st->tile_pairs++;
+            st->pixels_written += n;
+            st->pixels_painted += primitive_pixel_count(prim, &cov.area);
+            if (n == 0) st->tile_pairs_skipped++;
+        }
+    }
+
+    // 背景只填充没有被任何图元覆盖的像素
+    if (cov.covered < area) {
+        RGBColor back = job->background.color;
+        unsigned char back_alpha = job->background.transparent ? 0 : 255;
+        for (int y = cov.area.y0; y < cov.area.y1; y++) {
+            const unsigned char *m = cov.mask + (size_t)(y - cov.area.y0) * w;
+            size_t offset = (size_t)y * img->width + cov.area.x0;
+            RGBColor *row = img->pixels + offset;
+            for (int x = 0; x < w; x++) {
+                if (!m[x]) {
+                    row[x] = back;
+                    if (img->alpha) img->alpha[offset + x] = back_alpha;
+                }
+            }
+        }
+    }
+    if (st) {
+        st->pixels_written += area - cov.covered;
+        st->pixels_painted += area;
+    }
+
+    free(cov.mask);
+    free(cov.row_covered);
+}
+
+static void render_tile_dispatch(int index, void *ctx)
+{
+    TileJob *job = (TileJob *)ctx;
+    if (job->occlusion_cull) {
+        render_tile_front(index, ctx);
+    } else {
+        render_tile(index, ctx);
+    }
+}
+
+// 汇总分块统计；一个图元在所有分块都没有写入像素即视为完全被遮挡
+static void collect_stats(OcclusionStats *out, const TileJob *job, int count)
+{
+    const TileBins *bins = job->bins;
+    int tiles = bins->tiles_x * bins->tiles_y;
+
+    memset(out, 0, sizeof(*out));
+    for (int t = 0; t < tiles; t++) {
+        out->tile_pairs += job->tile_stats[t].tile_pairs;
+        out->tile_pairs_skipped += job->tile_stats[t].tile_pairs_skipped;
+        out->pixels_painted += job->tile_stats[t].pixels_painted;
+        out->pixels_written += job->tile_stats[t].pixels_written;
+    }
+
+    // 0: 不与画布相交 1: 被遮挡 2: 可见
+    unsigned char *state = calloc(count > 0 ? count : 1, 1);
+    if (!state) return;
+    for (size_t k = 0; k < bins->offsets[tiles]; k++) {
+        int i = bins->items[k];
+        if (job->pair_drawn[k]) state[i] = 2;
+        else if (state[i] == 0) state[i] = 1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (state[i]) out->shapes++;
+        if (state[i] == 1) out->shapes_occluded++;
+    }
+    free(state);
+}
+
+void print_occlusion_stats(const OcclusionStats *st)
+{
+    long long saved = st->pixels_painted - st->pixels_written;
+
+    printf("遮挡剔除统计:\n");
+    printf("  图元: %d, 完全被遮挡而跳过: %d\n", st->shapes, st->shapes_occluded);
+    printf("  图元-分块对: %lld, 跳过: %lld\n", st->tile_pairs, st->tile_pairs_skipped);
+    printf("  像素写入: %lld, 画家算法: %lld, 减少 %.1f%%\n",
+           st->pixels_written, st->pixels_painted,
+           st->pixels_painted ? 100.0 * saved / st->pixels_painted : 0.0);
+}
+
+void render_primitives_tiled(Image *img, const RenderPrimitive *prims, int count,
+                             const TileRenderOptions *opts)
+{
+    int ts, threads;
+    resolve_options(opts, &ts, &threads);
+
+    // 铺满画布的矩形直接作为背景，它之前的图元不参与分块
+    int first;
+    RenderBackground back = resolve_background(prims, count, img, opts ? opts->background : NULL, &first);
+
+    TileBins bins;
+    if (!build_bins(&bins, img, prims, first, count, ts)) {
+        // 内存不足时退化为整幅图单块渲染
+        PixelRect full = {0, 0, img->width, img->height};
+        render_clear(img, &full, &back);
+        for (int i = first; i < count; i++) {
+            draw_primitive(img, &prims[i], NULL);
+        }
+        return;
+    }
+
+    int tiles = bins.tiles_x * bins.tiles_y;
+    TileJob job = {img, prims, &bins, back, 0, NULL, NULL, 0};
+
+    if (opts && opts->occlusion_cull) {
+        job.pair_drawn = malloc(bins.offsets[tiles] + 1);
+        job.stats_enabled = opts->stats != NULL;
+        if (job.stats_enabled) {
+            job.tile_stats = calloc(tiles, sizeof(OcclusionStats));
+        }
+        job.occlusion_cull = job.pair_drawn && (!job.stats_enabled || job.tile_stats);
+    }
+
+    parallel_for(tiles, threads, render_tile_dispatch, &job);
+
+    if (job.occlusion_cull && job.stats_enabled) {
+        collect_stats(opts->stats, &job, count);
+    }
+
+    free(job.pair_drawn);
+    free(job.tile_stats);
+    free_bins(&bins);
+}
+
+void render_display_list_tiled(const DisplayList *dl, Image *img, const DisplayListView *view,
+                               const TileRenderOptions *opts)
+{
+    if (display_list_view_is_identity(view)) {
+        render_primitives_tiled(img, dl->cmds, dl->count, opts);
+        return;
+    }
+
+    RenderPrimitive *prims = malloc((dl->count > 0 ? dl->count : 1) * sizeof(RenderPrimitive));
+    if (!prims) {
+        LOG_ERROR("分块渲染内存不足");
+        return;
+    }
+
+    // 先按包围盒剔除，只有可见命令参与变换和分块，保持原有顺序
+    DisplayListCull cull;
+    display_list_cull_init(&cull, view, img->width, img->height);
+
+    int count = 0;
+    for (int i = 0; i < dl->count; i++) {
+        if (display_list_cmd_visible(&dl->cmds[i], &cull)) {
+            display_list_transform_cmd(&dl->cmds[i], view, &prims[count++]);
+        }
+    }
+
+    render_primitives_tiled(img, prims, count, opts);
+
+    free(prims);
+}
@@ -0,0 +1,100 @@
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "../include/thread_pool.h"
+
+typedef struct {
+    atomic_int next;     // 下一个待领取的任务
+    int count;
+    ParallelTask task;
+    void *ctx;
+} ParallelJob;
+
+static void run_job(ParallelJob *job)
+{
+    for (;;) {
+        int i = atomic_fetch_add(&job->next, 1);
+        if (i >= job->count) break;
+        job->task(i, job->ctx);
+    }
+}
+
+// 常驻工作线程：第一次需要时创建，之后在条件变量上等待下一个任务
+static struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;     // 发布了新任务
+    pthread_cond_t done;     // 参与任务的工作线程都已退出
+    int workers;             // 已创建的线程数
+    int wanted;              // 当前任务还可以加入的工作线程数
+    int running;             // 正在执行当前任务的工作线程数
+    int busy;                // 有任务在执行
+    ParallelJob job;
+} pool = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER};
+
+static void *worker_main(void *arg)
+{
+    (void)arg;
+    pthread_mutex_lock(&pool.lock);
+    for (;;) {
+        while (pool.wanted == 0) pthread_cond_wait(&pool.wake, &pool.lock);
+        pool.wanted--;
+        pool.running++;
+        pthread_mutex_unlock(&pool.lock);
+
+        run_job(&pool.job);
+
+        pthread_mutex_lock(&pool.lock);
+        if (--pool.running == 0) pthread_cond_signal(&pool.done);
+    }
+    return NULL;
+}
+
+void parallel_for(int count, int threads, ParallelTask task, void *ctx)
+{
+    if (count <= 0) return;
+    if (threads > count) threads = count;
+
+    pthread_mutex_lock(&pool.lock);
+    // 线程池正被占用（例如在任务里再次调用）时在当前线程顺序执行
+    if (threads <= 1 || pool.busy) {
+        pthread_mutex_unlock(&pool.lock);
+        for (int i = 0; i < count; i++) {
+            task(i, ctx);
+        }
+        return;
+    }
+    pool.busy = 1;
+
+    // 当前线程也参与执行，只需 threads - 1 个工作线程，不够时补建
+    while (pool.workers < threads - 1) {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, worker_main, NULL) != 0) break;
+        pthread_detach(tid);
+        pool.workers++;
+    }
+
+    atomic_init(&pool.job.next, 0);
+    pool.job.count = count;
+    pool.job.task = task;
+    pool.job.ctx = ctx;
+    pool.wanted = threads - 1 < pool.workers ? threads - 1 : pool.workers;
+    pthread_cond_broadcast(&pool.wake);
+    pthread_mutex_unlock(&pool.lock);
+
+    run_job(&pool.job);
+
+    // 任务已全部领完：收回没被认领的名额，等已加入的线程做完手上的任务
+    pthread_mutex_lock(&pool.lock);
+    pool.wanted = 0;
+    while (pool.running > 0) pthread_cond_wait(&pool.done, &pool.lock);
+    pool.busy = 0;
+    pthread_mutex_unlock(&pool.lock);
+}
+
+int cpu_count(void)
+{
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+}